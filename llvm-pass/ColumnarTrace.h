@@ -0,0 +1,239 @@
+#ifndef COLUMNAR_TRACE_H
+#define COLUMNAR_TRACE_H
+
+// Layout of the columnar trace (-public-data-trace-format=columnar) and a
+// zero-copy reader over a mapped file. Plain C++17 with no LLVM
+// dependency, so other tools can include it; the pass writes the format
+// with the same BlockLayout, and symex/columnar.py mirrors it.
+//
+// All integers are little-endian. The file is a header followed by one
+// block per function, back to back; every block is self-contained and a
+// multiple of 8 bytes, so blocks concatenate like NDJSON functions.
+//
+//   header: "CTPCOL01", u32 version, u32 header_size,
+//           u32 opcode_count, u32 pred_count, u32 tx_kind_count, u32 0,
+//           then opcode_count + pred_count + tx_kind_count names, each
+//           u32 length + bytes, zero-padded to header_size (a multiple
+//           of 8). Names give the enums below: op values are LLVM opcode
+//           numbers, pred values CmpInst predicates, tx kinds bit numbers.
+//   block:  u64 block_size, u32 flags, u32 rows, u32 uses, u32 txs,
+//           u32 strings, u32 string_bytes, then the sections BlockLayout
+//           lists, each starting 8-aligned. String 0 is the function name;
+//           the other string columns index the block's string table, with
+//           None for null. extra holds any remaining record fields as a
+//           JSON object ({"atomic_op":..}, mem-ssa fields, ...).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace ct_columnar {
+
+inline constexpr char Magic[8] = {'C', 'T', 'P', 'C', 'O', 'L', '0', '1'};
+inline constexpr uint32_t Version = 1;
+inline constexpr uint32_t FileHeaderFixedSize = 32;
+inline constexpr uint32_t BlockHeaderSize = 32;
+inline constexpr uint32_t FlagTypes = 1;  // def_ty/use_ty sections present
+inline constexpr uint32_t None = 0xffffffffu;
+inline constexpr uint8_t NoPred = 0xff;
+
+inline constexpr uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+// Section offsets in a block, relative to its start, from its counts.
+struct BlockLayout {
+  // u32 per row
+  uint64_t pp, bb, inst, def, callee, extra, defTy, txMask;
+  // u32 per row + 1 (offsets into uses/txs)
+  uint64_t useStart, txStart;
+  // u32 per use
+  uint64_t uses, useTy;
+  // i32 per tx
+  uint64_t txWhich;
+  // u8 per row / per tx
+  uint64_t op, pred, txKind, txStatic;
+  // u32 per string + 1, then the bytes
+  uint64_t stringStart, stringBytes;
+  uint64_t size;
+
+  static BlockLayout compute(uint32_t flags, uint32_t rows, uint32_t uses,
+                             uint32_t txs, uint32_t strings,
+                             uint32_t stringBytes) {
+    BlockLayout l{};
+    uint64_t at = BlockHeaderSize;
+    auto take = [&at](uint64_t bytes) {
+      uint64_t start = at;
+      at = align8(at + bytes);
+      return start;
+    };
+    bool types = flags & FlagTypes;
+    l.pp = take(4ull * rows);
+    l.bb = take(4ull * rows);
+    l.inst = take(4ull * rows);
+    l.def = take(4ull * rows);
+    l.callee = take(4ull * rows);
+    l.extra = take(4ull * rows);
+    l.defTy = types ? take(4ull * rows) : 0;
+    l.txMask = take(4ull * rows);
+    l.useStart = take(4ull * (rows + 1ull));
+    l.txStart = take(4ull * (rows + 1ull));
+    l.uses = take(4ull * uses);
+    l.useTy = types ? take(4ull * uses) : 0;
+    l.txWhich = take(4ull * txs);
+    l.op = take(rows);
+    l.pred = take(rows);
+    l.txKind = take(txs);
+    l.txStatic = take(txs);
+    l.stringStart = take(4ull * (strings + 1ull));
+    l.stringBytes = take(stringBytes);
+    l.size = at;
+    return l;
+  }
+};
+
+inline uint32_t readU32(const unsigned char *p) {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 |
+         uint32_t(p[3]) << 24;
+}
+
+inline uint64_t readU64(const unsigned char *p) {
+  return uint64_t(readU32(p)) | uint64_t(readU32(p + 4)) << 32;
+}
+
+// One function's block; accessors read straight from the mapped bytes.
+class Block {
+public:
+  Block() = default;
+  Block(const unsigned char *data, BlockLayout layout)
+      : data(data), layout(layout) {}
+
+  uint32_t flags() const { return readU32(data + 8); }
+  uint32_t rows() const { return readU32(data + 12); }
+  uint32_t stringCount() const { return readU32(data + 24); }
+  std::string_view fn() const { return string(0); }
+
+  std::string_view string(uint32_t id) const {
+    const unsigned char *starts = data + layout.stringStart;
+    uint32_t begin = readU32(starts + 4 * id);
+    uint32_t end = readU32(starts + 4 * (id + 1));
+    return {reinterpret_cast<const char *>(data + layout.stringBytes + begin),
+            end - begin};
+  }
+
+  uint32_t pp(uint32_t row) const { return u32(layout.pp, row); }
+  uint32_t bb(uint32_t row) const { return u32(layout.bb, row); }
+  uint32_t inst(uint32_t row) const { return u32(layout.inst, row); }
+  uint32_t def(uint32_t row) const { return u32(layout.def, row); }
+  uint32_t callee(uint32_t row) const { return u32(layout.callee, row); }
+  uint32_t extra(uint32_t row) const { return u32(layout.extra, row); }
+  uint32_t defTy(uint32_t row) const {
+    return layout.defTy ? u32(layout.defTy, row) : None;
+  }
+  uint32_t txMask(uint32_t row) const { return u32(layout.txMask, row); }
+  uint8_t op(uint32_t row) const { return data[layout.op + row]; }
+  uint8_t pred(uint32_t row) const { return data[layout.pred + row]; }
+
+  // Uses and transmitters of a row are [begin, end) in their sections.
+  uint32_t useBegin(uint32_t row) const { return u32(layout.useStart, row); }
+  uint32_t useEnd(uint32_t row) const { return u32(layout.useStart, row + 1); }
+  uint32_t use(uint32_t i) const { return u32(layout.uses, i); }
+  uint32_t useTy(uint32_t i) const {
+    return layout.useTy ? u32(layout.useTy, i) : None;
+  }
+  uint32_t txBegin(uint32_t row) const { return u32(layout.txStart, row); }
+  uint32_t txEnd(uint32_t row) const { return u32(layout.txStart, row + 1); }
+  uint8_t txKind(uint32_t i) const { return data[layout.txKind + i]; }
+  int32_t txWhich(uint32_t i) const {
+    return static_cast<int32_t>(u32(layout.txWhich, i));
+  }
+  bool txStatic(uint32_t i) const { return data[layout.txStatic + i] != 0; }
+
+private:
+  uint32_t u32(uint64_t section, uint32_t i) const {
+    return readU32(data + section + 4ull * i);
+  }
+
+  const unsigned char *data = nullptr;
+  BlockLayout layout{};
+};
+
+// A whole file in memory (mapped or read). valid() is false, with error()
+// saying why, when the header or a block does not fit the buffer.
+class File {
+public:
+  File(const void *buf, size_t size)
+      : data(static_cast<const unsigned char *>(buf)), size(size) {
+    if (size < FileHeaderFixedSize || std::memcmp(data, Magic, 8) != 0) {
+      err = "not a columnar trace";
+      return;
+    }
+    if (readU32(data + 8) > Version) {
+      err = "columnar trace version is newer than this reader";
+      return;
+    }
+    headerSize = readU32(data + 12);
+    counts[0] = readU32(data + 16);
+    counts[1] = readU32(data + 20);
+    counts[2] = readU32(data + 24);
+    if (headerSize > size || headerSize % 8) {
+      err = "truncated columnar trace header";
+      return;
+    }
+    uint64_t at = FileHeaderFixedSize;
+    for (unsigned table = 0; table < 3 && !err; ++table) {
+      for (uint32_t i = 0; i < counts[table]; ++i) {
+        if (at + 4 > headerSize || at + 4 + readU32(data + at) > headerSize) {
+          err = "truncated columnar trace header";
+          break;
+        }
+        at += 4 + readU32(data + at);
+      }
+    }
+  }
+
+  bool valid() const { return err == nullptr; }
+  const char *error() const { return err; }
+
+  // Enum names: table 0 = opcodes, 1 = predicates, 2 = transmitter kinds.
+  // Empty for an out-of-range value.
+  std::string_view enumName(unsigned table, uint32_t value) const {
+    if (!valid() || table > 2 || value >= counts[table]) return {};
+    uint64_t at = FileHeaderFixedSize;
+    for (unsigned t = 0; t <= table; ++t) {
+      uint32_t n = t == table ? value : counts[t];
+      for (uint32_t i = 0; i < n; ++i) at += 4 + readU32(data + at);
+    }
+    return {reinterpret_cast<const char *>(data + at + 4),
+            readU32(data + at)};
+  }
+
+  // Iterate blocks: offset starts at firstBlock(); next() advances it and
+  // returns false at the end of the file or on a malformed block.
+  uint64_t firstBlock() const { return headerSize; }
+  bool next(uint64_t &offset, Block &block) {
+    if (!valid() || offset + BlockHeaderSize > size) return false;
+    const unsigned char *b = data + offset;
+    uint64_t blockSize = readU64(b);
+    BlockLayout layout = BlockLayout::compute(
+      readU32(b + 8), readU32(b + 12), readU32(b + 16), readU32(b + 20),
+      readU32(b + 24), readU32(b + 28));
+    if (blockSize != layout.size || offset + blockSize > size) {
+      err = "malformed columnar trace block";
+      return false;
+    }
+    block = Block(b, layout);
+    offset += blockSize;
+    return true;
+  }
+
+private:
+  const unsigned char *data;
+  size_t size;
+  uint32_t headerSize = 0;
+  uint32_t counts[3] = {0, 0, 0};
+  const char *err = nullptr;
+};
+
+} // namespace ct_columnar
+
+#endif // COLUMNAR_TRACE_H
@@ -0,0 +1,260 @@
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <string>
+
+// ct-synth: emits synthetic IR whose shape parameters drive path explosion,
+// for scaling runs of the pass (scripts/scaling_benchmarks.sh). Every
+// function takes (ptr %tab, i32 %x, i32 %n); branch conditions derive from
+// %x, so nothing is constant-pruned, and transmitter loads index %tab.
+//
+//   diamonds N    N sequential if/else diamonds (2^N paths)
+//   loops K       K nested counted loops bounded by %n
+//   switch W      one switch with W cases
+//   indirectbr F  an indirectbr with F destinations from a blockaddress table
+//
+// -tx-density D (0..1) makes that fraction of the shape's body blocks load
+// from %tab at an %x-dependent index; the rest only do arithmetic.
+
+using namespace llvm;
+
+namespace {
+
+static cl::opt<std::string> Shape(
+  "shape",
+  cl::desc("diamonds|loops|switch|indirectbr|all"),
+  cl::init("all")
+);
+static cl::opt<unsigned> Size(
+  "size",
+  cl::desc("Shape parameter: diamonds, loop depth, switch cases or "
+           "indirectbr targets"),
+  cl::init(8)
+);
+static cl::opt<double> TxDensity(
+  "tx-density",
+  cl::desc("Fraction of body blocks holding a transmitter load (0..1)"),
+  cl::init(0.5)
+);
+static cl::opt<unsigned> Copies(
+  "copies",
+  cl::desc("Functions emitted per shape"),
+  cl::init(1)
+);
+static cl::opt<std::string> OutPath(
+  "o",
+  cl::desc("Output .ll path (- for stdout)"),
+  cl::init("-")
+);
+
+// Emits one function's body blocks, spreading TxDensity transmitters over
+// them deterministically: block i gets one when round((i+1)*D) > round(i*D).
+class ShapeBuilder {
+public:
+  ShapeBuilder(Function &F)
+      : F(F), B(F.getContext()), i32(B.getInt32Ty()),
+        tab(F.getArg(0)), x(F.getArg(1)), n(F.getArg(2)) {
+    tab->setName("tab");
+    x->setName("x");
+    n->setName("n");
+    B.SetInsertPoint(block("entry"));
+    acc = B.CreateAdd(x, B.getInt32(1), "acc0");
+  }
+
+  BasicBlock *block(const Twine &name) {
+    return BasicBlock::Create(F.getContext(), name, &F);
+  }
+
+  // Body work for the current block; returns the updated accumulator.
+  Value *body(Value *in, unsigned salt) {
+    unsigned before = static_cast<unsigned>(bodyBlocks * TxDensity + 0.5);
+    bodyBlocks++;
+    unsigned after = static_cast<unsigned>(bodyBlocks * TxDensity + 0.5);
+    Value *v = B.CreateMul(in, B.getInt32(2 * salt + 3));
+    if (after > before) {
+      Value *idx = B.CreateAnd(B.CreateXor(v, x), B.getInt32(255));
+      Value *addr = B.CreateGEP(i32, tab, idx);
+      v = B.CreateAdd(v, B.CreateLoad(i32, addr));
+    }
+    return B.CreateXor(v, B.getInt32(salt));
+  }
+
+  void diamonds(unsigned count) {
+    for (unsigned i = 0; i < count; ++i) {
+      BasicBlock *thenBB = block("d" + Twine(i) + ".then");
+      BasicBlock *elseBB = block("d" + Twine(i) + ".else");
+      BasicBlock *joinBB = block("d" + Twine(i) + ".join");
+      Value *bit = B.CreateAnd(B.CreateLShr(x, B.getInt32(i % 32)),
+                               B.getInt32(1));
+      B.CreateCondBr(B.CreateICmpNE(bit, B.getInt32(0)), thenBB, elseBB);
+      B.SetInsertPoint(thenBB);
+      Value *t = body(acc, 2 * i);
+      B.CreateBr(joinBB);
+      BasicBlock *thenEnd = B.GetInsertBlock();
+      B.SetInsertPoint(elseBB);
+      Value *e = body(acc, 2 * i + 1);
+      B.CreateBr(joinBB);
+      BasicBlock *elseEnd = B.GetInsertBlock();
+      B.SetInsertPoint(joinBB);
+      PHINode *phi = B.CreatePHI(i32, 2, "acc" + Twine(i + 1));
+      phi->addIncoming(t, thenEnd);
+      phi->addIncoming(e, elseEnd);
+      acc = phi;
+    }
+  }
+
+  void loops(unsigned depth, unsigned level = 0) {
+    if (level == depth) {
+      acc = body(acc, level);
+      return;
+    }
+    BasicBlock *preheader = B.GetInsertBlock();
+    BasicBlock *header = block("l" + Twine(level) + ".header");
+    BasicBlock *exitBB = block("l" + Twine(level) + ".exit");
+    Value *accIn = acc;
+    B.CreateBr(header);
+    B.SetInsertPoint(header);
+    PHINode *iv = B.CreatePHI(i32, 2, "i" + Twine(level));
+    PHINode *accPhi = B.CreatePHI(i32, 2);
+    iv->addIncoming(B.getInt32(0), preheader);
+    accPhi->addIncoming(accIn, preheader);
+    acc = B.CreateAdd(accPhi, iv);
+    loops(depth, level + 1);
+    Value *next = B.CreateAdd(iv, B.getInt32(1));
+    BasicBlock *latch = B.GetInsertBlock();
+    iv->addIncoming(next, latch);
+    accPhi->addIncoming(acc, latch);
+    B.CreateCondBr(B.CreateICmpSLT(next, n), header, exitBB);
+    B.SetInsertPoint(exitBB);
+    acc = accPhi;
+  }
+
+  void switches(unsigned width) {
+    BasicBlock *joinBB = block("sw.join");
+    BasicBlock *defBB = block("sw.default");
+    SwitchInst *SI = B.CreateSwitch(x, defBB, width);
+    SmallVector<std::pair<Value *, BasicBlock *>, 16> incoming;
+    for (unsigned i = 0; i < width; ++i) {
+      BasicBlock *caseBB = block("sw.case" + Twine(i));
+      SI->addCase(B.getInt32(i), caseBB);
+      B.SetInsertPoint(caseBB);
+      incoming.push_back({body(acc, i), B.GetInsertBlock()});
+      B.CreateBr(joinBB);
+    }
+    B.SetInsertPoint(defBB);
+    incoming.push_back({body(acc, width), B.GetInsertBlock()});
+    B.CreateBr(joinBB);
+    B.SetInsertPoint(joinBB);
+    PHINode *phi = B.CreatePHI(i32, incoming.size(), "sw.acc");
+    for (auto &in : incoming) phi->addIncoming(in.first, in.second);
+    acc = phi;
+  }
+
+  void indirect(unsigned fanout) {
+    Module &M = *F.getParent();
+    BasicBlock *joinBB = block("ib.join");
+    SmallVector<BasicBlock *, 16> targets;
+    SmallVector<Constant *, 16> addrs;
+    for (unsigned i = 0; i < fanout; ++i) {
+      targets.push_back(block("ib.target" + Twine(i)));
+      addrs.push_back(BlockAddress::get(&F, targets.back()));
+    }
+    ArrayType *tableTy = ArrayType::get(addrs[0]->getType(), fanout);
+    auto *table = new GlobalVariable(
+      M, tableTy, true, GlobalValue::PrivateLinkage,
+      ConstantArray::get(tableTy, addrs), F.getName() + ".targets");
+    Value *idx = B.CreateURem(x, B.getInt32(fanout));
+    Value *slot = B.CreateGEP(tableTy, table, {B.getInt32(0), idx});
+    Value *dest = B.CreateLoad(addrs[0]->getType(), slot);
+    IndirectBrInst *IB = B.CreateIndirectBr(dest, fanout);
+    SmallVector<std::pair<Value *, BasicBlock *>, 16> incoming;
+    for (unsigned i = 0; i < fanout; ++i) {
+      IB->addDestination(targets[i]);
+      B.SetInsertPoint(targets[i]);
+      incoming.push_back({body(acc, i), B.GetInsertBlock()});
+      B.CreateBr(joinBB);
+    }
+    B.SetInsertPoint(joinBB);
+    PHINode *phi = B.CreatePHI(i32, incoming.size(), "ib.acc");
+    for (auto &in : incoming) phi->addIncoming(in.first, in.second);
+    acc = phi;
+  }
+
+  void finish() { B.CreateRet(acc); }
+
+private:
+  Function &F;
+  IRBuilder<> B;
+  Type *i32;
+  Value *tab;
+  Value *x;
+  Value *n;
+  Value *acc = nullptr;
+  unsigned bodyBlocks = 0;
+};
+
+static void emitShape(Module &M, StringRef shape, unsigned size,
+                      unsigned copy) {
+  LLVMContext &Ctx = M.getContext();
+  Type *i32 = Type::getInt32Ty(Ctx);
+  FunctionType *FT =
+    FunctionType::get(i32, {PointerType::getUnqual(i32), i32, i32}, false);
+  std::string name = (shape + "_" + Twine(size) + "_" + Twine(copy)).str();
+  Function *F = Function::Create(FT, GlobalValue::ExternalLinkage, name, M);
+  ShapeBuilder SB(*F);
+  if (shape == "diamonds") SB.diamonds(size);
+  else if (shape == "loops") SB.loops(size);
+  else if (shape == "switch") SB.switches(size);
+  else SB.indirect(size);
+  SB.finish();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv,
+                              "ct-synth: synthetic scaling corpus\n");
+  SmallVector<StringRef, 4> shapes;
+  if (Shape == "all") {
+    shapes = {"diamonds", "loops", "switch", "indirectbr"};
+  } else if (Shape == "diamonds" || Shape == "loops" || Shape == "switch" ||
+             Shape == "indirectbr") {
+    shapes.push_back(Shape);
+  } else {
+    errs() << "Unknown -shape: " << Shape << "\n";
+    return 1;
+  }
+  if (Size == 0 || TxDensity < 0 || TxDensity > 1) {
+    errs() << "ct-synth: -size must be positive and -tx-density in [0,1]\n";
+    return 1;
+  }
+
+  LLVMContext Ctx;
+  Module M("ct-synth", Ctx);
+  for (StringRef shape : shapes) {
+    for (unsigned c = 0; c < Copies; ++c) emitShape(M, shape, Size, c);
+  }
+  if (verifyModule(M, &errs())) return 1;
+
+  std::error_code ec;
+  raw_fd_ostream os(OutPath, ec, sys::fs::OF_Text);
+  if (ec) {
+    errs() << "Failed to open output file: " << ec.message() << "\n";
+    return 1;
+  }
+  M.print(os, nullptr);
+  return 0;
+}
@@ -0,0 +1,661 @@
+#include "PublicDataPass.h"
+#include "ColumnarTrace.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#endif
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// ct-trace: runs the public-data passes over many .ll/.bc inputs in one
+// process. Inputs are parsed on a thread pool ahead of the pass, which runs
+// on one module at a time in input order, so output matches one opt run
+// per input. Every -public-data-* option applies; "{}" in the output paths
+// expands to each input's stem (file name without extension).
+//
+// With -serve, the inputs stay parsed and NDJSON requests on stdin are
+// answered on stdout with records in the trace/CFG schemas (see README.md),
+// so consumers can pull more paths or trace slices without re-running opt.
+// -dump-columnar prints a -public-data-trace-format=columnar file as the
+// NDJSON trace records it stands for.
+
+using namespace llvm;
+
+namespace {
+
+static cl::list<std::string> Inputs(
+  cl::Positional,
+  cl::desc("<input .ll/.bc files>"),
+  cl::ZeroOrMore
+);
+static cl::opt<std::string> BenchList(
+  "bench-list",
+  cl::desc("Also read inputs from this file, one per line ('#' comments), "
+           "relative to -bench-root"),
+  cl::init("")
+);
+static cl::opt<std::string> BenchRoot(
+  "bench-root",
+  cl::desc("Directory -bench-list entries are relative to (default: the "
+           "list's directory)"),
+  cl::init("")
+);
+static cl::opt<std::string> Passes(
+  "passes",
+  cl::desc("Pass pipeline to run on each input"),
+  cl::init("public-data-module")
+);
+static cl::opt<unsigned> ParseThreads(
+  "parse-threads",
+  cl::desc("Threads parsing inputs ahead of the pass (0 = all cores)"),
+  cl::init(0)
+);
+static cl::opt<unsigned> Repeat(
+  "repeat",
+  cl::desc("Run the pipeline this many times per input (for timing)"),
+  cl::init(1)
+);
+static cl::opt<std::string> RunSummaryOut(
+  "run-summary",
+  cl::desc("Write a run_summary record per input to this path ('{}' = stem)"),
+  cl::init("")
+);
+static cl::opt<std::string> DumpColumnar(
+  "dump-columnar",
+  cl::desc("Print this columnar trace file as NDJSON trace records and exit"),
+  cl::init("")
+);
+static cl::opt<bool> Serve(
+  "serve",
+  cl::desc("Keep the inputs parsed and answer NDJSON requests on stdin on "
+           "stdout instead of writing the output files"),
+  cl::init(false)
+);
+
+// Print a columnar trace's records as the NDJSON format writes them (the
+// extra fields ride after txs, where their instructions put them).
+static int dumpColumnar(StringRef path) {
+  auto buf = MemoryBuffer::getFile(path, /*IsText=*/false,
+                                   /*RequiresNullTerminator=*/false);
+  if (!buf) {
+    errs() << "ct-trace: cannot read " << path << "\n";
+    return 1;
+  }
+  ct_columnar::File file((*buf)->getBufferStart(), (*buf)->getBufferSize());
+  if (!file.valid()) {
+    errs() << "ct-trace: " << path << ": " << file.error() << "\n";
+    return 1;
+  }
+  raw_ostream &os = outs();
+  auto str = [&](std::string_view s) {
+    os << json::Value(StringRef(s.data(), s.size()));
+  };
+  os << "{\"kind\":\"schema\",\"stream\":\"trace\",\"version\":1}\n";
+  uint64_t offset = file.firstBlock();
+  ct_columnar::Block block;
+  while (file.next(offset, block)) {
+    std::string_view fn = block.fn();
+    bool types = block.flags() & ct_columnar::FlagTypes;
+    for (uint32_t row = 0; row < block.rows(); ++row) {
+      std::string_view bb = block.string(block.bb(row));
+      os << "{\"fn\":";
+      str(fn);
+      os << ",\"bb\":";
+      str(bb);
+      os << ",\"pp\":";
+      str((Twine(StringRef(fn.data(), fn.size())) + ":" +
+           StringRef(bb.data(), bb.size()) + ":i" + Twine(block.inst(row)))
+            .str());
+      os << ",\"op\":";
+      str(file.enumName(0, block.op(row)));
+      auto optional = [&](uint32_t id) {
+        if (id == ct_columnar::None) os << "null";
+        else str(block.string(id));
+      };
+      os << ",\"def\":";
+      optional(block.def(row));
+      os << ",\"uses\":[";
+      for (uint32_t i = block.useBegin(row); i < block.useEnd(row); ++i) {
+        if (i != block.useBegin(row)) os << ",";
+        str(block.string(block.use(i)));
+      }
+      os << "]";
+      if (types) {
+        os << ",\"def_ty\":";
+        optional(block.defTy(row));
+        os << ",\"use_tys\":[";
+        for (uint32_t i = block.useBegin(row); i < block.useEnd(row); ++i) {
+          if (i != block.useBegin(row)) os << ",";
+          str(block.string(block.useTy(i)));
+        }
+        os << "]";
+      }
+      if (block.pred(row) != ct_columnar::NoPred) {
+        os << (block.pred(row) < 32 ? ",\"fcmp_pred\":" : ",\"icmp_pred\":");
+        str(file.enumName(1, block.pred(row)));
+      }
+      if (block.callee(row) != ct_columnar::None) {
+        os << ",\"callee\":";
+        str(block.string(block.callee(row)));
+      }
+      std::string_view extra;
+      if (block.extra(row) != ct_columnar::None) {
+        extra = block.string(block.extra(row));
+        extra = extra.substr(1, extra.size() - 2);
+      }
+      uint32_t txBegin = block.txBegin(row), txEnd = block.txEnd(row);
+      auto tx = [&](uint32_t i) {
+        os << "{\"kind\":";
+        str(file.enumName(2, block.txKind(i)));
+        os << ",\"which\":" << block.txWhich(i);
+        if (block.txStatic(i)) os << ",\"static\":\"equal\"";
+        os << "}";
+      };
+      if (txBegin != txEnd) {
+        os << ",\"txs\":[";
+        for (uint32_t i = txBegin; i < txEnd; ++i) {
+          if (i != txBegin) os << ",";
+          tx(i);
+        }
+        os << "],\"tx\":";
+        tx(txBegin);
+      }
+      if (!extra.empty()) os << "," << StringRef(extra.data(), extra.size());
+      os << "}\n";
+    }
+  }
+  if (!file.valid()) {
+    errs() << "ct-trace: " << path << ": " << file.error() << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+// One input and, once its parse job has run, its module.
+struct Input {
+  std::string path;
+  std::string stem;
+  std::unique_ptr<LLVMContext> ctx;
+  std::unique_ptr<Module> module;
+  SMDiagnostic err;
+};
+
+// Collect the inputs: positional arguments, then -bench-list entries.
+// .c sources are skipped (compile them to .ll first, as gen_traces.sh does).
+static bool collectInputs(std::vector<Input> &out) {
+  std::vector<std::string> paths(Inputs.begin(), Inputs.end());
+  if (!BenchList.empty()) {
+    auto buf = MemoryBuffer::getFile(BenchList);
+    if (!buf) {
+      errs() << "Bench list not found: " << BenchList << "\n";
+      return false;
+    }
+    SmallString<256> root(BenchRoot);
+    if (root.empty()) root = sys::path::parent_path(BenchList);
+    SmallVector<StringRef, 64> lines;
+    (*buf)->getBuffer().split(lines, '\n', -1, false);
+    for (StringRef line : lines) {
+      line = line.trim();
+      if (line.empty() || line.startswith("#")) continue;
+      SmallString<256> path(root);
+      sys::path::append(path, line);
+      paths.push_back(std::string(path));
+    }
+  }
+  StringSet<> stems;
+  for (const std::string &path : paths) {
+    StringRef ext = sys::path::extension(path);
+    if (ext != ".ll" && ext != ".bc") {
+      errs() << "Skipping unsupported source type: " << path << "\n";
+      continue;
+    }
+    Input in;
+    in.path = path;
+    in.stem = sys::path::stem(path).str();
+    if (!stems.insert(in.stem).second) {
+      errs() << "Duplicate input stem " << in.stem << " (" << path
+             << "); its outputs overwrite the earlier input's\n";
+    }
+    out.push_back(std::move(in));
+  }
+  return true;
+}
+
+// Peak resident set of this process in KiB, or -1 where unavailable. The
+// peak covers every input so far, so scaling runs use one input per process.
+static int64_t maxRssKb() {
+#ifdef LLVM_ON_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+  return -1;
+}
+
+// A pass builder with the plugin's passes and registered analysis
+// managers.
+struct Analyses {
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PassBuilder PB;
+
+  Analyses() {
+    llvmGetPassPluginInfo().RegisterPassBuilderCallbacks(PB);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+  }
+};
+
+// Run the pipeline once over M with fresh analysis managers, so repeated
+// runs are timed without cached analyses.
+static bool runPipeline(Module &M) {
+  Analyses A;
+  ModulePassManager MPM;
+  if (Error err = A.PB.parsePassPipeline(MPM, Passes)) {
+    errs() << "ct-trace: " << toString(std::move(err)) << "\n";
+    return false;
+  }
+  MPM.run(M, A.MAM);
+  return true;
+}
+
+// -serve: one JSON request per stdin line, e.g.
+//   {"id":1,"op":"paths","fn":"foo","start":200,"count":100}
+// answered by its records and then a server_done record (server_error on
+// a bad request). Each module keeps its analysis managers, so LLVM
+// analyses are computed once per function, and the CFG records of the
+// widest "paths" render per function and limits are kept to answer later
+// ranges within it.
+class Server {
+public:
+  explicit Server(std::vector<Input> &inputs) : inputs(inputs) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      analyses.push_back(std::make_unique<Analyses>());
+    }
+  }
+
+  int run() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+      if (StringRef(line).trim().empty()) continue;
+      Expected<json::Value> parsed = json::parse(line);
+      if (!parsed) {
+        fail(nullptr, toString(parsed.takeError()));
+        continue;
+      }
+      const json::Object *req = parsed->getAsObject();
+      if (!req) {
+        fail(nullptr, "request is not an object");
+        continue;
+      }
+      auto op = req->getString("op");
+      if (!op) {
+        fail(req, "missing \"op\"");
+      } else if (*op == "quit") {
+        done(req, 0);
+        return 0;
+      } else if (*op == "functions") {
+        functions(*req);
+      } else if (*op == "paths" || *op == "enumerate" || *op == "slice") {
+        size_t module = 0;
+        Function *F = findFunction(*req, module);
+        if (!F) continue;
+        if (*op == "paths") paths(*req, *F, module);
+        else if (*op == "enumerate") enumerate(*req, *F, module);
+        else slice(*req, *F, module);
+      } else {
+        fail(req, ("unknown op: " + *op).str());
+      }
+    }
+    return 0;
+  }
+
+private:
+  // One function's CFG records under some limits, split into lines.
+  struct Rendered {
+    std::string text;
+    std::vector<StringRef> lines;
+    std::vector<std::string> kinds;
+    std::vector<int64_t> pathIds;  // -1 for records without a path_id
+    int64_t lastPathId = -1;
+    unsigned maxPaths = 0;
+    bool truncated = false;
+  };
+
+  std::vector<Input> &inputs;
+  std::vector<std::unique_ptr<Analyses>> analyses;
+  std::map<std::tuple<const Function *, int64_t, int64_t>, Rendered> widest;
+
+  static void endRecord(const json::Object *req) {
+    if (req) {
+      if (const json::Value *id = req->get("id")) outs() << ",\"id\":" << *id;
+    }
+    outs() << "}\n";
+  }
+
+  void done(const json::Object *req, size_t records, bool more = false) {
+    outs() << "{\"kind\":\"server_done\"";
+    if (req) {
+      auto op = req->getString("op");
+      if (op) outs() << ",\"op\":" << json::Value(*op);
+    }
+    outs() << ",\"records\":" << records;
+    if (more) outs() << ",\"more\":true";
+    endRecord(req);
+    outs().flush();
+  }
+
+  void fail(const json::Object *req, const std::string &error) {
+    outs() << "{\"kind\":\"server_error\",\"error\":" << json::Value(error);
+    endRecord(req);
+    outs().flush();
+  }
+
+  // Non-negative integer field, or dflt when absent; -2 when malformed.
+  static int64_t field(const json::Object &req, StringRef name,
+                       int64_t dflt = -1) {
+    const json::Value *v = req.get(name);
+    if (!v) return dflt;
+    auto n = v->getAsInteger();
+    return n && *n >= 0 ? *n : -2;
+  }
+
+  // The request's fn, in its "module" (input stem) or else the first
+  // input defining it.
+  Function *findFunction(const json::Object &req, size_t &module) {
+    auto fn = req.getString("fn");
+    if (!fn) {
+      fail(&req, "missing \"fn\"");
+      return nullptr;
+    }
+    auto stem = req.getString("module");
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (stem && inputs[i].stem != *stem) continue;
+      Function *F = inputs[i].module->getFunction(*fn);
+      if (F && !F->isDeclaration()) {
+        module = i;
+        return F;
+      }
+    }
+    fail(&req, ("no defined function " + *fn).str());
+    return nullptr;
+  }
+
+  bool limits(const json::Object &req, PublicDataLimits &out) {
+    out.maxPaths = field(req, "max_paths");
+    out.maxPathDepth = field(req, "max_path_depth");
+    out.maxLoopIters = field(req, "max_loop_iters");
+    if (out.maxPaths == -2 || out.maxPathDepth == -2 ||
+        out.maxLoopIters == -2) {
+      fail(&req, "limits must be non-negative integers");
+      return false;
+    }
+    return true;
+  }
+
+  void functions(const json::Object &req) {
+    size_t records = 0;
+    for (const Input &in : inputs) {
+      for (const Function &F : *in.module) {
+        if (F.isDeclaration()) continue;
+        outs() << "{\"kind\":\"server_fn\",\"module\":"
+               << json::Value(in.stem) << ",\"fn\":"
+               << json::Value(F.getName()) << ",\"inst_count\":"
+               << F.getInstructionCount() << "}\n";
+        records++;
+      }
+    }
+    done(&req, records);
+  }
+
+  static void split(Rendered &r) {
+    SmallVector<StringRef, 64> lines;
+    StringRef(r.text).split(lines, '\n', -1, false);
+    for (StringRef line : lines) {
+      std::string kind;
+      int64_t pathId = -1;
+      if (Expected<json::Value> v = json::parse(line)) {
+        if (const json::Object *rec = v->getAsObject()) {
+          if (auto k = rec->getString("kind")) kind = k->str();
+          if (auto id = rec->getInteger("path_id")) pathId = *id;
+          auto truncated = rec->getBoolean("truncated");
+          if (kind == "path_summary" && truncated) r.truncated = *truncated;
+        }
+      } else {
+        consumeError(v.takeError());
+      }
+      if (kind == "path") r.lastPathId = std::max(r.lastPathId, pathId);
+      r.lines.push_back(line);
+      r.kinds.push_back(std::move(kind));
+      r.pathIds.push_back(pathId);
+    }
+  }
+
+  // "paths": path records start..start+count-1 in emission order, with the
+  // cond, path_node, region and segment records they refer to and the
+  // path_summary of the render. The path limit is start+count, so ranges
+  // of one function share a prefix of the same enumeration.
+  void paths(const json::Object &req, Function &F, size_t module) {
+    PublicDataLimits lim;
+    if (!limits(req, lim)) return;
+    int64_t start = field(req, "start", 0);
+    int64_t count = field(req, "count", 0);
+    if (start < 0 || count <= 0) {
+      fail(&req, "paths needs \"count\" > 0 and \"start\" >= 0");
+      return;
+    }
+    unsigned need = unsigned(start + count);
+    Rendered &r = widest[{&F, lim.maxPathDepth, lim.maxLoopIters}];
+    if (r.lines.empty() || (r.truncated && r.maxPaths < need)) {
+      r = Rendered();
+      lim.maxPaths = need;
+      r.maxPaths = need;
+      renderPublicDataFunction(F, analyses[module]->FAM, lim, nullptr,
+                               &r.text);
+      split(r);
+    }
+    size_t records = 0;
+    int64_t end = start + count;
+    for (size_t i = 0; i < r.lines.size(); ++i) {
+      const std::string &kind = r.kinds[i];
+      if (kind == "path") {
+        if (r.pathIds[i] < start || r.pathIds[i] >= end) continue;
+      } else if (kind != "cond" && kind != "path_node" && kind != "region" &&
+                 kind != "segment" && kind != "path_summary" &&
+                 kind != "symtab") {
+        continue;
+      }
+      outs() << r.lines[i] << "\n";
+      records++;
+    }
+    done(&req, records, r.truncated || r.lastPathId >= end);
+  }
+
+  // "enumerate": every CFG record for fn under the request's limits.
+  void enumerate(const json::Object &req, Function &F, size_t module) {
+    PublicDataLimits lim;
+    if (!limits(req, lim)) return;
+    Rendered r;
+    renderPublicDataFunction(F, analyses[module]->FAM, lim, nullptr, &r.text);
+    split(r);
+    for (StringRef line : r.lines) outs() << line << "\n";
+    done(&req, r.lines.size(), r.truncated);
+  }
+
+  // "slice": the trace records of the given pps (names as in an
+  // un-interned trace), plus the symtab a -public-data-intern-ids trace
+  // needs to decode them.
+  void slice(const json::Object &req, Function &F, size_t module) {
+    const json::Array *pps = req.getArray("pps");
+    if (!pps) {
+      fail(&req, "slice needs a \"pps\" array");
+      return;
+    }
+    StringSet<> wanted;
+    for (const json::Value &pp : *pps) {
+      if (auto s = pp.getAsString()) wanted.insert(*s);
+    }
+    std::string text;
+    renderPublicDataFunction(F, analyses[module]->FAM, PublicDataLimits(),
+                             &text, nullptr);
+    SmallVector<StringRef, 64> lines;
+    StringRef(text).split(lines, '\n', -1, false);
+    std::vector<std::string> symtab;
+    size_t records = 0;
+    for (StringRef line : lines) {
+      Expected<json::Value> v = json::parse(line);
+      if (!v) {
+        consumeError(v.takeError());
+        continue;
+      }
+      const json::Object *rec = v->getAsObject();
+      if (!rec) continue;
+      auto kind = rec->getString("kind");
+      if (kind && *kind == "symtab") {
+        if (const json::Array *names = rec->getArray("pps")) {
+          for (const json::Value &name : *names) {
+            auto s = name.getAsString();
+            symtab.push_back(s ? s->str() : std::string());
+          }
+        }
+        outs() << line << "\n";
+        records++;
+        continue;
+      }
+      const json::Value *pp = rec->get("pp");
+      if (!pp) continue;
+      std::string name;
+      if (auto s = pp->getAsString()) {
+        name = s->str();
+      } else if (auto id = pp->getAsInteger()) {
+        if (*id >= 0 && size_t(*id) < symtab.size()) name = symtab[*id];
+      }
+      if (!wanted.contains(name)) continue;
+      outs() << line << "\n";
+      records++;
+    }
+    done(&req, records);
+  }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(
+    argc, argv,
+    "ct-trace: emit public-data trace/CFG artifacts for many modules\n");
+  if (!DumpColumnar.empty()) return dumpColumnar(DumpColumnar);
+
+  std::vector<Input> inputs;
+  if (!collectInputs(inputs)) return 1;
+  if (inputs.empty()) {
+    errs() << "ct-trace: no inputs\n";
+    return 1;
+  }
+  if (inputs.size() > 1 && !Serve && !publicDataOutputsPerInput()) {
+    errs() << "ct-trace: with several inputs every output path needs a '{}' "
+              "for the input stem\n";
+    return 1;
+  }
+
+  // Parse at most one module per thread ahead of the pass so memory stays
+  // bounded on long bench lists.
+  ThreadPool pool(hardware_concurrency(ParseThreads));
+  size_t window = std::max(1u, pool.getThreadCount());
+  std::vector<std::shared_future<void>> parsed(inputs.size());
+  auto submit = [&](size_t i) {
+    if (i >= inputs.size()) return;
+    parsed[i] = pool.async([&inputs, i]() {
+      Input &in = inputs[i];
+      in.ctx = std::make_unique<LLVMContext>();
+      in.module = parseIRFile(in.path, in.err, *in.ctx);
+    });
+  };
+  if (Serve) {
+    // Serving needs every module at once.
+    for (size_t i = 0; i < inputs.size(); ++i) submit(i);
+    int status = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      parsed[i].wait();
+      if (!inputs[i].module) {
+        inputs[i].err.print("ct-trace", errs());
+        status = 1;
+      }
+    }
+    if (status) return status;
+    return Server(inputs).run();
+  }
+  for (size_t i = 0; i < window; ++i) submit(i);
+
+  int status = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    parsed[i].wait();
+    Input &in = inputs[i];
+    if (!in.module) {
+      in.err.print("ct-trace", errs());
+      status = 1;
+    } else {
+      setPublicDataOutputStem(in.stem);
+      std::vector<uint64_t> elapsedMs;
+      for (unsigned r = 0; r < std::max(1u, unsigned(Repeat)); ++r) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = runPipeline(*in.module);
+        closePublicDataOutputs();
+        if (!ok) return 1;
+        elapsedMs.push_back(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+      }
+      if (!RunSummaryOut.empty()) {
+        std::error_code ec;
+        raw_fd_ostream os(publicDataOutputPath(RunSummaryOut), ec,
+                          sys::fs::OF_Text);
+        if (ec) {
+          errs() << "Failed to open run summary file: " << ec.message()
+                 << "\n";
+          status = 1;
+        } else {
+          emitPublicDataRunSummary(os, in.stem, elapsedMs, maxRssKb());
+        }
+      }
+    }
+    in.module.reset();
+    in.ctx.reset();
+    submit(i + window);
+  }
+  return status;
+}
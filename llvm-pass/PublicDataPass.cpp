@@ -1,27 +1,72 @@
+#include "PublicDataPass.h"
+#include "ColumnarTrace.h"
+#include "ShmRing.h"
+
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
-#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/RegionInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Argument.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/ConstantRange.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/KnownBits.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
-#include <functional>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 using namespace llvm;
 
 namespace {
@@ -36,6 +81,22 @@ static cl::opt<std::string> TraceIndexOut(
   cl::desc("Write NDJSON trace index to this path"),
   cl::init("")
 );
+static cl::opt<std::string> TraceIndexBinOut(
+  "public-data-trace-index-bin",
+  cl::desc("Write a binary (fn, pp) -> trace byte offset index to this path"),
+  cl::init("")
+);
+static cl::opt<std::string> TraceFormat(
+  "public-data-trace-format",
+  cl::desc("Trace file format: ndjson|columnar (binary column blocks per "
+           "function, see ColumnarTrace.h)"),
+  cl::init("ndjson")
+);
+static cl::opt<std::string> CompressSpec(
+  "public-data-compress",
+  cl::desc("Compress trace/index/CFG output: none|zstd[:level]"),
+  cl::init("none")
+);
 static cl::opt<bool> TraceTypes(
   "public-data-trace-types",
   cl::desc("Include type strings in trace output"),
@@ -66,11 +127,114 @@ static cl::opt<unsigned> MaxLoopIters(
   cl::desc("Maximum loop iterations per block on a path"),
   cl::init(0)
 );
+static cl::opt<unsigned> PathCountMaxStates(
+  "public-data-path-count-max-states",
+  cl::desc("Maximum memoized states for exact path counting (0 disables)"),
+  cl::init(1000000)
+);
+static cl::opt<unsigned> FnTimeBudgetMs(
+  "public-data-fn-time-budget-ms",
+  cl::desc("Stop a function's path enumeration after this many milliseconds "
+           "(0 disables)"),
+  cl::init(0)
+);
+static cl::opt<unsigned> FnMemBudgetMb(
+  "public-data-fn-mem-budget-mb",
+  cl::desc("Stop a function's path enumeration once its output and path "
+           "tables reach this many MiB (0 disables)"),
+  cl::init(0)
+);
+static cl::opt<bool> PruneCorrelated(
+  "public-data-prune-correlated",
+  cl::desc("Prune path successors that contradict branch/switch decisions "
+           "already on the path"),
+  cl::init(true)
+);
+static cl::opt<bool> PruneRanges(
+  "public-data-prune-ranges",
+  cl::desc("Prune path successors LazyValueInfo/known bits prove infeasible "
+           "on the edge taken, and drop decisions they prove implied"),
+  cl::init(true)
+);
 static cl::opt<std::string> PathCondFormat(
   "public-data-path-cond-format",
   cl::desc("Path condition format: string|json|both"),
   cl::init("string")
 );
+static cl::opt<bool> CondTable(
+  "public-data-cond-table",
+  cl::desc("Emit each decision's condition once as a cond record; path and "
+           "segment records carry cond ids instead of decisions/path_cond"),
+  cl::init(false)
+);
+static cl::opt<std::string> PathEncoding(
+  "public-data-path-encoding",
+  cl::desc("Path record encoding: full|trie (trie emits shared path_node "
+           "prefixes)"),
+  cl::init("full")
+);
+static cl::opt<std::string> PathMode(
+  "public-data-path-mode",
+  cl::desc("Path enumeration unit: function|region (region emits "
+           "per-SESE-region segment records)"),
+  cl::init("function")
+);
+static cl::opt<std::string> PathOrder(
+  "public-data-path-order",
+  cl::desc("Order paths are emitted in under -public-data-max-paths: "
+           "dfs|coverage|tx-density (greedy walks maximizing newly covered "
+           "pps or transmitters, then DFS)"),
+  cl::init("dfs")
+);
+static cl::opt<bool> DedupPaths(
+  "public-data-dedup-paths",
+  cl::desc("Emit one path per class of paths that agree on "
+           "transmitter-relevant blocks, with class_size/members (function "
+           "path mode with full encoding only)"),
+  cl::init(false)
+);
+static cl::opt<bool> StaticPublic(
+  "public-data-static-public",
+  cl::desc("Tag transmitters whose operand is provably equal across "
+           "executions with \"static\":\"equal\""),
+  cl::init(false)
+);
+static cl::list<std::string> PublicArgs(
+  "public-data-public-arg",
+  cl::desc("Treat an argument as public for -public-data-static-public "
+           "(fn:name or fn:index, fn may be *)"),
+  cl::CommaSeparated, cl::ZeroOrMore
+);
+static cl::opt<bool> PathSlice(
+  "public-data-path-slice",
+  cl::desc("Emit slice_pps on each path: the pps its transmitters and path "
+           "conditions depend on"),
+  cl::init(false)
+);
+static cl::opt<bool> EmitLoops(
+  "public-data-loops",
+  cl::desc("Emit a loop record per natural loop with LoopInfo/ScalarEvolution "
+           "facts (induction variable, trip count, affine accesses)"),
+  cl::init(false)
+);
+static cl::opt<bool> EmitMemSSA(
+  "public-data-mem-ssa",
+  cl::desc("Annotate memory trace records with must-alias mem_class and the "
+           "reaching MemorySSA def (mem_def/mem_phi)"),
+  cl::init(false)
+);
+static cl::opt<bool> CalleeSummaries(
+  "public-data-callee-summaries",
+  cl::desc("Emit a callee_summary record per function from a bottom-up "
+           "CallGraph walk (public-data-module only)"),
+  cl::init(false)
+);
+static cl::opt<bool> EmitPerf(
+  "public-data-perf",
+  cl::desc("Emit a perf record per function with phase timings, bytes written "
+           "per stream and peak id-table sizes"),
+  cl::init(false)
+);
 static cl::opt<bool> IncludePpSeq(
   "public-data-path-include-pp-seq",
   cl::desc("Include instruction-level pp_seq for each path record"),
@@ -81,11 +245,74 @@ static cl::opt<bool> EmitPpCoverage(
   cl::desc("Emit pp_coverage records mapping pp -> path ids"),
   cl::init(false)
 );
+static cl::opt<std::string> PpCoverageFormat(
+  "public-data-pp-coverage-format",
+  cl::desc("pp coverage records: pp (pp_coverage per pp, capped "
+           "path_ids)|block (block_coverage per block, uncapped path id "
+           "ranges)"),
+  cl::init("pp")
+);
 static cl::opt<unsigned> MaxPpPathIds(
   "public-data-max-pp-path-ids",
   cl::desc("Max path ids listed per pp_coverage record"),
   cl::init(64)
 );
+static cl::opt<bool> InternIds(
+  "public-data-intern-ids",
+  cl::desc("Emit pps, blocks and value ids as integers indexing a "
+           "per-function symtab record"),
+  cl::init(false)
+);
+static cl::opt<std::string> CacheDir(
+  "public-data-cache-dir",
+  cl::desc("Reuse rendered functions from this directory, keyed by a hash "
+           "of their IR and the output options"),
+  cl::init("")
+);
+static cl::opt<std::string> CacheManifestOut(
+  "public-data-cache-manifest",
+  cl::desc("Write each function's cache key and hit/miss to this NDJSON path"),
+  cl::init("")
+);
+static cl::opt<std::string> ShardDir(
+  "public-data-shard-dir",
+  cl::desc("Also write trace/trace-index/CFG shard files and a "
+           "manifest.ndjson listing them to this directory"),
+  cl::init("")
+);
+static cl::opt<unsigned> ShardFns(
+  "public-data-shard-fns",
+  cl::desc("Maximum functions per shard (0 = no limit)"),
+  cl::init(1)
+);
+static cl::opt<unsigned> ShardKb(
+  "public-data-shard-kb",
+  cl::desc("Start a new shard once one holds this many KiB of records "
+           "(0 disables)"),
+  cl::init(0)
+);
+static cl::opt<std::string> ShmName(
+  "public-data-shm",
+  cl::desc("Also publish every rendered function to a ring in this POSIX "
+           "shared-memory object for a concurrent reader (symex/shm.py)"),
+  cl::init("")
+);
+static cl::opt<unsigned> ShmMb(
+  "public-data-shm-mb",
+  cl::desc("Size of the -public-data-shm ring in MiB"),
+  cl::init(64)
+);
+static cl::opt<unsigned> ShmWaitMs(
+  "public-data-shm-wait-ms",
+  cl::desc("Drop a function after waiting this long for ring space "
+           "(0 = wait for the reader indefinitely)"),
+  cl::init(0)
+);
+static cl::opt<unsigned> Threads(
+  "public-data-threads",
+  cl::desc("Worker threads for -passes=public-data-module (0 uses all cores)"),
+  cl::init(0)
+);
 static cl::opt<bool> Quiet(
   "public-data-quiet",
   cl::desc("Suppress debug output"),
@@ -108,84 +335,997 @@ static std::string programPointLabel(StringRef fnName, StringRef bbLabel,
   return os.str();
 }
 
-// Escape a string for safe JSON output.
-// Input: raw string.
-// Output: escaped string (without surrounding quotes).
-static std::string escapeJson(StringRef s) {
-  std::string out;
-  out.reserve(s.size());
+// Whether s can be written inside JSON quotes as-is.
+static bool isJsonPlain(StringRef s) {
   for (char c : s) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u < 0x20 || c == '"' || c == '\\') return false;
+  }
+  return true;
+}
+
+// Emit a JSON string literal to an output stream. Runs that need no escape
+// are written straight through, so nothing is allocated.
+static void emitJsonString(raw_ostream &os, StringRef s) {
+  os << '"';
+  size_t start = 0;
+  for (size_t i = 0; i < s.size(); ++i) {
+    char c = s[i];
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u >= 0x20 && c != '"' && c != '\\') continue;
+    os << s.slice(start, i);
+    start = i + 1;
     switch (c) {
-      case '\\': out += "\\\\"; break;
-      case '"': out += "\\\""; break;
-      case '\n': out += "\\n"; break;
-      case '\r': out += "\\r"; break;
-      case '\t': out += "\\t"; break;
-      default:
-        if (static_cast<unsigned char>(c) < 0x20) {
-          char buf[7];
-          std::snprintf(buf, sizeof(buf), "\\u%04x",
-                        static_cast<unsigned char>(c));
-          out += buf;
-        } else {
-          out += c;
-        }
+      case '\\': os << "\\\\"; break;
+      case '"': os << "\\\""; break;
+      case '\n': os << "\\n"; break;
+      case '\r': os << "\\r"; break;
+      case '\t': os << "\\t"; break;
+      default: {
+        char buf[7];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", u);
+        os << buf;
+      }
     }
   }
-  return out;
+  os << s.drop_front(start) << '"';
 }
 
-// Emit a JSON string literal to an output stream.
-static void emitJsonString(raw_ostream &os, StringRef s) {
-  os << "\"" << escapeJson(s) << "\"";
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+// Streaming zstd encoder over a file. Input is compressed as it is written;
+// blocks are flushed every FlushBytes of input so a crash leaves a decodable
+// prefix, and maybeEndFrame() closes the frame at a function boundary once
+// it holds FrameBytes, so readers can start decoding at any frame offset.
+class ZstdOStream : public raw_ostream {
+public:
+  static constexpr uint64_t FlushBytes = 64 << 10;
+  static constexpr uint64_t FrameBytes = 1 << 20;
+
+  ZstdOStream(std::unique_ptr<raw_fd_ostream> file, int level)
+      : file(std::move(file)), cctx(ZSTD_createCCtx()),
+        outBuf(ZSTD_CStreamOutSize()) {
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+  }
+  ~ZstdOStream() override {
+    flush();
+    if (frameInput) compress(nullptr, 0, ZSTD_e_end);
+    ZSTD_freeCCtx(cctx);
+  }
+
+  void maybeEndFrame() {
+    flush();
+    if (frameInput < FrameBytes) return;
+    compress(nullptr, 0, ZSTD_e_end);
+    frameInput = 0;
+    sinceFlush = 0;
+    frameStart = file->tell();
+    frameBase = pos;
+  }
+  uint64_t frameOffset() const { return frameStart; }
+  uint64_t frameLogicalOffset() const { return frameBase; }
+
+private:
+  void write_impl(const char *ptr, size_t size) override {
+    compress(ptr, size, ZSTD_e_continue);
+    pos += size;
+    frameInput += size;
+    sinceFlush += size;
+    if (sinceFlush >= FlushBytes) {
+      compress(nullptr, 0, ZSTD_e_flush);
+      sinceFlush = 0;
+    }
+  }
+  uint64_t current_pos() const override { return pos; }
+
+  void compress(const char *ptr, size_t size, ZSTD_EndDirective mode) {
+    ZSTD_inBuffer in = {ptr, size, 0};
+    for (;;) {
+      ZSTD_outBuffer out = {outBuf.data(), outBuf.size(), 0};
+      size_t remaining = ZSTD_compressStream2(cctx, &out, &in, mode);
+      if (ZSTD_isError(remaining)) {
+        errs() << "zstd compression failed: "
+               << ZSTD_getErrorName(remaining) << "\n";
+        return;
+      }
+      file->write(outBuf.data(), out.pos);
+      bool done = mode == ZSTD_e_continue ? in.pos == in.size
+                                          : remaining == 0;
+      if (done) break;
+    }
+    if (mode != ZSTD_e_continue) file->flush();
+  }
+
+  std::unique_ptr<raw_fd_ostream> file;
+  ZSTD_CCtx *cctx;
+  std::vector<char> outBuf;
+  uint64_t pos = 0;
+  uint64_t frameInput = 0;
+  uint64_t sinceFlush = 0;
+  uint64_t frameStart = 0;
+  uint64_t frameBase = 0;
+};
+#endif
+
+// Parse -public-data-compress once. Returns the zstd level, or 0 for
+// uncompressed output.
+static int getCompressLevel() {
+  static int level = [] {
+    StringRef spec = CompressSpec;
+    if (spec.empty() || spec == "none") return 0;
+    StringRef codec = spec;
+    StringRef levelText;
+    std::tie(codec, levelText) = spec.split(':');
+    int lvl = 3;
+    if (codec != "zstd" ||
+        (!levelText.empty() && levelText.getAsInteger(10, lvl))) {
+      errs() << "Unknown -public-data-compress: " << spec
+             << " (writing uncompressed output)\n";
+      return 0;
+    }
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    lvl = std::max(ZSTD_minCLevel(), std::min(lvl, ZSTD_maxCLevel()));
+    // Level 0 means "zstd default" to the library; keep it distinct from
+    // "uncompressed" here.
+    return lvl == 0 ? 3 : lvl;
+#else
+    errs() << "PublicDataPass was built without zstd;"
+           << " writing uncompressed output\n";
+    return 0;
+#endif
+  }();
+  return level;
 }
 
-// Open (or return) the trace NDJSON stream. Returns nullptr if disabled.
-static raw_fd_ostream *getTraceStream() {
-  if (TraceOut.empty()) return nullptr;
-  static std::unique_ptr<raw_fd_ostream> trace;
-  if (!trace) {
+// One pass output file, zstd-compressed under -public-data-compress. The
+// frame accessors report where the frame holding the next write begins:
+// the compressed file offset a reader seeks to, and the logical (decoded)
+// offset it corresponds to. Uncompressed, both are the current position.
+class OutputFile {
+public:
+  static std::unique_ptr<OutputFile> open(StringRef path, StringRef what,
+                                          bool binary = false) {
     std::error_code ec;
-    trace = std::make_unique<raw_fd_ostream>(TraceOut, ec, sys::fs::OF_Text);
+    int level = getCompressLevel();
+    auto file = std::make_unique<raw_fd_ostream>(
+      path, ec, level || binary ? sys::fs::OF_None : sys::fs::OF_Text);
     if (ec) {
-      errs() << "Failed to open trace file: " << ec.message() << "\n";
-      trace.reset();
+      errs() << "Failed to open " << what << " file: " << ec.message() << "\n";
       return nullptr;
     }
+    // Records are small; a large buffer turns them into few write calls.
+    file->SetBufferSize(1 << 20);
+    auto out = std::unique_ptr<OutputFile>(new OutputFile());
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    if (level) {
+      out->zstd = std::make_unique<ZstdOStream>(std::move(file), level);
+      return out;
+    }
+#endif
+    out->file = std::move(file);
+    return out;
+  }
+
+  raw_ostream &stream() {
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    if (zstd) return *zstd;
+#endif
+    return *file;
+  }
+
+  // Called between functions so frames only ever start at a function.
+  void endFrame() {
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    if (zstd) zstd->maybeEndFrame();
+#endif
+  }
+
+  uint64_t frameOffset() {
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    if (zstd) return zstd->frameOffset();
+#endif
+    return file->tell();
+  }
+
+  uint64_t frameLogicalOffset() {
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    if (zstd) return zstd->frameLogicalOffset();
+#endif
+    return file->tell();
+  }
+
+  bool compressed() const {
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+    return zstd != nullptr;
+#else
+    return false;
+#endif
+  }
+
+private:
+  OutputFile() = default;
+
+  std::unique_ptr<raw_fd_ostream> file;
+#ifdef PUBLIC_DATA_HAVE_ZSTD
+  std::unique_ptr<ZstdOStream> zstd;
+#endif
+};
+
+// Input stem substituted for "{}" in output paths; set per input by
+// drivers that run several modules in one process (ct-trace).
+static std::string OutputStem;
+
+// Expand an output path option against OutputStem.
+static std::string outputPath(StringRef path) {
+  if (OutputStem.empty()) return path.str();
+  std::string out;
+  for (;;) {
+    size_t pos = path.find("{}");
+    out += path.substr(0, pos).str();
+    if (pos == StringRef::npos) break;
+    out += OutputStem;
+    path = path.drop_front(pos + 2);
   }
-  return trace.get();
+  return out;
 }
 
-// Open (or return) the trace index stream. Returns nullptr if disabled.
-static raw_fd_ostream *getTraceIndexStream() {
-  if (TraceIndexOut.empty()) return nullptr;
-  static std::unique_ptr<raw_fd_ostream> traceIndex;
-  if (!traceIndex) {
-    std::error_code ec;
-    traceIndex = std::make_unique<raw_fd_ostream>(TraceIndexOut, ec, sys::fs::OF_Text);
-    if (ec) {
-      errs() << "Failed to open trace index file: " << ec.message() << "\n";
-      traceIndex.reset();
-      return nullptr;
+// NDJSON schema versions, stamped in the schema record that starts each
+// stream. Bump on changes a reader must know about (TRACE_SCHEMA.md,
+// CFG_SCHEMA.md); new optional fields and record kinds do not need one.
+static constexpr unsigned TraceSchemaVersion = 1;
+static constexpr unsigned CfgSchemaVersion = 1;
+
+// Open (or return) the output file in slot, starting a new file with its
+// schema record. Returns nullptr if disabled or the file cannot be opened.
+static OutputFile *getOutputFile(std::unique_ptr<OutputFile> &slot,
+                                 StringRef path, StringRef what,
+                                 StringLiteral stream, unsigned version) {
+  if (path.empty()) return nullptr;
+  if (!slot) {
+    slot = OutputFile::open(outputPath(path), what);
+    if (slot) {
+      slot->stream() << "{\"kind\":\"schema\",\"stream\":\"" << stream
+                     << "\",\"version\":" << version << "}\n";
     }
   }
-  return traceIndex.get();
+  return slot.get();
+}
+
+// Write v as a bytes-wide little-endian integer.
+static void writeLE(raw_ostream &os, uint64_t v, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; ++i) {
+    os << static_cast<char>((v >> (8 * i)) & 0xff);
+  }
+}
+
+// Whether the trace is written as columnar blocks instead of NDJSON.
+static bool columnarTrace() {
+  StringRef format = TraceFormat;
+  if (format == "columnar") return true;
+  static bool warned = false;
+  if (format != "ndjson" && !format.empty() && !warned && !Quiet) {
+    errs() << "Unknown -public-data-trace-format: " << format
+           << " (defaulting to ndjson)\n";
+    warned = true;
+  }
+  return false;
+}
+
+// Transmitter kinds getTransmitterInfos() reports, numbered for the
+// columnar trace's tx_kind column and tx_mask bits.
+static constexpr StringLiteral ColumnarTxKinds[] = {
+  "load.addr", "store.addr", "atomicrmw.addr", "cmpxchg.addr", "br.cond",
+  "switch.cond", "indirectbr.target", "call.target", "div.operand",
+  "rem.operand",
+};
+
+// Write the columnar trace header (see ColumnarTrace.h): the opcode,
+// predicate and transmitter kind names the blocks' enums index.
+static void writeColumnarHeader(raw_ostream &os) {
+  std::vector<std::string> opcodes(Instruction::OtherOpsEnd);
+  for (unsigned op = 1; op < Instruction::OtherOpsEnd; ++op) {
+    opcodes[op] = Instruction::getOpcodeName(op);
+  }
+  std::vector<std::string> preds(CmpInst::LAST_ICMP_PREDICATE + 1);
+  for (unsigned p = CmpInst::FIRST_FCMP_PREDICATE;
+       p <= CmpInst::LAST_FCMP_PREDICATE; ++p) {
+    preds[p] = FCmpInst::getPredicateName(CmpInst::Predicate(p)).str();
+  }
+  for (unsigned p = CmpInst::FIRST_ICMP_PREDICATE;
+       p <= CmpInst::LAST_ICMP_PREDICATE; ++p) {
+    preds[p] = ICmpInst::getPredicateName(CmpInst::Predicate(p)).str();
+  }
+  std::string names;
+  raw_string_ostream namesOS(names);
+  for (const std::string &name : opcodes) {
+    writeLE(namesOS, name.size(), 4);
+    namesOS << name;
+  }
+  for (const std::string &name : preds) {
+    writeLE(namesOS, name.size(), 4);
+    namesOS << name;
+  }
+  for (StringRef name : ColumnarTxKinds) {
+    writeLE(namesOS, name.size(), 4);
+    namesOS << name;
+  }
+  namesOS.flush();
+  uint64_t headerSize =
+    ct_columnar::align8(ct_columnar::FileHeaderFixedSize + names.size());
+  os << StringRef(ct_columnar::Magic, 8);
+  writeLE(os, ct_columnar::Version, 4);
+  writeLE(os, headerSize, 4);
+  writeLE(os, opcodes.size(), 4);
+  writeLE(os, preds.size(), 4);
+  writeLE(os, std::size(ColumnarTxKinds), 4);
+  writeLE(os, 0, 4);
+  os << names;
+  os.write_zeros(headerSize - ct_columnar::FileHeaderFixedSize - names.size());
+}
+
+// Open (or return) a trace file in slot: NDJSON starting with its schema
+// record, or a columnar file starting with its header.
+static OutputFile *getTraceOutputFile(std::unique_ptr<OutputFile> &slot,
+                                      StringRef path, StringRef what) {
+  if (!columnarTrace()) {
+    return getOutputFile(slot, path, what, "trace", TraceSchemaVersion);
+  }
+  if (path.empty()) return nullptr;
+  if (!slot) {
+    slot = OutputFile::open(outputPath(path), what, /*binary=*/true);
+    if (slot) writeColumnarHeader(slot->stream());
+  }
+  return slot.get();
+}
+
+static std::unique_ptr<OutputFile> TraceFile;
+static std::unique_ptr<OutputFile> TraceIndexFile;
+static std::unique_ptr<OutputFile> CfgFile;
+
+// Open (or return) the trace file. Returns nullptr if disabled.
+static OutputFile *getTraceFile() {
+  return getTraceOutputFile(TraceFile, TraceOut, "trace");
+}
+
+// Open (or return) the trace index stream. Returns nullptr if disabled.
+static raw_ostream *getTraceIndexStream() {
+  OutputFile *file =
+    getOutputFile(TraceIndexFile, TraceIndexOut, "trace index", "trace_index",
+                  TraceSchemaVersion);
+  return file ? &file->stream() : nullptr;
 }
 
 // Open (or return) the CFG/path NDJSON stream. Returns nullptr if disabled.
-static raw_fd_ostream *getCfgStream() {
-  if (CfgOut.empty()) return nullptr;
-  static std::unique_ptr<raw_fd_ostream> cfg;
-  if (!cfg) {
+static raw_ostream *getCfgStream() {
+  OutputFile *file =
+    getOutputFile(CfgFile, CfgOut, "CFG", "cfg", CfgSchemaVersion);
+  return file ? &file->stream() : nullptr;
+}
+
+// Mark a function boundary on every open output file.
+static void endOutputFrames() {
+  for (std::unique_ptr<OutputFile> *slot :
+       {&TraceFile, &TraceIndexFile, &CfgFile}) {
+    if (*slot) (*slot)->endFrame();
+  }
+}
+
+// Byte span of one trace instruction record, relative to the start of its
+// function's trace output. The length excludes the trailing newline.
+struct TraceSpan {
+  uint32_t pp;
+  uint64_t offset;
+  uint32_t length;
+};
+
+// Trace spans collected for one function; symtabLength is 0 unless ids are
+// interned.
+struct FunctionTraceSpans {
+  uint64_t symtabOffset = 0;
+  uint32_t symtabLength = 0;
+  std::vector<TraceSpan> spans;
+};
+
+// Accumulates per-function trace spans and writes the binary trace index
+// (see TRACE_SCHEMA.md) on destruction, once every function is known.
+// Offsets are logical (decoded) trace offsets; each function also records
+// the compressed offset of the zstd frame holding it and that frame's
+// logical start, which coincide when the trace is uncompressed.
+//
+// Layout, all integers little-endian:
+//   header:   "CTPIDX01", u32 version, u32 flags, u32 fn_count, u32 0,
+//             u64 entry_count, u64 fn_table_offset
+//   entries:  entry_count x {u32 fn_id, u32 pp_id, u64 offset, u32 length},
+//             sorted by (fn_id, pp_id)
+//   fn table: fn_count x {u64 frame_offset, u64 frame_base,
+//             u64 symtab_offset, u32 symtab_length, u64 first_entry,
+//             u32 entry_count, u32 name_len, name bytes}
+class TraceIndexBinWriter {
+public:
+  static constexpr uint32_t Version = 2;
+  static constexpr uint32_t FlagZstd = 1;
+
+  TraceIndexBinWriter(std::string path, bool compressed)
+      : path(std::move(path)), flags(compressed ? FlagZstd : 0) {}
+  ~TraceIndexBinWriter() { write(); }
+
+  // Record one function whose trace output starts at logical offset base,
+  // inside the frame that starts at frameOffset (compressed) / frameBase
+  // (logical).
+  void addFunction(StringRef name, uint64_t base, uint64_t frameOffset,
+                   uint64_t frameBase, const FunctionTraceSpans &fnSpans) {
+    FunctionEntry fe;
+    fe.name = name.str();
+    fe.frameOffset = frameOffset;
+    fe.frameBase = frameBase;
+    fe.symtabOffset = fnSpans.symtabLength ? base + fnSpans.symtabOffset : 0;
+    fe.symtabLength = fnSpans.symtabLength;
+    fe.firstEntry = entries.size();
+    fe.entryCount = fnSpans.spans.size();
+    uint32_t fnId = fns.size();
+    for (const TraceSpan &sp : fnSpans.spans) {
+      entries.push_back({fnId, sp.pp, base + sp.offset, sp.length});
+    }
+    // Spans arrive in instruction order, which is pp order; sort anyway so
+    // the on-disk invariant does not depend on that.
+    std::sort(entries.begin() + fe.firstEntry, entries.end(),
+              [](const Entry &a, const Entry &b) { return a.pp < b.pp; });
+    fns.push_back(std::move(fe));
+  }
+
+private:
+  struct Entry {
+    uint32_t fn;
+    uint32_t pp;
+    uint64_t offset;
+    uint32_t length;
+  };
+  struct FunctionEntry {
+    std::string name;
+    uint64_t frameOffset = 0;
+    uint64_t frameBase = 0;
+    uint64_t symtabOffset = 0;
+    uint32_t symtabLength = 0;
+    uint64_t firstEntry = 0;
+    uint32_t entryCount = 0;
+  };
+  static constexpr uint64_t HeaderSize = 40;
+  static constexpr uint64_t EntrySize = 20;
+
+  void write() {
     std::error_code ec;
-    cfg = std::make_unique<raw_fd_ostream>(CfgOut, ec, sys::fs::OF_Text);
+    raw_fd_ostream os(path, ec, sys::fs::OF_None);
     if (ec) {
-      errs() << "Failed to open CFG file: " << ec.message() << "\n";
-      cfg.reset();
+      errs() << "Failed to open binary trace index file: " << ec.message()
+             << "\n";
+      return;
+    }
+    os << StringRef("CTPIDX01", 8);
+    writeLE(os, Version, 4);
+    writeLE(os, flags, 4);
+    writeLE(os, fns.size(), 4);
+    writeLE(os, 0, 4);
+    writeLE(os, entries.size(), 8);
+    writeLE(os, HeaderSize + EntrySize * entries.size(), 8);
+    for (const Entry &e : entries) {
+      writeLE(os, e.fn, 4);
+      writeLE(os, e.pp, 4);
+      writeLE(os, e.offset, 8);
+      writeLE(os, e.length, 4);
+    }
+    for (const FunctionEntry &fe : fns) {
+      writeLE(os, fe.frameOffset, 8);
+      writeLE(os, fe.frameBase, 8);
+      writeLE(os, fe.symtabOffset, 8);
+      writeLE(os, fe.symtabLength, 4);
+      writeLE(os, fe.firstEntry, 8);
+      writeLE(os, fe.entryCount, 4);
+      writeLE(os, fe.name.size(), 4);
+      os << fe.name;
+    }
+  }
+
+  std::string path;
+  uint32_t flags;
+  std::vector<Entry> entries;
+  std::vector<FunctionEntry> fns;
+};
+
+static std::unique_ptr<TraceIndexBinWriter> TraceIndexBin;
+
+// Return the binary trace index writer, or nullptr if disabled. The index
+// points into NDJSON trace records, so it also requires -public-data-trace
+// in the ndjson format.
+static TraceIndexBinWriter *getTraceIndexBinWriter() {
+  if (TraceIndexBinOut.empty()) return nullptr;
+  if (columnarTrace()) {
+    static bool warned = false;
+    if (!warned && !Quiet) {
+      errs() << "-public-data-trace-index-bin is ignored with "
+                "-public-data-trace-format=columnar\n";
+      warned = true;
+    }
+    return nullptr;
+  }
+  OutputFile *trace = getTraceFile();
+  if (!trace) return nullptr;
+  if (!TraceIndexBin) {
+    TraceIndexBin = std::make_unique<TraceIndexBinWriter>(
+      outputPath(TraceIndexBinOut), trace->compressed());
+  }
+  return TraceIndexBin.get();
+}
+
+// One function's rendered records per stream, its binary index spans and
+// its debug log. Everything is relative to the function's own start, so a
+// buffered (or cached) function is committed by plain concatenation.
+struct FunctionOutput {
+  std::string trace;
+  std::string traceIndex;
+  std::string cfg;
+  std::string log;
+  FunctionTraceSpans spans;
+  unsigned pathRecords = 0;
+};
+
+// -public-data-shard-dir: every function is also appended to shard files
+// (shard-NNNNN.ndjson, .trace_index.ndjson, .cfg.ndjson, each starting
+// with its schema record). A shard closes after -public-data-shard-fns
+// functions or once it holds -public-data-shard-kb of records, and is then
+// listed in manifest.ndjson with per-function sizes, so schedulers can
+// balance shards without parsing them.
+static constexpr unsigned ShardManifestVersion = 1;
+
+class ShardWriter {
+public:
+  explicit ShardWriter(std::string dir) : dir(std::move(dir)) {
+    if (std::error_code ec = sys::fs::create_directories(this->dir)) {
+      errs() << "Failed to create shard directory: " << ec.message() << "\n";
+    }
+    SmallString<256> path(this->dir);
+    sys::path::append(path, "manifest.ndjson");
+    getOutputFile(manifest, path, "shard manifest", "shard_manifest",
+                  ShardManifestVersion);
+  }
+  ~ShardWriter() { closeShard(); }
+
+  void add(const Function &F, const FunctionOutput &out) {
+    if (fns.empty()) openShard();
+    if (trace) trace->stream() << out.trace;
+    if (traceIndex) traceIndex->stream() << out.traceIndex;
+    if (cfg) cfg->stream() << out.cfg;
+    for (OutputFile *file : {trace.get(), traceIndex.get(), cfg.get()}) {
+      if (file) file->endFrame();
+    }
+    fns.push_back({F.getName().str(), F.getInstructionCount(),
+                   out.pathRecords, out.trace.size(), out.traceIndex.size(),
+                   out.cfg.size()});
+    bytes += out.trace.size() + out.traceIndex.size() + out.cfg.size();
+    if ((ShardFns > 0 && fns.size() >= ShardFns) ||
+        (ShardKb > 0 && bytes >= uint64_t(ShardKb) * 1024)) {
+      closeShard();
+    }
+  }
+
+private:
+  struct ShardFunction {
+    std::string fn;
+    unsigned instCount;
+    unsigned pathRecords;
+    uint64_t traceBytes;
+    uint64_t traceIndexBytes;
+    uint64_t cfgBytes;
+  };
+
+  static StringRef traceSuffix() {
+    return columnarTrace() ? ".col" : ".ndjson";
+  }
+
+  std::string shardFile(StringRef suffix) const {
+    SmallString<32> name;
+    raw_svector_ostream(name) << "shard-" << format("%05u", index) << suffix;
+    return std::string(name);
+  }
+
+  void openShard() {
+    auto open = [&](std::unique_ptr<OutputFile> &slot, StringRef suffix,
+                    StringRef what, StringLiteral stream, unsigned version) {
+      SmallString<256> path(dir);
+      sys::path::append(path, shardFile(suffix));
+      if (&slot == &trace) getTraceOutputFile(slot, path, what);
+      else getOutputFile(slot, path, what, stream, version);
+    };
+    open(trace, traceSuffix(), "shard trace", "trace", TraceSchemaVersion);
+    open(traceIndex, ".trace_index.ndjson", "shard trace index",
+         "trace_index", TraceSchemaVersion);
+    open(cfg, ".cfg.ndjson", "shard CFG", "cfg", CfgSchemaVersion);
+  }
+
+  // Close the open shard, if any, and list it in the manifest. Sizes are
+  // uncompressed record bytes, without the schema records.
+  void closeShard() {
+    if (fns.empty()) return;
+    trace.reset();
+    traceIndex.reset();
+    cfg.reset();
+    if (manifest) {
+      raw_ostream &os = manifest->stream();
+      uint64_t insts = 0, paths = 0, traceBytes = 0, indexBytes = 0,
+               cfgBytes = 0;
+      for (const ShardFunction &sf : fns) {
+        insts += sf.instCount;
+        paths += sf.pathRecords;
+        traceBytes += sf.traceBytes;
+        indexBytes += sf.traceIndexBytes;
+        cfgBytes += sf.cfgBytes;
+      }
+      auto emitBytes = [&](uint64_t t, uint64_t i, uint64_t c) {
+        os << ",\"bytes\":{\"trace\":" << t << ",\"trace_index\":" << i
+           << ",\"cfg\":" << c << "}";
+      };
+      os << "{\"kind\":\"shard\",\"shard\":" << index;
+      os << ",\"trace\":\"" << shardFile(traceSuffix()) << "\"";
+      os << ",\"trace_index\":\"" << shardFile(".trace_index.ndjson") << "\"";
+      os << ",\"cfg\":\"" << shardFile(".cfg.ndjson") << "\"";
+      os << ",\"inst_count\":" << insts << ",\"paths\":" << paths;
+      emitBytes(traceBytes, indexBytes, cfgBytes);
+      os << ",\"fns\":[";
+      for (size_t i = 0; i < fns.size(); ++i) {
+        const ShardFunction &sf = fns[i];
+        if (i) os << ",";
+        os << "{\"fn\":";
+        emitJsonString(os, sf.fn);
+        os << ",\"inst_count\":" << sf.instCount
+           << ",\"paths\":" << sf.pathRecords;
+        emitBytes(sf.traceBytes, sf.traceIndexBytes, sf.cfgBytes);
+        os << "}";
+      }
+      os << "]}\n";
+      manifest->endFrame();
+    }
+    fns.clear();
+    bytes = 0;
+    index++;
+  }
+
+  std::string dir;
+  unsigned index = 0;
+  uint64_t bytes = 0;
+  std::vector<ShardFunction> fns;
+  std::unique_ptr<OutputFile> trace;
+  std::unique_ptr<OutputFile> traceIndex;
+  std::unique_ptr<OutputFile> cfg;
+  std::unique_ptr<OutputFile> manifest;
+};
+
+static std::unique_ptr<ShardWriter> Shards;
+
+// Return the shard writer, or nullptr without -public-data-shard-dir.
+static ShardWriter *getShardWriter() {
+  if (ShardDir.empty()) return nullptr;
+  if (!Shards) Shards = std::make_unique<ShardWriter>(outputPath(ShardDir));
+  return Shards.get();
+}
+
+// -public-data-shm: completed functions are also published to a
+// shared-memory ring (see ShmRing.h), so a reader can start on function N
+// while function N+1 is rendered. The ring lives for the whole process,
+// across ct-trace inputs, and is closed on exit.
+struct ShmPublisher {
+#ifdef CT_SHM_AVAILABLE
+  ct_shm::Producer ring;
+#endif
+  bool warnedDrop = false;
+};
+
+static std::unique_ptr<ShmPublisher> Shm;
+
+// Return the ring publisher, or nullptr without -public-data-shm or when
+// the region cannot be created (reported once).
+static ShmPublisher *getShmPublisher() {
+  if (ShmName.empty()) return nullptr;
+  static bool failed = false;
+  if (failed) return nullptr;
+  if (!Shm) {
+    Shm = std::make_unique<ShmPublisher>();
+#ifdef CT_SHM_AVAILABLE
+    std::string error;
+    uint32_t flags = columnarTrace() ? ct_shm::FlagColumnar : 0;
+    if (!Shm->ring.create(ShmName, uint64_t(ShmMb) << 20, flags, error)) {
+      errs() << "Failed to create shared-memory ring " << ShmName << ": "
+             << error << "\n";
+      Shm.reset();
+      failed = true;
       return nullptr;
     }
+    if (columnarTrace()) {
+      std::string header;
+      raw_string_ostream headerOS(header);
+      writeColumnarHeader(headerOS);
+      headerOS.flush();
+      Shm->ring.publish(ct_shm::ColumnarHeaderMessage, {}, {}, header, {}, {},
+                        ShmWaitMs);
+    }
+#else
+    errs() << "-public-data-shm needs POSIX shared memory; ignoring\n";
+    Shm.reset();
+    failed = true;
+    return nullptr;
+#endif
+  }
+  return Shm.get();
+}
+
+static void publishFunctionOutput(const Function &F,
+                                  const FunctionOutput &out) {
+  ShmPublisher *shm = getShmPublisher();
+  if (!shm) return;
+#ifdef CT_SHM_AVAILABLE
+  std::string module = OutputStem.empty()
+    ? sys::path::stem(F.getParent()->getModuleIdentifier()).str()
+    : OutputStem;
+  auto view = [](const std::string &s) {
+    return std::string_view(s.data(), s.size());
+  };
+  StringRef fn = F.getName();
+  if (!shm->ring.publish(ct_shm::FunctionMessage, view(module),
+                         std::string_view(fn.data(), fn.size()),
+                         view(out.trace), view(out.traceIndex), view(out.cfg),
+                         ShmWaitMs) &&
+      !shm->warnedDrop && !Quiet) {
+    errs() << "Dropped " << fn << " from the shared-memory ring (larger than "
+           << "-public-data-shm-mb or -public-data-shm-wait-ms expired)\n";
+    shm->warnedDrop = true;
+  }
+#endif
+}
+
+// Append a rendered function to the shared streams, rebasing its binary
+// index spans on the trace's current offset, to the open shard and to the
+// shared-memory ring.
+static void commitFunctionOutput(const Function &F, const FunctionOutput &out) {
+  StringRef fn = F.getName();
+  OutputFile *traceFile = getTraceFile();
+  raw_ostream *trace = traceFile ? &traceFile->stream() : nullptr;
+  raw_ostream *traceIndex = getTraceIndexStream();
+  raw_ostream *cfg = getCfgStream();
+  errs() << out.log;
+  if (TraceIndexBinWriter *binIndex = getTraceIndexBinWriter()) {
+    binIndex->addFunction(fn, trace->tell(), traceFile->frameOffset(),
+                          traceFile->frameLogicalOffset(), out.spans);
+  }
+  if (trace) *trace << out.trace;
+  if (traceIndex) *traceIndex << out.traceIndex;
+  if (cfg) *cfg << out.cfg;
+  endOutputFrames();
+  if (ShardWriter *shards = getShardWriter()) shards->add(F, out);
+  publishFunctionOutput(F, out);
+}
+
+// Function cache (-public-data-cache-dir). Entries are keyed by the SHA-1
+// of everything a function's records depend on: its printed IR, the
+// globals and callee declarations it references, the data layout, the
+// enabled streams and every option below that shapes records. Bump
+// CacheVersion whenever the pass's output changes without a schema bump;
+// entries from another version are simply never looked up.
+static constexpr unsigned CacheVersion = 3;
+static constexpr unsigned CacheManifestVersion = 1;
+
+static std::unique_ptr<OutputFile> CacheManifestFile;
+
+// Open (or return) the cache manifest stream. Returns nullptr if disabled.
+static raw_ostream *getCacheManifestStream() {
+  OutputFile *file =
+    getOutputFile(CacheManifestFile, CacheManifestOut, "cache manifest",
+                  "cache_manifest", CacheManifestVersion);
+  return file ? &file->stream() : nullptr;
+}
+
+// Which streams functions are rendered for: the single-file options, and
+// every stream when shards are written or functions are published.
+static bool renderAll() { return !ShardDir.empty() || !ShmName.empty(); }
+static bool renderTrace() { return !TraceOut.empty() || renderAll(); }
+static bool renderTraceIndex() {
+  return !TraceIndexOut.empty() || renderAll();
+}
+static bool renderCfg() { return !CfgOut.empty() || renderAll(); }
+
+static bool cacheEnabled() {
+  return !CacheDir.empty() || !CacheManifestOut.empty();
+}
+
+// Whether entries are read and written. perf records time the render they
+// close, so a stored copy would replay another run's timings: with
+// -public-data-perf every function is rendered, though the manifest still
+// lists its key (as a miss).
+static bool cacheEntriesEnabled() { return !CacheDir.empty() && !EmitPerf; }
+
+// Print the declaration-level facts of a global F references: variables
+// with their initializer, functions and aliases by type and attributes.
+static void printCacheGlobal(raw_ostream &os, const GlobalValue &GV) {
+  if (auto *GVar = dyn_cast<GlobalVariable>(&GV)) {
+    GVar->print(os);
+  } else if (auto *Callee = dyn_cast<Function>(&GV)) {
+    os << "declare " << Callee->getName() << " ";
+    Callee->getFunctionType()->print(os);
+    os << " " << Callee->getAttributes().getFnAttrs().getAsString();
+  } else {
+    os << GV.getName() << " ";
+    GV.getValueType()->print(os);
+  }
+  os << "\n";
+}
+
+static std::string functionCacheKey(const Function &F) {
+  std::string material;
+  raw_string_ostream os(material);
+  os << "ct-publicness function cache " << CacheVersion << " llvm "
+     << LLVM_VERSION_STRING << " schema " << TraceSchemaVersion << "."
+     << CfgSchemaVersion << "\n";
+  // Compression, threads and logging do not change records.
+  os << "streams " << renderTrace() << renderTraceIndex()
+     << !TraceIndexBinOut.empty() << renderCfg() << "\n";
+  os << "trace-format " << columnarTrace() << " trace-types " << TraceTypes
+     << " max-inst " << MaxInst
+     << " max-paths " << MaxPaths << " max-path-depth " << MaxPathDepth
+     << " max-loop-iters " << MaxLoopIters << " path-count-max-states "
+     << PathCountMaxStates << " fn-time-budget-ms " << FnTimeBudgetMs
+     << " fn-mem-budget-mb " << FnMemBudgetMb << " prune-correlated "
+     << PruneCorrelated << " prune-ranges " << PruneRanges
+     << " path-cond-format " << PathCondFormat
+     << " cond-table " << CondTable << " path-encoding " << PathEncoding
+     << " path-mode " << PathMode << " path-order " << PathOrder
+     << " dedup-paths " << DedupPaths << " static-public " << StaticPublic
+     << " path-slice " << PathSlice << " loops " << EmitLoops << " mem-ssa "
+     << EmitMemSSA << " perf " << EmitPerf << " pp-seq " << IncludePpSeq
+     << " pp-coverage " << EmitPpCoverage << " pp-coverage-format "
+     << PpCoverageFormat << " max-pp-path-ids " << MaxPpPathIds
+     << " intern-ids " << InternIds;
+  for (const std::string &arg : PublicArgs) os << " public-arg " << arg;
+  os << "\n" << F.getParent()->getDataLayoutStr() << "\n";
+
+  // Globals reached from F's operands, including through constant
+  // expressions, in first-use order.
+  SmallPtrSet<const Constant *, 32> seen;
+  SmallVector<const Constant *, 16> worklist;
+  for (const Instruction &I : instructions(F)) {
+    for (const Value *Op : I.operands()) {
+      auto *C = dyn_cast<Constant>(Op);
+      if (C && seen.insert(C).second) worklist.push_back(C);
+    }
+  }
+  for (size_t i = 0; i < worklist.size(); ++i) {
+    const Constant *C = worklist[i];
+    if (auto *GV = dyn_cast<GlobalValue>(C)) {
+      printCacheGlobal(os, *GV);
+      continue;
+    }
+    for (const Value *Op : C->operands()) {
+      auto *OpC = dyn_cast<Constant>(Op);
+      if (OpC && seen.insert(OpC).second) worklist.push_back(OpC);
+    }
+  }
+  os << F.getAttributes().getFnAttrs().getAsString() << "\n";
+  F.print(os);
+  os.flush();
+  return toHex(SHA1::hash(arrayRefFromStringRef(material)), true);
+}
+
+static std::string cacheEntryPath(StringRef key) {
+  SmallString<256> path(CacheDir);
+  sys::path::append(path, key + ".fn");
+  return std::string(path);
+}
+
+// Cache entries hold one FunctionOutput minus its log, little-endian:
+//   "CTPFNC01", u32 CacheVersion, then u64 length + bytes for the trace,
+//   trace index and CFG records, u32 path_records, then u64 symtab_offset,
+//   u32 symtab_length, u64 span_count and span_count x
+//   {u32 pp, u64 offset, u32 length}.
+static bool loadCachedFunction(StringRef fn, StringRef key,
+                               FunctionOutput &out) {
+  if (!cacheEntriesEnabled()) return false;
+  auto buf = MemoryBuffer::getFile(cacheEntryPath(key));
+  if (!buf) return false;
+  StringRef data = (*buf)->getBuffer();
+  bool ok = true;
+  auto readLE = [&](unsigned bytes) {
+    uint64_t v = 0;
+    if (data.size() < bytes) {
+      ok = false;
+      return v;
+    }
+    for (unsigned i = 0; i < bytes; ++i) {
+      v |= uint64_t(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    data = data.drop_front(bytes);
+    return v;
+  };
+  auto readBlob = [&](std::string &blob) {
+    uint64_t len = readLE(8);
+    if (!ok || data.size() < len) {
+      ok = false;
+      return;
+    }
+    blob = data.take_front(len).str();
+    data = data.drop_front(len);
+  };
+  if (!data.consume_front("CTPFNC01") || readLE(4) != CacheVersion) {
+    return false;
+  }
+  FunctionOutput loaded;
+  readBlob(loaded.trace);
+  readBlob(loaded.traceIndex);
+  readBlob(loaded.cfg);
+  loaded.pathRecords = readLE(4);
+  loaded.spans.symtabOffset = readLE(8);
+  loaded.spans.symtabLength = readLE(4);
+  uint64_t spanCount = readLE(8);
+  if (!ok || data.size() != spanCount * 16) return false;
+  loaded.spans.spans.reserve(spanCount);
+  for (uint64_t i = 0; i < spanCount; ++i) {
+    TraceSpan sp;
+    sp.pp = readLE(4);
+    sp.offset = readLE(8);
+    sp.length = readLE(4);
+    loaded.spans.spans.push_back(sp);
+  }
+  if (!Quiet) {
+    loaded.log = ("== PublicDataPass on function: " + fn + " (cached) ==\n").str();
+  }
+  out = std::move(loaded);
+  return true;
+}
+
+// Write an entry through a temporary file and a rename, so concurrent runs
+// sharing the directory never read a partial entry.
+static void storeCachedFunction(StringRef key, const FunctionOutput &out) {
+  if (!cacheEntriesEnabled()) return;
+  if (std::error_code ec = sys::fs::create_directories(CacheDir)) {
+    errs() << "Failed to create cache directory: " << ec.message() << "\n";
+    return;
+  }
+  SmallString<256> model(CacheDir);
+  sys::path::append(model, key + "-%%%%%%%%.tmp");
+  int fd;
+  SmallString<256> tmpPath;
+  if (sys::fs::createUniqueFile(model, fd, tmpPath)) return;
+  {
+    raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << "CTPFNC01";
+    writeLE(os, CacheVersion, 4);
+    for (const std::string *blob : {&out.trace, &out.traceIndex, &out.cfg}) {
+      writeLE(os, blob->size(), 8);
+      os << *blob;
+    }
+    writeLE(os, out.pathRecords, 4);
+    writeLE(os, out.spans.symtabOffset, 8);
+    writeLE(os, out.spans.symtabLength, 4);
+    writeLE(os, out.spans.spans.size(), 8);
+    for (const TraceSpan &sp : out.spans.spans) {
+      writeLE(os, sp.pp, 4);
+      writeLE(os, sp.offset, 8);
+      writeLE(os, sp.length, 4);
+    }
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      sys::fs::remove(tmpPath);
+      return;
+    }
   }
-  return cfg.get();
+  if (sys::fs::rename(tmpPath, cacheEntryPath(key))) sys::fs::remove(tmpPath);
+}
+
+// Record fn's cache key in the manifest, so symex can reuse its results
+// for functions whose key it has seen before.
+static void emitCacheManifestEntry(StringRef fn, StringRef key, bool hit) {
+  raw_ostream *os = getCacheManifestStream();
+  if (!os) return;
+  *os << "{\"kind\":\"cache_entry\",\"fn\":";
+  emitJsonString(*os, fn);
+  *os << ",\"key\":\"" << key << "\",\"hit\":" << (hit ? "true" : "false")
+      << "}\n";
 }
 
 // Emit a JSON array of strings.
@@ -211,16 +1351,16 @@ static std::string typeToString(const Type *Ty) {
   return os.str();
 }
 
-// Print transmitter info to stderr for debugging.
-static void printTransmitter(const Instruction &I, StringRef kind,
-                             const Value *operand) {
-  errs() << "  [TX] " << kind << " @ " << I.getFunction()->getName() << " : ";
-  I.print(errs());
-  errs() << "\n";
-  errs() << "      operand: ";
-  if (operand) operand->print(errs());
-  else errs() << "<null>";
-  errs() << "\n";
+// Print transmitter info to the debug log.
+static void printTransmitter(raw_ostream &log, const Instruction &I,
+                             StringRef kind, const Value *operand) {
+  log << "  [TX] " << kind << " @ " << I.getFunction()->getName() << " : ";
+  I.print(log);
+  log << "\n";
+  log << "      operand: ";
+  if (operand) operand->print(log);
+  else log << "<null>";
+  log << "\n";
 }
 
 // Transmitter metadata (kind and operand index).
@@ -331,56 +1471,227 @@ static std::string getConstantId(const Constant &C) {
   return "const:" + std::string(os.str());
 }
 
-// Convert an LLVM Value to a stable ID string.
-static std::string getValueId(const Value *V,
-                              DenseMap<const Value *, std::string> &ids,
-                              unsigned &nextId) {
-  if (auto *C = dyn_cast<Constant>(V)) {
-    return getConstantId(*C);
-  }
-  if (auto *A = dyn_cast<Argument>(V)) {
-    if (A->hasName()) return A->getName().str();
-    return "arg" + std::to_string(A->getArgNo());
+// Per-function ids for program points, blocks and SSA values.
+// By default ids render as JSON strings ("fn:bb:iN", block labels, value ids).
+// With -public-data-intern-ids they render as dense integers indexing the
+// per-function symtab record instead.
+class FunctionIds {
+public:
+  FunctionIds(const Function &F, bool intern) : fnName(F.getName()),
+                                                intern(intern) {
+    labelsPlain = isJsonPlain(fnName);
+    for (const BasicBlock &BB : F) {
+      unsigned idx = bbLabels.size();
+      bbIndex[&BB] = idx;
+      bbLabels.push_back(BB.hasName() ? BB.getName().str()
+                                      : ("bb" + std::to_string(idx)));
+      if (labelsPlain) labelsPlain = isJsonPlain(bbLabels.back());
+      bbFirstPP.push_back(ppCount);
+      int instIndex = 0;
+      for (const Instruction &I : BB) {
+        ppIndex[&I] = ppCount++;
+        if (!intern) {
+          ppLabels.push_back(
+            programPointLabel(fnName, bbLabels.back(), instIndex));
+        }
+        instIndex++;
+      }
+    }
   }
-  if (V->hasName()) return V->getName().str();
 
-  auto it = ids.find(V);
-  if (it != ids.end()) return it->second;
-  std::string id = "v" + std::to_string(nextId++);
-  ids[V] = id;
-  return id;
-}
-
-// Build a string constraint for the switch default branch.
-static std::string buildSwitchDefaultCond(
-  const SwitchInst &SI,
-  const std::string &condId,
-  DenseMap<const Value *, std::string> &ids,
-  unsigned &nextId) {
-  std::string s;
-  for (auto &Case : SI.cases()) {
-    std::string caseVal = getValueId(Case.getCaseValue(), ids, nextId);
-    if (!s.empty()) s += " && ";
-    s += condId;
-    s += "!=";
-    s += caseVal;
+  bool interned() const { return intern; }
+  unsigned bbCount() const { return bbLabels.size(); }
+  unsigned ppTotal() const { return ppCount; }
+  unsigned ppId(const Instruction *I) const { return ppIndex.lookup(I); }
+  unsigned bbId(const BasicBlock *BB) const { return bbIndex.lookup(BB); }
+  // Blocks own contiguous pp ids, starting here.
+  unsigned bbFirstPpId(unsigned bb) const { return bbFirstPP[bb]; }
+  const std::string &bbLabel(const BasicBlock *BB) const {
+    return bbLabels[bbIndex.lookup(BB)];
   }
-  if (s.empty()) {
-    s = condId + "!=<any>";
+  // String pp label; only stored when ids are not interned.
+  StringRef ppLabel(const Instruction *I) const {
+    return ppLabels[ppIndex.lookup(I)];
   }
-  return s;
+
+  // Print "fn:bb:iN" for an instruction in either mode.
+  void printPP(raw_ostream &os, const Instruction *I) const {
+    if (!intern) {
+      os << ppLabel(I);
+      return;
+    }
+    unsigned bb = bbIndex.lookup(I->getParent());
+    os << fnName << ":" << bbLabels[bb] << ":i"
+       << (ppIndex.lookup(I) - bbFirstPP[bb]);
+  }
+
+  // Convert an LLVM Value to a stable ID string. PHI block operands use the
+  // block label.
+  std::string valueId(const Value *V) {
+    if (auto *C = dyn_cast<Constant>(V)) {
+      return getConstantId(*C);
+    }
+    if (auto *A = dyn_cast<Argument>(V)) {
+      if (A->hasName()) return A->getName().str();
+      return "arg" + std::to_string(A->getArgNo());
+    }
+    if (auto *BB = dyn_cast<BasicBlock>(V)) return bbLabel(BB);
+    if (V->hasName()) return V->getName().str();
+
+    auto it = valueIds.find(V);
+    if (it != valueIds.end()) return it->second;
+    std::string id = "v" + std::to_string(nextValueId++);
+    valueIds[V] = id;
+    return id;
+  }
+
+  // Dense symtab index for a value (interned mode).
+  unsigned valueIndex(const Value *V) {
+    auto it = valueIndices.find(V);
+    if (it != valueIndices.end()) return it->second;
+    unsigned idx = valueStrings.size();
+    valueStrings.push_back(valueId(V));
+    valueIndices[V] = idx;
+    return idx;
+  }
+
+  // Assign value indices in trace order (args, then each instruction's def
+  // and operands) so the symtab is complete before any record uses it.
+  void internFunction(const Function &F) {
+    for (const Argument &A : F.args()) valueIndex(&A);
+    for (const BasicBlock &BB : F) {
+      for (const Instruction &I : BB) {
+        if (!I.getType()->isVoidTy()) valueIndex(&I);
+        bool isPhi = isa<PHINode>(I);
+        for (const Use &U : I.operands()) {
+          if (isa<BasicBlock>(U.get()) && !isPhi) continue;
+          valueIndex(U.get());
+        }
+      }
+    }
+  }
+
+  // Labels are checked once at construction; when the function and block
+  // names need no escaping, neither does any pp or bb label.
+  void emitPP(raw_ostream &os, const Instruction *I) const {
+    if (intern) os << ppId(I);
+    else if (labelsPlain) os << '"' << ppLabel(I) << '"';
+    else emitJsonString(os, ppLabel(I));
+  }
+  void emitBB(raw_ostream &os, const BasicBlock *BB) const {
+    if (intern) os << bbIndex.lookup(BB);
+    else if (labelsPlain) os << '"' << bbLabel(BB) << '"';
+    else emitJsonString(os, bbLabel(BB));
+  }
+  void emitFn(raw_ostream &os) const {
+    if (labelsPlain) os << '"' << fnName << '"';
+    else emitJsonString(os, fnName);
+  }
+  void emitValue(raw_ostream &os, const Value *V) {
+    if (intern) {
+      os << valueIndex(V);
+    } else if (!isa<Constant>(V) && V->hasName()) {
+      // Same id valueId() returns, without copying the name.
+      emitJsonString(os, V->getName());
+    } else {
+      emitJsonString(os, valueId(V));
+    }
+  }
+
+  // Entries in the value id tables (unnamed-value ids, symtab values).
+  size_t valueIdCount() const { return valueIds.size(); }
+  size_t symtabValueCount() const { return valueStrings.size(); }
+
+  // Emit the per-function symtab record (interned mode only).
+  void emitSymtab(raw_ostream &os, const Function &F) const {
+    os << "{";
+    os << "\"kind\":\"symtab\",\"fn\":";
+    emitJsonString(os, fnName);
+    os << ",\"bbs\":";
+    emitJsonStringArray(os, bbLabels);
+    os << ",\"pps\":[";
+    bool first = true;
+    for (const BasicBlock &BB : F) {
+      for (const Instruction &I : BB) {
+        if (!first) os << ",";
+        first = false;
+        os << "\"";
+        printPP(os, &I);
+        os << "\"";
+      }
+    }
+    os << "],\"values\":";
+    emitJsonStringArray(os, valueStrings);
+    os << "}\n";
+  }
+
+private:
+  StringRef fnName;
+  bool intern;
+  DenseMap<const BasicBlock *, unsigned> bbIndex;
+  std::vector<std::string> bbLabels;
+  std::vector<unsigned> bbFirstPP;
+  bool labelsPlain = true;
+  DenseMap<const Instruction *, unsigned> ppIndex;
+  std::vector<std::string> ppLabels;
+  unsigned ppCount = 0;
+  DenseMap<const Value *, std::string> valueIds;
+  unsigned nextValueId = 0;
+  DenseMap<const Value *, unsigned> valueIndices;
+  std::vector<std::string> valueStrings;
+};
+
+// One NDJSON record: the constructor writes {"kind":...,"fn":..., field()
+// the key of each later member, and the destructor the closing brace. Keys
+// are literals, written without an escape scan.
+class JsonRecord {
+public:
+  JsonRecord(raw_ostream &os, StringLiteral kind, const FunctionIds &ids)
+      : os(os) {
+    os << "{\"kind\":\"" << kind << "\",\"fn\":";
+    ids.emitFn(os);
+  }
+  JsonRecord(const JsonRecord &) = delete;
+  JsonRecord &operator=(const JsonRecord &) = delete;
+  ~JsonRecord() { os << "}\n"; }
+
+  raw_ostream &field(StringLiteral key) {
+    return os << ",\"" << key << "\":";
+  }
+
+private:
+  raw_ostream &os;
+};
+
+// Build a string constraint for the switch default branch.
+static std::string buildSwitchDefaultCond(const SwitchInst &SI,
+                                          const std::string &condId,
+                                          FunctionIds &ids) {
+  std::string s;
+  for (auto &Case : SI.cases()) {
+    std::string caseVal = ids.valueId(Case.getCaseValue());
+    if (!s.empty()) s += " && ";
+    s += condId;
+    s += "!=";
+    s += caseVal;
+  }
+  if (s.empty()) {
+    s = condId + "!=<any>";
+  }
+  return s;
 }
 
-// Decision metadata for a branch along a path.
+// Decision metadata for a branch along a path. Ids are rendered through
+// FunctionIds at emission time.
 struct Decision {
-  std::string pp;
-  std::string kind;
-  std::string cond;
-  std::string succ;
-  std::string sense;
-  std::string caseValue;
+  const Instruction *term = nullptr;
+  const char *kind = nullptr;
+  const BasicBlock *succ = nullptr;
+  const Value *cond = nullptr;
+  const char *sense = nullptr;
+  const Value *caseValue = nullptr;
   bool isDefault = false;
-  std::string target;
+  const Value *target = nullptr;
 };
 
 // Structured condition expression for JSON path conditions.
@@ -430,203 +1741,1731 @@ static void emitCondExpr(raw_ostream &os, const CondExpr &e) {
 }
 
 // Emit a JSON decision record to the output stream.
-static void emitDecision(raw_ostream &os, const Decision &d) {
+static void emitDecision(raw_ostream &os, const Decision &d, FunctionIds &ids) {
   os << "{";
   os << "\"pp\":";
-  emitJsonString(os, d.pp);
+  ids.emitPP(os, d.term);
   os << ",\"kind\":";
   emitJsonString(os, d.kind);
   os << ",\"succ\":";
-  emitJsonString(os, d.succ);
-  if (!d.cond.empty()) {
+  ids.emitBB(os, d.succ);
+  if (d.cond) {
     os << ",\"cond\":";
-    emitJsonString(os, d.cond);
+    ids.emitValue(os, d.cond);
   }
-  if (!d.sense.empty()) {
+  if (d.sense) {
     os << ",\"sense\":";
     emitJsonString(os, d.sense);
   }
-  if (!d.caseValue.empty()) {
+  if (d.caseValue) {
     os << ",\"case\":";
-    emitJsonString(os, d.caseValue);
+    ids.emitValue(os, d.caseValue);
   }
   if (d.isDefault) {
     os << ",\"default\":true";
   }
-  if (!d.target.empty()) {
+  if (d.target) {
     os << ",\"target\":";
-    emitJsonString(os, d.target);
+    ids.emitValue(os, d.target);
   }
   os << "}";
 }
 
-// Emit a trace index record (pp -> trace line).
-static void emitTraceIndexRecord(raw_ostream &os, StringRef fn, StringRef bb,
-                                 StringRef pp, StringRef op, StringRef defId,
-                                 unsigned line) {
-  os << "{";
-  os << "\"kind\":\"trace_index\",\"fn\":";
-  emitJsonString(os, fn);
-  os << ",\"bb\":";
-  emitJsonString(os, bb);
-  os << ",\"pp\":";
-  emitJsonString(os, pp);
-  os << ",\"op\":";
-  emitJsonString(os, op);
-  os << ",\"def\":";
-  if (!defId.empty()) emitJsonString(os, defId);
-  else os << "null";
-  os << ",\"line\":" << line;
-  os << "}\n";
+// Render the string path condition for a decision.
+static std::string buildDecisionCond(const Decision &d, FunctionIds &ids) {
+  if (d.target) {
+    return ids.valueId(d.target) + "==label:" + ids.bbLabel(d.succ);
+  }
+  std::string condId = ids.valueId(d.cond);
+  if (d.sense) {
+    return condId + "==" +
+           (StringRef(d.sense) == "true" ? "const:i1:1" : "const:i1:0");
+  }
+  if (d.isDefault) {
+    return buildSwitchDefaultCond(cast<SwitchInst>(*d.term), condId, ids);
+  }
+  return condId + "==" + ids.valueId(d.caseValue);
 }
 
-struct PublicDataPass : PassInfoMixin<PublicDataPass> {
-  static bool isRequired() { return true; }  // <--- add this
+// Render the JSON path condition for a decision.
+static CondExpr buildDecisionCondExpr(const Decision &d, FunctionIds &ids) {
+  if (d.target) {
+    return makeCmp("==", ids.valueId(d.target), "label:" + ids.bbLabel(d.succ));
+  }
+  std::string condId = ids.valueId(d.cond);
+  if (d.sense) {
+    return makeCmp("==", condId,
+                   StringRef(d.sense) == "true" ? "const:i1:1" : "const:i1:0");
+  }
+  if (!d.isDefault) return makeCmp("==", condId, ids.valueId(d.caseValue));
+  std::vector<CondExpr> terms;
+  for (auto &Case : cast<SwitchInst>(*d.term).cases()) {
+    terms.push_back(makeCmp("!=", condId, ids.valueId(Case.getCaseValue())));
+  }
+  if (terms.empty()) return makeCmp("!=", condId, "<any>");
+  if (terms.size() == 1) return terms[0];
+  return makeAnd(std::move(terms));
+}
 
-  // Main pass entry point: emits trace and CFG records for one function.
-  PreservedAnalyses run(Function &F, FunctionAnalysisManager &) {
-    bool quiet = Quiet;
-    bool verbose = Verbose && !Quiet;
+// Blocks that matter to transmitter evaluation, indexed by bb id: blocks
+// holding a transmitter, a side effect or a return, or defining a value in
+// the backward def-use closure of their operands (branch/switch conditions
+// are transmitters, so path conditions are covered). A phi in the closure
+// also marks its incoming blocks, since the edge taken selects its value.
+// Paths visiting the same sequence of these blocks differ only in arms that
+// cannot change any transmitter operand.
+static std::vector<bool> txRelevantBlocks(const Function &F,
+                                          const FunctionIds &ids) {
+  std::vector<bool> relevant(ids.bbCount(), false);
+  SmallPtrSet<const Instruction *, 32> seen;
+  SmallVector<const Instruction *, 64> work;
+  auto addValue = [&](const Value *V) {
+    if (auto *I = dyn_cast<Instruction>(V)) {
+      if (seen.insert(I).second) work.push_back(I);
+    }
+  };
+  for (const BasicBlock &BB : F) {
+    for (const Instruction &I : BB) {
+      std::vector<TxInfo> txs = getTransmitterInfos(I);
+      bool root = I.mayHaveSideEffects() || isa<ReturnInst>(I);
+      if (txs.empty() && !root) continue;
+      relevant[ids.bbId(&BB)] = true;
+      if (root) {
+        for (const Use &U : I.operands()) addValue(U.get());
+      }
+      for (const TxInfo &tx : txs) {
+        if (tx.operandIndex >= 0 &&
+            tx.operandIndex < static_cast<int>(I.getNumOperands())) {
+          addValue(I.getOperand(tx.operandIndex));
+        }
+      }
+    }
+  }
+  while (!work.empty()) {
+    const Instruction *I = work.pop_back_val();
+    relevant[ids.bbId(I->getParent())] = true;
+    for (const Use &U : I->operands()) addValue(U.get());
+    if (auto *PN = dyn_cast<PHINode>(I)) {
+      for (const BasicBlock *In : PN->blocks()) relevant[ids.bbId(In)] = true;
+    }
+  }
+  return relevant;
+}
 
-    if (!quiet) {
-      errs() << "== PublicDataPass on function: " << F.getName() << " ==\n";
+// Backward def-use slice of one path: the instructions on it that hold a
+// transmitter, a side effect or a terminator (so every block keeps one
+// instruction and consumers can still tell which predecessor a phi came
+// from), plus every instruction instance whose value flows into them along
+// the path. Phis follow only the incoming value of the predecessor the
+// path came from, and a block's phis are one parallel copy: a phi reading
+// another phi of its block reads the previous visit's instance. Returns a
+// per-pp membership vector.
+static std::vector<bool> pathSlice(ArrayRef<const BasicBlock *> path,
+                                   const FunctionIds &ids) {
+  std::vector<bool> inSlice(ids.ppTotal(), false);
+  SmallPtrSet<const Value *, 32> needed;
+  SmallVector<const PHINode *, 8> livePhis;
+  for (size_t k = path.size(); k-- > 0;) {
+    const BasicBlock *BB = path[k];
+    const BasicBlock *pred = k > 0 ? path[k - 1] : nullptr;
+    for (auto it = BB->rbegin(); it != BB->rend(); ++it) {
+      const Instruction &I = *it;
+      if (isa<PHINode>(I)) break;
+      std::vector<TxInfo> txs = getTransmitterInfos(I);
+      bool root = !txs.empty() || I.mayHaveSideEffects() || I.isTerminator();
+      // Each instance defines its value afresh; earlier instances only
+      // matter if something before this point needs them again.
+      bool live = needed.erase(&I);
+      if (!root && !live) continue;
+      inSlice[ids.ppId(&I)] = true;
+      for (const Use &U : I.operands()) {
+        if (isa<Instruction>(U.get())) needed.insert(U.get());
+      }
+    }
+    // Retire every live phi before adding any incoming value, so one
+    // phi's incoming value is not taken for another's use on this visit.
+    livePhis.clear();
+    for (const PHINode &PN : BB->phis()) {
+      if (needed.erase(&PN)) livePhis.push_back(&PN);
+    }
+    if (pred) {
+      for (const PHINode *PN : livePhis) {
+        int idx = PN->getBasicBlockIndex(pred);
+        if (idx >= 0) needed.insert(PN->getIncomingValue(idx));
+      }
     }
+    for (const PHINode *PN : livePhis) inSlice[ids.ppId(PN)] = true;
+  }
+  return inSlice;
+}
 
-    DenseMap<const BasicBlock *, unsigned> bbIndex;
-    DenseMap<const BasicBlock *, std::string> bbLabels;
-    unsigned bbCounter = 0;
-    for (auto &BB : F) {
-      bbIndex[&BB] = bbCounter++;
-      std::string label =
-        BB.hasName() ? BB.getName().str()
-                     : ("bb" + std::to_string(bbIndex[&BB]));
-      bbLabels[&BB] = label;
+// Whether -public-data-public-arg names argument A.
+static bool isPublicArg(const Argument &A) {
+  StringRef fn = A.getParent()->getName();
+  for (const std::string &spec : PublicArgs) {
+    StringRef specFn, specArg;
+    std::tie(specFn, specArg) = StringRef(spec).split(':');
+    if (specFn != "*" && specFn != fn) continue;
+    unsigned idx = 0;
+    if (!specArg.getAsInteger(10, idx) ? idx == A.getArgNo()
+                                       : specArg == A.getName()) {
+      return true;
     }
+  }
+  return false;
+}
 
-    DenseMap<const Value *, std::string> valueIds;
-    unsigned nextValueId = 0;
-    std::vector<std::string> argIds;
-    argIds.reserve(F.arg_size());
-    for (const Argument &A : F.args()) {
-      argIds.push_back(getValueId(&A, valueIds, nextValueId));
+// Static publicness lattice, ordered for join: a value is Const when
+// computed purely from constants, PublicArg when public arguments also
+// feed it, and Unknown once memory, calls or other arguments do.
+enum class StaticClass : uint8_t { Unvisited, Const, PublicArg, Unknown };
+
+// Forward dataflow over SSA for -public-data-static-public. Pure
+// instructions join their operands and phis join their incoming values
+// (two executions on the same path take the same edge), iterated to a
+// fixpoint from Unvisited so loop induction variables stay Const. Const
+// and PublicArg values are identical in any two executions of one path.
+static DenseMap<const Value *, StaticClass>
+computeStaticClasses(const Function &F) {
+  DenseMap<const Value *, StaticClass> cls;
+  for (const Argument &A : F.args()) {
+    cls[&A] = isPublicArg(A) ? StaticClass::PublicArg : StaticClass::Unknown;
+  }
+  auto classOf = [&](const Value *V) {
+    if (isa<UndefValue>(V)) return StaticClass::Unknown;
+    if (isa<Constant>(V)) return StaticClass::Const;
+    auto it = cls.find(V);
+    return it == cls.end() ? StaticClass::Unvisited : it->second;
+  };
+  auto isPure = [](const Instruction &I) {
+    return isa<BinaryOperator>(I) || isa<CastInst>(I) || isa<CmpInst>(I) ||
+           isa<SelectInst>(I) || isa<GetElementPtrInst>(I) ||
+           isa<PHINode>(I) || isa<ExtractValueInst>(I) ||
+           isa<InsertValueInst>(I) || isa<ExtractElementInst>(I) ||
+           isa<InsertElementInst>(I) || isa<ShuffleVectorInst>(I) ||
+           isa<UnaryOperator>(I);
+  };
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const BasicBlock &BB : F) {
+      for (const Instruction &I : BB) {
+        if (I.getType()->isVoidTy()) continue;
+        StaticClass c = StaticClass::Unknown;
+        if (isPure(I)) {
+          c = StaticClass::Unvisited;
+          for (const Use &U : I.operands()) {
+            c = std::max(c, classOf(U.get()));
+          }
+        }
+        StaticClass &slot = cls[&I];
+        if (c > slot) {
+          slot = c;
+          changed = true;
+        }
+      }
     }
-    DenseMap<const Instruction *, std::string> instPP;
-    DenseMap<const BasicBlock *, std::vector<std::string>> bbPpSeq;
-    DenseMap<const BasicBlock *, std::string> termPP;
-    unsigned instCount = 0;
-    unsigned txCount = 0;
-    unsigned traceEmitted = 0;
-    bool traceTruncated = false;
-    unsigned traceLine = 0;
+  }
+  return cls;
+}
 
-    raw_fd_ostream *trace = getTraceStream();
-    raw_fd_ostream *traceIndex = getTraceIndexStream();
-    raw_fd_ostream *cfg = getCfgStream();
-    bool emitCondStr = true;
-    bool emitCondJson = false;
+// One in-loop load or store and the SCEV of its address.
+struct LoopAccess {
+  const Instruction *inst;
+  const Value *addr;
+  const SCEV *addrScev;
+  bool invariant;  // address does not change across iterations
+};
 
-    StringRef fmt = PathCondFormat;
-    if (fmt == "json") {
-      emitCondStr = false;
-      emitCondJson = true;
-    } else if (fmt == "both") {
-      emitCondStr = true;
-      emitCondJson = true;
-    } else if (fmt == "string") {
-      emitCondStr = true;
-      emitCondJson = false;
-    } else if (!fmt.empty()) {
-      if (!quiet) {
-        errs() << "Unknown -public-data-path-cond-format: " << fmt
-               << " (defaulting to string)\n";
+// Structure and ScalarEvolution facts of one natural loop for
+// -public-data-loops. SCEV queries intern new expressions in the context,
+// so summarizeLoops runs on the thread that owns the analyses and
+// emitFunction only walks the results.
+struct LoopSummary {
+  const BasicBlock *header;
+  int parent;  // index of the enclosing loop, -1 at top level
+  unsigned depth;
+  SmallVector<const BasicBlock *, 4> latches;
+  SmallVector<const BasicBlock *, 4> exiting;
+  SmallVector<const BasicBlock *, 4> exits;
+  std::vector<const BasicBlock *> blocks;  // function order
+  const PHINode *indVar = nullptr;
+  const SCEVAddRecExpr *indVarRec = nullptr;
+  unsigned tripCount = 0;  // 0 unless a small constant
+  const SCEV *backedgeTaken = nullptr;  // null if not computable
+  std::vector<LoopAccess> accesses;  // loads/stores whose innermost loop this is
+};
+
+// Loops of F in preorder (parents before children). The induction variable
+// is the canonical one if present, else LoopInfo's, else the first header
+// phi that is an affine recurrence of the loop.
+static std::vector<LoopSummary> summarizeLoops(Function &F, LoopInfo &LI,
+                                               ScalarEvolution &SE) {
+  std::vector<LoopSummary> out;
+  DenseMap<const Loop *, int> index;
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    LoopSummary S;
+    S.header = L->getHeader();
+    Loop *P = L->getParentLoop();
+    S.parent = P ? index.lookup(P) : -1;
+    S.depth = L->getLoopDepth();
+    SmallVector<BasicBlock *, 4> bbs;
+    L->getLoopLatches(bbs);
+    S.latches.append(bbs.begin(), bbs.end());
+    bbs.clear();
+    L->getExitingBlocks(bbs);
+    S.exiting.append(bbs.begin(), bbs.end());
+    bbs.clear();
+    L->getUniqueExitBlocks(bbs);
+    S.exits.append(bbs.begin(), bbs.end());
+    for (const BasicBlock &BB : F) {
+      if (L->contains(&BB)) S.blocks.push_back(&BB);
+    }
+
+    const PHINode *iv = L->getCanonicalInductionVariable();
+    if (!iv) iv = L->getInductionVariable(SE);
+    for (const PHINode &PN : S.header->phis()) {
+      if (iv) break;
+      if (!SE.isSCEVable(PN.getType())) continue;
+      auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(const_cast<PHINode *>(&PN)));
+      if (AR && AR->getLoop() == L && AR->isAffine()) iv = &PN;
+    }
+    if (iv && SE.isSCEVable(iv->getType())) {
+      auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(const_cast<PHINode *>(iv)));
+      if (AR && AR->getLoop() == L) {
+        S.indVar = iv;
+        S.indVarRec = AR;
       }
-      emitCondStr = true;
-      emitCondJson = false;
     }
+    S.tripCount = SE.getSmallConstantTripCount(L);
+    const SCEV *btc = SE.getBackedgeTakenCount(L);
+    if (!isa<SCEVCouldNotCompute>(btc)) S.backedgeTaken = btc;
 
-    for (auto &BB : F) {
-      std::string bbLabel = bbLabels[&BB];
-      int idx = 0;
-      for (auto &I : BB) {
-        std::string pp =
-          programPointLabel(F.getName(), bbLabel, idx);
-        instPP[&I] = pp;
-        bbPpSeq[&BB].push_back(pp);
-        if (I.isTerminator()) {
-          termPP[&BB] = pp;
-        }
-        if (verbose) {
-          errs() << "PP " << pp << " : ";
-          I.print(errs());
-          errs() << "\n";
-        }
+    for (const BasicBlock *BB : S.blocks) {
+      if (LI.getLoopFor(BB) != L) continue;
+      for (const Instruction &I : *BB) {
+        if (!isa<LoadInst>(I) && !isa<StoreInst>(I)) continue;
+        Value *ptr = const_cast<Value *>(getLoadStorePointerOperand(&I));
+        const SCEV *addr = SE.getSCEV(ptr);
+        S.accesses.push_back({&I, ptr, addr, SE.isLoopInvariant(addr, L)});
+      }
+    }
+    index[L] = out.size();
+    out.push_back(std::move(S));
+  }
+  return out;
+}
 
-        std::vector<TxInfo> txs = getTransmitterInfos(I);
-        if (!txs.empty() && !quiet) {
-          for (const TxInfo &tx : txs) {
-            const Value *op = nullptr;
-            if (tx.operandIndex >= 0 &&
-                tx.operandIndex < static_cast<int>(I.getNumOperands())) {
-              op = I.getOperand(tx.operandIndex);
+// Name and operands of a composite SCEV for loop records, or null for
+// leaves (constants, unknowns) and expressions they do not model.
+static const char *scevOp(const SCEV *S, SmallVectorImpl<const SCEV *> &ops) {
+  const char *op = nullptr;
+  if (auto *N = dyn_cast<SCEVNAryExpr>(S)) {
+    if (isa<SCEVAddExpr>(N)) op = "add";
+    else if (isa<SCEVMulExpr>(N)) op = "mul";
+    else if (isa<SCEVAddRecExpr>(N)) op = "addrec";
+    else if (isa<SCEVSMaxExpr>(N)) op = "smax";
+    else if (isa<SCEVUMaxExpr>(N)) op = "umax";
+    else if (isa<SCEVSMinExpr>(N)) op = "smin";
+    else if (isa<SCEVUMinExpr>(N)) op = "umin";
+    if (op) {
+      for (const SCEV *Op : N->operands()) ops.push_back(Op);
+    }
+  } else if (auto *Cast = dyn_cast<SCEVCastExpr>(S)) {
+    if (isa<SCEVTruncateExpr>(Cast)) op = "trunc";
+    else if (isa<SCEVZeroExtendExpr>(Cast)) op = "zext";
+    else if (isa<SCEVSignExtendExpr>(Cast)) op = "sext";
+    else if (isa<SCEVPtrToIntExpr>(Cast)) op = "ptrtoint";
+    if (op) ops.push_back(Cast->getOperand());
+  } else if (auto *D = dyn_cast<SCEVUDivExpr>(S)) {
+    op = "udiv";
+    ops.push_back(D->getLHS());
+    ops.push_back(D->getRHS());
+  }
+  return op;
+}
+
+static const Value *scevLeafValue(const SCEV *S) {
+  if (auto *C = dyn_cast<SCEVConstant>(S)) return C->getValue();
+  if (auto *U = dyn_cast<SCEVUnknown>(S)) return U->getValue();
+  return nullptr;
+}
+
+// Give every leaf of S a symtab slot. SCEV folds introduce constants that
+// are no instruction's operand, so interned mode needs this before the
+// symtab is written.
+static void internScev(const SCEV *S, FunctionIds &ids) {
+  if (!S) return;
+  if (const Value *V = scevLeafValue(S)) {
+    ids.valueIndex(V);
+    return;
+  }
+  SmallVector<const SCEV *, 4> ops;
+  scevOp(S, ops);
+  for (const SCEV *Op : ops) internScev(Op, ids);
+}
+
+// Structured SCEV rendering for loop records: constants and unknowns are
+// {"value":id}, recurrences {"op":"addrec","loop":header,"ops":[...]},
+// other expressions {"op":name,"ops":[...]}; anything unrecognized falls
+// back to {"op":"other","text":...}.
+static void emitScev(raw_ostream &os, const SCEV *S, FunctionIds &ids) {
+  if (const Value *V = scevLeafValue(S)) {
+    os << "{\"value\":";
+    ids.emitValue(os, V);
+    os << "}";
+    return;
+  }
+  SmallVector<const SCEV *, 4> ops;
+  const char *op = scevOp(S, ops);
+  if (!op) {
+    std::string text;
+    raw_string_ostream ts(text);
+    S->print(ts);
+    os << "{\"op\":\"other\",\"text\":";
+    emitJsonString(os, ts.str());
+    os << "}";
+    return;
+  }
+  os << "{\"op\":\"" << op << "\"";
+  if (auto *AR = dyn_cast<SCEVAddRecExpr>(S)) {
+    os << ",\"loop\":";
+    ids.emitBB(os, AR->getLoop()->getHeader());
+  }
+  os << ",\"ops\":[";
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (i) os << ",";
+    emitScev(os, ops[i], ids);
+  }
+  os << "]}";
+}
+
+static void emitScevOrNull(raw_ostream &os, const SCEV *S, FunctionIds &ids) {
+  if (S) emitScev(os, S, ids);
+  else os << "null";
+}
+
+static void emitBBList(raw_ostream &os, ArrayRef<const BasicBlock *> bbs,
+                       FunctionIds &ids) {
+  os << "[";
+  for (size_t i = 0; i < bbs.size(); ++i) {
+    if (i) os << ",";
+    ids.emitBB(os, bbs[i]);
+  }
+  os << "]";
+}
+
+static void emitLoopRecord(raw_ostream &os, unsigned loopId,
+                           const LoopSummary &S, FunctionIds &ids) {
+  JsonRecord rec(os, "loop", ids);
+  rec.field("loop_id") << loopId;
+  rec.field("parent");
+  if (S.parent >= 0) os << S.parent;
+  else os << "null";
+  rec.field("depth") << S.depth;
+  ids.emitBB(rec.field("header"), S.header);
+  emitBBList(rec.field("latches"), S.latches, ids);
+  emitBBList(rec.field("exiting"), S.exiting, ids);
+  emitBBList(rec.field("exits"), S.exits, ids);
+  emitBBList(rec.field("blocks"), S.blocks, ids);
+  rec.field("indvar");
+  if (S.indVar) ids.emitValue(os, S.indVar);
+  else os << "null";
+  emitScevOrNull(rec.field("indvar_start"),
+                 S.indVarRec ? S.indVarRec->getStart() : nullptr, ids);
+  emitScevOrNull(rec.field("indvar_step"),
+                 S.indVarRec && S.indVarRec->isAffine()
+                     ? S.indVarRec->getOperand(1) : nullptr, ids);
+  rec.field("trip_count");
+  if (S.tripCount) os << S.tripCount;
+  else os << "null";
+  emitScevOrNull(rec.field("backedge_taken"), S.backedgeTaken, ids);
+  rec.field("accesses") << "[";
+  for (size_t i = 0; i < S.accesses.size(); ++i) {
+    const LoopAccess &A = S.accesses[i];
+    auto *AR = dyn_cast<SCEVAddRecExpr>(A.addrScev);
+    bool affine = AR && AR->isAffine() && AR->getLoop()->getHeader() == S.header;
+    if (i) os << ",";
+    os << "{\"pp\":";
+    ids.emitPP(os, A.inst);
+    os << ",\"op\":";
+    emitJsonString(os, A.inst->getOpcodeName());
+    os << ",\"addr\":";
+    ids.emitValue(os, A.addr);
+    os << ",\"scev\":";
+    emitScev(os, A.addrScev, ids);
+    os << ",\"invariant\":" << (A.invariant ? "true" : "false");
+    os << ",\"affine\":" << (affine ? "true" : "false");
+    if (affine) {
+      os << ",\"start\":";
+      emitScev(os, AR->getStart(), ids);
+      os << ",\"step\":";
+      emitScev(os, AR->getOperand(1), ids);
+    }
+    os << "}";
+  }
+  os << "]";
+}
+
+// Memory facts for -public-data-mem-ssa, keyed by load, store, atomicrmw
+// and cmpxchg. Class ids are dense in function order of the first member.
+struct MemSummary {
+  DenseMap<const Instruction *, unsigned> memClass;
+  // Clobbering MemoryDef's instruction; absent for live-on-entry memory
+  // and for MemoryPhi clobbers, which are listed in memPhi instead.
+  DenseMap<const Instruction *, const Instruction *> memDef;
+  DenseMap<const Instruction *, const BasicBlock *> memPhi;
+};
+
+static bool isMemoryAccess(const Instruction &I) {
+  return isa<LoadInst>(I) || isa<StoreInst>(I) || isa<AtomicRMWInst>(I) ||
+         isa<AtomicCmpXchgInst>(I);
+}
+
+static MemoryLocation memoryLocation(const Instruction &I) {
+  if (auto *LI = dyn_cast<LoadInst>(&I)) return MemoryLocation::get(LI);
+  if (auto *SI = dyn_cast<StoreInst>(&I)) return MemoryLocation::get(SI);
+  if (auto *RMW = dyn_cast<AtomicRMWInst>(&I)) return MemoryLocation::get(RMW);
+  return MemoryLocation::get(cast<AtomicCmpXchgInst>(&I));
+}
+
+// Must-alias classes and reaching defs. Only locations with the same
+// underlying object and access size are compared, so each access tests
+// the class representatives of its bucket. The MemorySSA walker caches
+// clobbers in the graph, so this runs on the thread owning the analyses.
+static MemSummary summarizeMemory(Function &F, AAResults &AA, MemorySSA &MSSA) {
+  MemSummary out;
+  DenseMap<const Value *, std::vector<std::pair<MemoryLocation, unsigned>>>
+    reps;
+  unsigned nextClass = 0;
+  MemorySSAWalker *walker = MSSA.getWalker();
+  for (Instruction &I : instructions(F)) {
+    if (!isMemoryAccess(I)) continue;
+    MemoryLocation loc = memoryLocation(I);
+    auto &bucket = reps[getUnderlyingObject(loc.Ptr)];
+    int cls = -1;
+    for (const auto &rep : bucket) {
+      if (rep.first.Size == loc.Size &&
+          AA.alias(rep.first, loc) == AliasResult::MustAlias) {
+        cls = rep.second;
+        break;
+      }
+    }
+    if (cls < 0) {
+      cls = nextClass++;
+      bucket.push_back({loc, static_cast<unsigned>(cls)});
+    }
+    out.memClass[&I] = cls;
+
+    MemoryUseOrDef *MA = MSSA.getMemoryAccess(&I);
+    if (!MA) continue;
+    MemoryAccess *clobber = walker->getClobberingMemoryAccess(MA);
+    if (!clobber || MSSA.isLiveOnEntryDef(clobber)) continue;
+    if (auto *D = dyn_cast<MemoryDef>(clobber)) {
+      out.memDef[&I] = D->getMemoryInst();
+    } else if (auto *P = dyn_cast<MemoryPhi>(clobber)) {
+      out.memPhi[&I] = P->getBlock();
+    }
+  }
+  return out;
+}
+
+static void emitMemFields(raw_ostream &os, const Instruction &I,
+                          const MemSummary &mem, FunctionIds &ids) {
+  auto cls = mem.memClass.find(&I);
+  if (cls == mem.memClass.end()) return;
+  os << ",\"mem_class\":" << cls->second;
+  os << ",\"mem_def\":";
+  auto def = mem.memDef.find(&I);
+  if (def != mem.memDef.end()) ids.emitPP(os, def->second);
+  else os << "null";
+  auto phi = mem.memPhi.find(&I);
+  if (phi != mem.memPhi.end()) {
+    os << ",\"mem_phi\":";
+    ids.emitBB(os, phi->second);
+  }
+}
+
+// Interprocedural summary of one function for -public-data-callee-summaries.
+// Bit sets are over argument numbers.
+struct CalleeSummary {
+  unsigned scc = 0;
+  bool recursive = false;
+  BitVector argTx;      // reaches some transmitter operand
+  BitVector argTxMust;  // is a transmitter operand on every returning run
+  BitVector argRet;     // reaches the return value
+  bool retReadsMem = false;  // return value also depends on memory
+  BitVector readsArgs;  // memory reachable from the argument is read
+  BitVector writesArgs;
+  bool readsOther = false;  // globals or unidentified memory
+  bool writesOther = false;
+
+  bool operator==(const CalleeSummary &o) const {
+    return argTx == o.argTx && argTxMust == o.argTxMust &&
+           argRet == o.argRet && retReadsMem == o.retReadsMem &&
+           readsArgs == o.readsArgs && writesArgs == o.writesArgs &&
+           readsOther == o.readsOther && writesOther == o.writesOther;
+  }
+  bool operator!=(const CalleeSummary &o) const { return !(*this == o); }
+};
+
+using CalleeSummaryMap = DenseMap<const Function *, CalleeSummary>;
+
+// One round of the summary dataflow for F against the current summaries of
+// its callees (members of F's own SCC may still be growing). Argument taint
+// flows forward through SSA, through memory by underlying object, and
+// through calls per callee summary; bit arg_size() marks values that depend
+// on memory or on a call with no usable summary.
+static CalleeSummary summarizeCallee(const Function &F,
+                                     const CalleeSummaryMap &known,
+                                     const PostDominatorTree &PDT) {
+  unsigned n = F.arg_size();
+  unsigned memBit = n;
+  CalleeSummary S;
+  S.argTx.resize(n);
+  S.argTxMust.resize(n);
+  S.argRet.resize(n);
+  S.readsArgs.resize(n);
+  S.writesArgs.resize(n);
+
+  DenseMap<const Value *, BitVector> taint;
+  for (const Argument &A : F.args()) {
+    BitVector t(n + 1);
+    t.set(A.getArgNo());
+    taint[&A] = t;
+  }
+  auto taintOf = [&](const Value *V) {
+    auto it = taint.find(V);
+    return it == taint.end() ? BitVector(n + 1) : it->second;
+  };
+  // Identified objects get their own memory taint; everything else shares
+  // one unknown slot that every load also reads.
+  auto objectOf = [](const Value *ptr) -> const Value * {
+    const Value *O = getUnderlyingObject(ptr);
+    if (isa<AllocaInst>(O) || isa<Argument>(O) || isa<GlobalValue>(O)) return O;
+    return nullptr;
+  };
+  DenseMap<const Value *, BitVector> memTaint;
+  BitVector memUnknown(n + 1);
+  auto readMem = [&](const Value *ptr) {
+    BitVector t = memUnknown;
+    if (const Value *O = objectOf(ptr)) {
+      auto it = memTaint.find(O);
+      if (it != memTaint.end()) t |= it->second;
+    } else {
+      for (auto &kv : memTaint) t |= kv.second;
+    }
+    t.set(memBit);
+    return t;
+  };
+  auto writeMem = [&](const Value *ptr, const BitVector &t) {
+    BitVector &slot = objectOf(ptr) ? memTaint[objectOf(ptr)] : memUnknown;
+    if (slot.size() != n + 1) slot.resize(n + 1);
+    BitVector before = slot;
+    slot |= t;
+    return slot != before;
+  };
+  auto summaryFor = [&](const CallBase &CB) -> const CalleeSummary * {
+    const Function *G = CB.getCalledFunction();
+    if (!G || G->isDeclaration()) return nullptr;
+    auto it = known.find(G);
+    return it == known.end() ? nullptr : &it->second;
+  };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const Instruction &I : instructions(F)) {
+      BitVector t(n + 1);
+      bool memChanged = false;
+      if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        t = taintOf(LI->getPointerOperand());
+        t |= readMem(LI->getPointerOperand());
+      } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        memChanged = writeMem(SI->getPointerOperand(),
+                              taintOf(SI->getValueOperand()));
+      } else if (isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I)) {
+        const Value *ptr = getLoadStorePointerOperand(&I);
+        if (!ptr) ptr = I.getOperand(0);
+        BitVector in(n + 1);
+        for (const Use &U : I.operands()) in |= taintOf(U.get());
+        t = in;
+        t |= readMem(ptr);
+        memChanged = writeMem(ptr, in);
+      } else if (auto *CB = dyn_cast<CallBase>(&I)) {
+        BitVector all(n + 1);
+        for (const Use &U : CB->args()) all |= taintOf(U.get());
+        all |= taintOf(CB->getCalledOperand());
+        if (const CalleeSummary *CS = summaryFor(*CB)) {
+          for (unsigned k : CS->argRet.set_bits()) {
+            if (k < CB->arg_size()) t |= taintOf(CB->getArgOperand(k));
+          }
+          if (CS->retReadsMem) {
+            t |= all;
+            t |= memUnknown;
+            for (auto &kv : memTaint) t |= kv.second;
+            t.set(memBit);
+          }
+          for (unsigned k : CS->writesArgs.set_bits()) {
+            if (k < CB->arg_size()) {
+              memChanged |= writeMem(CB->getArgOperand(k), all);
             }
-            printTransmitter(I, tx.kind, op);
           }
+          if (CS->writesOther) {
+            BitVector before = memUnknown;
+            memUnknown |= all;
+            memChanged |= memUnknown != before;
+          }
+        } else if (!CB->doesNotAccessMemory()) {
+          t = all;
+          t.set(memBit);
+          if (!CB->onlyReadsMemory()) {
+            BitVector before = memUnknown;
+            memUnknown |= all;
+            memChanged |= memUnknown != before;
+          }
+        } else {
+          t = all;
+          t.set(memBit);
         }
-        if (!txs.empty()) {
-          txCount += txs.size();
-        }
+      } else {
+        for (const Use &U : I.operands()) t |= taintOf(U.get());
+      }
+      changed |= memChanged;
+      if (I.getType()->isVoidTy()) continue;
+      BitVector &slot = taint[&I];
+      if (slot.size() != n + 1) slot.resize(n + 1);
+      BitVector before = slot;
+      slot |= t;
+      changed |= slot != before;
+    }
+  }
 
-        if (trace) {
-          if (MaxInst != 0 && traceEmitted >= MaxInst) {
-            traceTruncated = true;
-          } else {
-          std::string opcode = I.getOpcodeName();
-          bool hasDef = !I.getType()->isVoidTy();
-          std::string defId = hasDef ? getValueId(&I, valueIds, nextValueId)
-                                     : "";
-          std::vector<std::string> uses;
-          uses.reserve(I.getNumOperands());
-          std::vector<std::string> useTypes;
-          if (TraceTypes) {
-            useTypes.reserve(I.getNumOperands());
+  auto noteAccess = [&](const Value *ptr, BitVector &args, bool &other) {
+    const Value *O = getUnderlyingObject(ptr);
+    if (auto *A = dyn_cast<Argument>(O)) args.set(A->getArgNo());
+    else if (!isa<AllocaInst>(O)) other = true;
+  };
+  auto directArg = [](const Value *V) {
+    return dyn_cast<Argument>(V->stripPointerCasts());
+  };
+  for (const BasicBlock &BB : F) {
+    bool always = PDT.dominates(&BB, &F.getEntryBlock());
+    for (const Instruction &I : BB) {
+      for (const TxInfo &tx : getTransmitterInfos(I)) {
+        if (tx.operandIndex < 0) continue;
+        const Value *V = I.getOperand(tx.operandIndex);
+        BitVector t = taintOf(V);
+        t.resize(n);
+        S.argTx |= t;
+        if (always) {
+          if (const Argument *A = directArg(V)) S.argTxMust.set(A->getArgNo());
+        }
+      }
+      if (auto *R = dyn_cast<ReturnInst>(&I)) {
+        if (const Value *V = R->getReturnValue()) {
+          BitVector t = taintOf(V);
+          S.retReadsMem |= t.test(memBit);
+          t.resize(n);
+          S.argRet |= t;
+        }
+      }
+      if (isa<LoadInst>(I)) {
+        noteAccess(getLoadStorePointerOperand(&I), S.readsArgs, S.readsOther);
+      } else if (isa<StoreInst>(I)) {
+        noteAccess(getLoadStorePointerOperand(&I), S.writesArgs, S.writesOther);
+      } else if (isa<AtomicRMWInst>(I) || isa<AtomicCmpXchgInst>(I)) {
+        noteAccess(I.getOperand(0), S.readsArgs, S.readsOther);
+        noteAccess(I.getOperand(0), S.writesArgs, S.writesOther);
+      } else if (auto *CB = dyn_cast<CallBase>(&I)) {
+        if (const CalleeSummary *CS = summaryFor(*CB)) {
+          for (unsigned k : CS->argTx.set_bits()) {
+            if (k >= CB->arg_size()) continue;
+            BitVector t = taintOf(CB->getArgOperand(k));
+            t.resize(n);
+            S.argTx |= t;
           }
-          bool isPhi = isa<PHINode>(I);
-          for (const Use &U : I.operands()) {
-            const Value *V = U.get();
-            if (auto *BB = dyn_cast<BasicBlock>(V)) {
-              if (!isPhi) continue;
-              uses.push_back(bbLabels[BB]);
-              if (TraceTypes) {
-                useTypes.push_back(typeToString(V->getType()));
+          if (always) {
+            for (unsigned k : CS->argTxMust.set_bits()) {
+              if (k >= CB->arg_size()) continue;
+              if (const Argument *A = directArg(CB->getArgOperand(k))) {
+                S.argTxMust.set(A->getArgNo());
               }
-              continue;
             }
-            uses.push_back(getValueId(V, valueIds, nextValueId));
-            if (TraceTypes) {
-              useTypes.push_back(typeToString(V->getType()));
+          }
+          for (unsigned k : CS->readsArgs.set_bits()) {
+            if (k < CB->arg_size()) {
+              noteAccess(CB->getArgOperand(k), S.readsArgs, S.readsOther);
             }
           }
-
-          *trace << "{";
-          *trace << "\"fn\":";
-          emitJsonString(*trace, F.getName());
-          *trace << ",\"bb\":";
-          emitJsonString(*trace, bbLabel);
-          *trace << ",\"pp\":";
-          emitJsonString(*trace, pp);
-          *trace << ",\"op\":";
-          emitJsonString(*trace, opcode);
-          *trace << ",\"def\":";
-          if (hasDef) emitJsonString(*trace, defId);
-          else *trace << "null";
-          *trace << ",\"uses\":[";
-          for (size_t i = 0; i < uses.size(); ++i) {
-            if (i) *trace << ",";
-            emitJsonString(*trace, uses[i]);
+          for (unsigned k : CS->writesArgs.set_bits()) {
+            if (k < CB->arg_size()) {
+              noteAccess(CB->getArgOperand(k), S.writesArgs, S.writesOther);
+            }
           }
-          *trace << "]";
-          if (TraceTypes) {
-            *trace << ",\"def_ty\":";
+          S.readsOther |= CS->readsOther;
+          S.writesOther |= CS->writesOther;
+        } else if (!CB->doesNotAccessMemory()) {
+          bool writes = !CB->onlyReadsMemory();
+          S.readsOther = true;
+          S.writesOther |= writes;
+          for (const Use &U : CB->args()) {
+            if (!U->getType()->isPointerTy()) continue;
+            noteAccess(U.get(), S.readsArgs, S.readsOther);
+            if (writes) noteAccess(U.get(), S.writesArgs, S.writesOther);
+          }
+        }
+      }
+    }
+  }
+  return S;
+}
+
+// Bottom-up walk of the call graph: SCCs come callees first, and each one
+// is iterated until its members' summaries stop growing.
+static CalleeSummaryMap summarizeCallGraph(CallGraph &CG,
+                                           FunctionAnalysisManager &FAM) {
+  CalleeSummaryMap out;
+  unsigned sccId = 0;
+  for (auto it = scc_begin(&CG); !it.isAtEnd(); ++it) {
+    std::vector<Function *> members;
+    for (CallGraphNode *N : *it) {
+      Function *F = N->getFunction();
+      if (F && !F->isDeclaration()) members.push_back(F);
+    }
+    if (members.empty()) continue;
+    bool recursive = it.hasCycle();
+    for (Function *F : members) {
+      CalleeSummary &S = out[F];
+      S.argTx.resize(F->arg_size());
+      S.argTxMust.resize(F->arg_size());
+      S.argRet.resize(F->arg_size());
+      S.readsArgs.resize(F->arg_size());
+      S.writesArgs.resize(F->arg_size());
+    }
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (Function *F : members) {
+        CalleeSummary S = summarizeCallee(
+          *F, out, FAM.getResult<PostDominatorTreeAnalysis>(*F));
+        S.scc = sccId;
+        S.recursive = recursive;
+        CalleeSummary &slot = out[F];
+        if (S != slot) {
+          slot = std::move(S);
+          changed = recursive;
+        }
+      }
+    }
+    sccId++;
+  }
+  return out;
+}
+
+static void emitArgSet(raw_ostream &os, const BitVector &bits) {
+  os << "[";
+  bool first = true;
+  for (unsigned k : bits.set_bits()) {
+    if (!first) os << ",";
+    first = false;
+    os << k;
+  }
+  os << "]";
+}
+
+static void emitCalleeSummary(raw_ostream &os, const FunctionIds &ids,
+                              const CalleeSummary &S, const MemSummary *mem,
+                              const Function &F) {
+  JsonRecord rec(os, "callee_summary", ids);
+  rec.field("scc") << S.scc;
+  rec.field("recursive") << (S.recursive ? "true" : "false");
+  emitArgSet(rec.field("arg_tx"), S.argTx);
+  emitArgSet(rec.field("arg_tx_must"), S.argTxMust);
+  emitArgSet(rec.field("arg_ret"), S.argRet);
+  rec.field("ret_reads_mem") << (S.retReadsMem ? "true" : "false");
+  emitArgSet(rec.field("reads_args"), S.readsArgs);
+  emitArgSet(rec.field("writes_args"), S.writesArgs);
+  rec.field("reads_other") << (S.readsOther ? "true" : "false");
+  rec.field("writes_other") << (S.writesOther ? "true" : "false");
+  if (mem) {
+    // Function-local must-alias classes (-public-data-mem-ssa) by direction.
+    std::vector<bool> reads, writes;
+    for (const Instruction &I : instructions(F)) {
+      auto it = mem->memClass.find(&I);
+      if (it == mem->memClass.end()) continue;
+      unsigned c = it->second;
+      if (c >= reads.size()) {
+        reads.resize(c + 1);
+        writes.resize(c + 1);
+      }
+      if (!isa<StoreInst>(I)) reads[c] = true;
+      if (!isa<LoadInst>(I)) writes[c] = true;
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+      const std::vector<bool> &v = pass ? writes : reads;
+      os << (pass ? ",\"mem_writes\":[" : ",\"mem_reads\":[");
+      bool first = true;
+      for (unsigned c = 0; c < v.size(); ++c) {
+        if (!v[c]) continue;
+        if (!first) os << ",";
+        first = false;
+        os << c;
+      }
+      os << "]";
+    }
+  }
+}
+
+// Times one pass phase: a -time-trace region (a no-op unless opt runs with
+// -time-trace; module-driver workers have no profiler, it is thread-local)
+// plus steady-clock nanoseconds added to slot. stop() ends the phase early
+// so it need not match a C++ scope.
+class PhaseTimer {
+public:
+  PhaseTimer(StringRef name, StringRef detail, uint64_t &slot)
+    : slot(&slot), start(std::chrono::steady_clock::now()) {
+    if (getTimeTraceProfilerInstance()) {
+      timeTraceProfilerBegin(name, detail);
+      traced = true;
+    }
+  }
+  ~PhaseTimer() { stop(); }
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+  void stop() {
+    if (!slot) return;
+    *slot += std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start).count();
+    slot = nullptr;
+    if (traced) timeTraceProfilerEnd();
+  }
+
+private:
+  uint64_t *slot;
+  std::chrono::steady_clock::time_point start;
+  bool traced = false;
+};
+
+// Per-function budgets (-public-data-fn-time-budget-ms/-mem-budget-mb),
+// polled once per enumerator expansion. The clock and the memory estimate
+// are read every 256th poll, and a hit stays hit. Memory is an estimate
+// rather than RSS so cutoffs repeat across runs and threads: the CFG bytes
+// the function has written (the module driver buffers them until commit)
+// plus what held() added for the dedup, coverage, guided-order and count
+// tables.
+class FnBudget {
+public:
+  explicit FnBudget(const raw_ostream *cfg)
+    : cfg(cfg), cfgBase(cfg ? cfg->tell() : 0),
+      start(std::chrono::steady_clock::now()) {}
+
+  void hold(size_t bytes) { held += bytes; }
+
+  bool exhausted() {
+    if (cutoffTime || cutoffMem) return true;
+    if ((++polls & 255) != 0) return false;
+    if (FnMemBudgetMb > 0) {
+      uint64_t bytes = held + (cfg ? cfg->tell() - cfgBase : 0);
+      if (bytes >= (uint64_t(FnMemBudgetMb) << 20)) cutoffMem = true;
+    }
+    if (FnTimeBudgetMs > 0 && !cutoffMem) {
+      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - start).count();
+      if (ms >= FnTimeBudgetMs) cutoffTime = true;
+    }
+    return cutoffTime || cutoffMem;
+  }
+
+  bool cutoffTime = false;
+  bool cutoffMem = false;
+
+private:
+  const raw_ostream *cfg;
+  uint64_t cfgBase;
+  std::chrono::steady_clock::time_point start;
+  uint64_t held = 0;
+  unsigned polls = 0;
+};
+
+// Per-phase nanoseconds for the perf record.
+struct PhaseTimes {
+  uint64_t analyses = 0;
+  uint64_t ids = 0;
+  uint64_t trace = 0;
+  uint64_t cfg = 0;
+  uint64_t pathTables = 0;
+  uint64_t pathCount = 0;
+  uint64_t paths = 0;
+  uint64_t ppCoverage = 0;
+  uint64_t total = 0;
+};
+
+// Range pruning (-public-data-prune-ranges): what LazyValueInfo and known
+// bits prove about each successor of a conditional branch or switch, per
+// way into its block (a predecessor, or nullptr for any). Successors are
+// numbered as the terminator lists them: a branch's true then false, or a
+// switch's cases then its default. LazyValueInfo is queried here, serially,
+// because its cache registers value handles on the shared LLVMContext.
+enum class RangeVerdict : uint8_t { Unknown, Implied, Infeasible };
+
+struct RangeSummary {
+  DenseMap<std::pair<const BasicBlock *, const BasicBlock *>,
+           SmallVector<RangeVerdict, 4>>
+    verdicts;
+
+  RangeVerdict lookup(const BasicBlock *pred, const BasicBlock *bb,
+                      unsigned succ) const {
+    auto it = verdicts.find({pred, bb});
+    if (it == verdicts.end()) return RangeVerdict::Unknown;
+    return it->second[succ];
+  }
+};
+
+// Range of integer V as used in BB, entered from Pred (nullptr: from
+// anywhere). A phi of BB is its incoming value from Pred. The edge query
+// applies only to values already defined when Pred branches to BB; others
+// are ranged at CxtI.
+static ConstantRange rangeInBlock(Value *V, BasicBlock *Pred, BasicBlock *BB,
+                                  Instruction *CxtI, LazyValueInfo &LVI,
+                                  const DataLayout &DL) {
+  bool onEdge = Pred != nullptr;
+  if (auto *PN = dyn_cast<PHINode>(V); PN && Pred && PN->getParent() == BB) {
+    V = PN->getIncomingValueForBlock(Pred);
+  } else if (auto *I = dyn_cast<Instruction>(V); I && I->getParent() == BB) {
+    onEdge = false;
+  }
+  ConstantRange known =
+    ConstantRange::fromKnownBits(computeKnownBits(V, DL), /*IsSigned=*/false);
+  ConstantRange lvi = onEdge
+    ? LVI.getConstantRangeOnEdge(V, Pred, BB, CxtI)
+    : LVI.getConstantRange(V, CxtI, /*UndefAllowed=*/false);
+  return known.intersectWith(lvi);
+}
+
+// Which successors of BB's terminator are infeasible, or the one implied,
+// when BB is entered from Pred. Empty when nothing is proven.
+static SmallVector<RangeVerdict, 4>
+rangeVerdicts(BasicBlock &BB, BasicBlock *Pred, LazyValueInfo &LVI,
+              const DataLayout &DL) {
+  Instruction *T = BB.getTerminator();
+  SmallVector<bool, 4> infeasible;
+  if (auto *BI = dyn_cast<BranchInst>(T)) {
+    Value *Cond = BI->getCondition();
+    bool alwaysTrue = false, alwaysFalse = false;
+    auto *Cmp = dyn_cast<ICmpInst>(Cond);
+    if (Cmp && Cmp->getOperand(0)->getType()->isIntegerTy()) {
+      // A compare outside BB was evaluated earlier: range its operands
+      // there, where they hold the values it saw.
+      bool inBB = Cmp->getParent() == &BB;
+      auto range = [&](Value *V) {
+        return rangeInBlock(V, inBB ? Pred : nullptr, Cmp->getParent(), Cmp,
+                            LVI, DL);
+      };
+      ConstantRange L = range(Cmp->getOperand(0));
+      ConstantRange R = range(Cmp->getOperand(1));
+      if (!L.isEmptySet() && !R.isEmptySet()) {
+        alwaysTrue = L.icmp(Cmp->getPredicate(), R);
+        alwaysFalse = L.icmp(Cmp->getInversePredicate(), R);
+      }
+    } else if (!Cmp) {
+      ConstantRange C = rangeInBlock(Cond, Pred, &BB, T, LVI, DL);
+      if (const APInt *V = C.getSingleElement()) {
+        alwaysTrue = V->isOne();
+        alwaysFalse = V->isZero();
+      }
+    }
+    infeasible = {alwaysFalse, alwaysTrue};
+  } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
+    ConstantRange C = rangeInBlock(SI->getCondition(), Pred, &BB, T, LVI, DL);
+    if (C.isEmptySet() || C.isFullSet()) return {};
+    for (auto &Case : SI->cases()) {
+      infeasible.push_back(!C.contains(Case.getCaseValue()->getValue()));
+    }
+    // The default is infeasible when every value in range has a case.
+    bool defaultInfeasible = false;
+    APInt size = C.getUpper() - C.getLower();  // neither empty nor full
+    if (size.ule(SI->getNumCases())) {
+      defaultInfeasible = true;
+      APInt v = C.getLower();
+      for (uint64_t n = size.getZExtValue(); n-- && defaultInfeasible; ++v) {
+        defaultInfeasible = llvm::any_of(SI->cases(), [&](const auto &Case) {
+          return Case.getCaseValue()->getValue() == v;
+        });
+      }
+    }
+    infeasible.push_back(defaultInfeasible);
+  }
+  unsigned feasible = llvm::count(infeasible, false);
+  if (feasible == 0 || feasible == infeasible.size()) return {};
+  SmallVector<RangeVerdict, 4> out;
+  for (bool dead : infeasible) {
+    out.push_back(dead ? RangeVerdict::Infeasible
+                       : feasible == 1 ? RangeVerdict::Implied
+                                       : RangeVerdict::Unknown);
+  }
+  return out;
+}
+
+static RangeSummary summarizeRanges(Function &F, LazyValueInfo &LVI) {
+  RangeSummary summary;
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  for (BasicBlock &BB : F) {
+    Instruction *T = BB.getTerminator();
+    Value *Cond = nullptr;
+    if (auto *BI = dyn_cast_or_null<BranchInst>(T)) {
+      if (BI->isConditional()) Cond = BI->getCondition();
+    } else if (auto *SI = dyn_cast_or_null<SwitchInst>(T)) {
+      Cond = SI->getCondition();
+    }
+    // Constant conditions are already folded when the tables are built.
+    if (!Cond || isa<Constant>(Cond) || !Cond->getType()->isIntegerTy()) {
+      continue;
+    }
+    SmallPtrSet<BasicBlock *, 8> seen;
+    SmallVector<BasicBlock *, 8> ways{nullptr};
+    for (BasicBlock *Pred : predecessors(&BB)) {
+      if (seen.insert(Pred).second) ways.push_back(Pred);
+    }
+    for (BasicBlock *Pred : ways) {
+      SmallVector<RangeVerdict, 4> v = rangeVerdicts(BB, Pred, LVI, DL);
+      if (!v.empty()) summary.verdicts[{Pred, &BB}] = std::move(v);
+    }
+  }
+  return summary;
+}
+
+// Analysis results one function's emission reads. Both drivers fill this
+// serially through computeAnalyses before emitFunction runs, which may be
+// on a worker thread.
+struct FunctionAnalyses {
+  RegionInfo *RI = nullptr;  // region path mode only
+  bool haveLoops = false;
+  std::vector<LoopSummary> loops;
+  bool haveMem = false;
+  MemSummary mem;
+  RangeSummary ranges;  // -public-data-prune-ranges with paths enabled
+  const CalleeSummary *summary = nullptr;  // module driver only
+  uint64_t analysisNs = 0;
+};
+
+static std::unique_ptr<FunctionAnalyses>
+computeAnalyses(Function &F, FunctionAnalysisManager &FAM) {
+  auto A = std::make_unique<FunctionAnalyses>();
+  PhaseTimer timer("PublicDataPass.analyses", F.getName(), A->analysisNs);
+  if (StringRef(PathMode) == "region") {
+    A->RI = &FAM.getResult<RegionInfoAnalysis>(F);
+  }
+  if (EmitLoops) {
+    A->haveLoops = true;
+    A->loops = summarizeLoops(F, FAM.getResult<LoopAnalysis>(F),
+                              FAM.getResult<ScalarEvolutionAnalysis>(F));
+  }
+  if (EmitMemSSA) {
+    A->haveMem = true;
+    A->mem = summarizeMemory(F, FAM.getResult<AAManager>(F),
+                             FAM.getResult<MemorySSAAnalysis>(F).getMSSA());
+  }
+  if (PruneRanges && MaxPaths > 0) {
+    A->ranges = summarizeRanges(F, FAM.getResult<LazyValueAnalysis>(F));
+  }
+  return A;
+}
+
+// Whether decision d is infeasible once p has been taken earlier on the
+// same path, with p's condition still describing the live SSA instance:
+// the same or an implied i1 condition with the opposite sense, or a switch
+// on the same value taking an incompatible case.
+static bool decisionContradicts(const Decision &p, const Decision &d,
+                                const DataLayout &DL) {
+  if (p.sense && d.sense) {
+    bool pTrue = StringRef(p.sense) == "true";
+    bool dTrue = StringRef(d.sense) == "true";
+    if (p.cond == d.cond) return pTrue != dTrue;
+    auto implied = isImpliedCondition(p.cond, d.cond, DL, pTrue);
+    return implied && *implied != dTrue;
+  }
+  auto *PS = dyn_cast<SwitchInst>(p.term);
+  auto *DS = dyn_cast<SwitchInst>(d.term);
+  if (!PS || !DS || p.cond != d.cond) return false;
+  if (!p.isDefault) {
+    if (!d.isDefault) return d.caseValue != p.caseValue;
+    return DS->findCaseValue(cast<ConstantInt>(p.caseValue)) !=
+           DS->case_default();
+  }
+  if (!d.isDefault) {
+    return PS->findCaseValue(cast<ConstantInt>(d.caseValue)) !=
+           PS->case_default();
+  }
+  return false;
+}
+
+// Saturating 128-bit path counts for path_count_exact.
+using PathCount = unsigned __int128;
+
+static PathCount addPathCount(PathCount a, PathCount b) {
+  PathCount sum = a + b;
+  return sum < a ? ~PathCount(0) : sum;
+}
+
+// Emit a path count as a JSON integer.
+static void emitPathCount(raw_ostream &os, PathCount n) {
+  char buf[40];
+  char *p = buf + sizeof(buf);
+  do {
+    *--p = static_cast<char>('0' + static_cast<unsigned>(n % 10));
+    n /= 10;
+  } while (n);
+  os << StringRef(p, buf + sizeof(buf) - p);
+}
+
+// Path ids covering one block as sorted, inclusive [first, last] runs.
+// Path ids only grow during enumeration and a DFS subtree gets consecutive
+// ids, so most blocks need a handful of runs however many paths cross them.
+using PathIdRanges = SmallVector<std::pair<unsigned, unsigned>, 2>;
+
+// Add pathId to ranges; returns false if it is already the last id.
+static bool addPathId(PathIdRanges &ranges, unsigned pathId) {
+  if (!ranges.empty()) {
+    if (ranges.back().second == pathId) return false;
+    if (ranges.back().second + 1 == pathId) {
+      ranges.back().second = pathId;
+      return true;
+    }
+  }
+  ranges.push_back({pathId, pathId});
+  return true;
+}
+
+static uint64_t pathIdCount(const PathIdRanges &ranges) {
+  uint64_t n = 0;
+  for (const auto &r : ranges) n += r.second - r.first + 1;
+  return n;
+}
+
+// Emit a trace index record (pp -> trace line).
+static void emitTraceIndexRecord(raw_ostream &os, const Instruction &I,
+                                 FunctionIds &ids, unsigned line) {
+  JsonRecord rec(os, "trace_index", ids);
+  ids.emitBB(rec.field("bb"), I.getParent());
+  ids.emitPP(rec.field("pp"), &I);
+  emitJsonString(rec.field("op"), I.getOpcodeName());
+  rec.field("def");
+  if (!I.getType()->isVoidTy()) ids.emitValue(os, &I);
+  else os << "null";
+  rec.field("line") << line;
+}
+
+// One function's columnar trace block (ColumnarTrace.h), built a row per
+// instruction as emitFunction walks the function; write() appends it.
+class ColumnarBlockBuilder {
+public:
+  ColumnarBlockBuilder(StringRef fn, bool types) : types(types) {
+    str(fn);
+    useStart.push_back(0);
+    txStart.push_back(0);
+  }
+
+  // Id of s in the block's string table.
+  uint32_t str(StringRef s) {
+    auto ins = stringIds.try_emplace(s, stringStart.size());
+    if (ins.second) {
+      stringStart.push_back(stringBytes.size());
+      stringBytes += s;
+    }
+    return ins.first->second;
+  }
+
+  void beginRow(uint32_t ppId, uint32_t bbId, uint32_t instIndex,
+                unsigned opcode, uint32_t defId, uint32_t defTyId,
+                uint8_t predicate, uint32_t calleeId) {
+    pp.push_back(ppId);
+    bb.push_back(bbId);
+    inst.push_back(instIndex);
+    op.push_back(opcode);
+    def.push_back(defId);
+    if (types) defTy.push_back(defTyId);
+    pred.push_back(predicate);
+    callee.push_back(calleeId);
+    txMask.push_back(0);
+  }
+  void addUse(uint32_t valueId, uint32_t tyId) {
+    uses.push_back(valueId);
+    if (types) useTy.push_back(tyId);
+  }
+  void addTx(unsigned kind, int which, bool equal) {
+    txKind.push_back(kind);
+    txWhich.push_back(static_cast<uint32_t>(which));
+    txStatic.push_back(equal);
+    txMask.back() |= 1u << kind;
+  }
+  void endRow(uint32_t extraId) {
+    extra.push_back(extraId);
+    useStart.push_back(uses.size());
+    txStart.push_back(txKind.size());
+  }
+
+  void write(raw_ostream &os) const {
+    std::vector<uint32_t> starts(stringStart);
+    starts.push_back(stringBytes.size());
+    uint32_t flags = types ? ct_columnar::FlagTypes : 0;
+    ct_columnar::BlockLayout layout = ct_columnar::BlockLayout::compute(
+      flags, pp.size(), uses.size(), txKind.size(), stringStart.size(),
+      stringBytes.size());
+    writeLE(os, layout.size, 8);
+    writeLE(os, flags, 4);
+    writeLE(os, pp.size(), 4);
+    writeLE(os, uses.size(), 4);
+    writeLE(os, txKind.size(), 4);
+    writeLE(os, stringStart.size(), 4);
+    writeLE(os, stringBytes.size(), 4);
+    uint64_t at = ct_columnar::BlockHeaderSize;
+    auto bytes = [&](uint64_t offset, StringRef data) {
+      os.write_zeros(offset - at);
+      os << data;
+      at = offset + data.size();
+    };
+    auto u32s = [&](uint64_t offset, ArrayRef<uint32_t> values) {
+      SmallString<256> buf;
+      buf.resize(4 * values.size());
+      for (size_t i = 0; i < values.size(); ++i) {
+        support::endian::write32le(buf.data() + 4 * i, values[i]);
+      }
+      bytes(offset, buf);
+    };
+    auto u8s = [&](uint64_t offset, ArrayRef<uint8_t> values) {
+      bytes(offset, StringRef(reinterpret_cast<const char *>(values.data()),
+                              values.size()));
+    };
+    u32s(layout.pp, pp);
+    u32s(layout.bb, bb);
+    u32s(layout.inst, inst);
+    u32s(layout.def, def);
+    u32s(layout.callee, callee);
+    u32s(layout.extra, extra);
+    if (types) u32s(layout.defTy, defTy);
+    u32s(layout.txMask, txMask);
+    u32s(layout.useStart, useStart);
+    u32s(layout.txStart, txStart);
+    u32s(layout.uses, uses);
+    if (types) u32s(layout.useTy, useTy);
+    u32s(layout.txWhich, txWhich);
+    u8s(layout.op, op);
+    u8s(layout.pred, pred);
+    u8s(layout.txKind, txKind);
+    u8s(layout.txStatic, txStatic);
+    u32s(layout.stringStart, starts);
+    bytes(layout.stringBytes, stringBytes);
+    os.write_zeros(layout.size - at);
+  }
+
+private:
+  bool types;
+  std::vector<uint32_t> pp, bb, inst, def, callee, extra, defTy, txMask;
+  std::vector<uint32_t> useStart, txStart, uses, useTy, txWhich;
+  std::vector<uint8_t> op, pred, txKind, txStatic;
+  StringMap<uint32_t> stringIds;
+  std::vector<uint32_t> stringStart;
+  std::string stringBytes;
+};
+
+// Warn once about path options the chosen path mode or encoding drops. Called from the
+// pass entry points, before any worker runs.
+static void warnIgnoredPathOptions() {
+  static bool warned = false;
+  if (warned || Quiet) return;
+  warned = true;
+  bool region = StringRef(PathMode) == "region";
+  bool trie = StringRef(PathEncoding) == "trie";
+  if (DedupPaths && (region || trie)) {
+    errs() << "-public-data-dedup-paths is ignored with "
+           << (region ? "-public-data-path-mode=region"
+                      : "-public-data-path-encoding=trie")
+           << "\n";
+  }
+  if (PathSlice && trie) {
+    errs() << "-public-data-path-slice is ignored with "
+              "-public-data-path-encoding=trie\n";
+  }
+}
+
+struct PublicDataPass : PassInfoMixin<PublicDataPass> {
+  static bool isRequired() { return true; }  // <--- add this
+
+  // Main pass entry point: emits trace and CFG records for one function.
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM) {
+    TimeTraceScope scope("PublicDataPass", F.getName());
+    static bool warnedSummaries = false;
+    if (CalleeSummaries && !warnedSummaries && !Quiet) {
+      errs() << "-public-data-callee-summaries needs the module driver "
+                "(-passes=public-data-module); ignoring\n";
+      warnedSummaries = true;
+    }
+    static bool warnedPerfCache = false;
+    if (!CacheDir.empty() && EmitPerf && !warnedPerfCache && !Quiet) {
+      errs() << "-public-data-cache-dir is not read or written with "
+                "-public-data-perf\n";
+      warnedPerfCache = true;
+    }
+    warnIgnoredPathOptions();
+    // Cached, sharded and published runs go through a buffer, as in the
+    // module driver.
+    if (cacheEnabled() || renderAll()) {
+      bool caching = cacheEnabled();
+      std::string key = caching ? functionCacheKey(F) : std::string();
+      FunctionOutput out;
+      bool hit = caching && loadCachedFunction(F.getName(), key, out);
+      if (!hit && renderFunction(F, *computeAnalyses(F, FAM), out) &&
+          caching) {
+        storeCachedFunction(key, out);
+      }
+      commitFunctionOutput(F, out);
+      if (caching) emitCacheManifestEntry(F.getName(), key, hit);
+      return PreservedAnalyses::all();
+    }
+    std::unique_ptr<FunctionAnalyses> analyses = computeAnalyses(F, FAM);
+    OutputFile *traceFile = getTraceFile();
+    raw_ostream *trace = traceFile ? &traceFile->stream() : nullptr;
+    TraceIndexBinWriter *binIndex = getTraceIndexBinWriter();
+    uint64_t traceBase = trace ? trace->tell() : 0;
+    uint64_t frameOffset = traceFile ? traceFile->frameOffset() : 0;
+    uint64_t frameBase = traceFile ? traceFile->frameLogicalOffset() : 0;
+    FunctionTraceSpans spans;
+    emitFunction(F, *analyses, trace, getTraceIndexStream(), getCfgStream(),
+                 errs(), binIndex ? &spans : nullptr);
+    endOutputFrames();
+    if (binIndex) {
+      binIndex->addFunction(F.getName(), traceBase, frameOffset, frameBase,
+                            spans);
+    }
+    return PreservedAnalyses::all();
+  }
+
+  // Render one function into out's buffers, for the streams that are
+  // enabled. Returns false when a time budget cut it short, since such
+  // output depends on more than the cache key.
+  static bool renderFunction(Function &F, const FunctionAnalyses &analyses,
+                             FunctionOutput &out) {
+    raw_string_ostream traceOS(out.trace);
+    raw_string_ostream indexOS(out.traceIndex);
+    raw_string_ostream cfgOS(out.cfg);
+    raw_string_ostream logOS(out.log);
+    return emitFunction(
+      F, analyses, renderTrace() ? &traceOS : nullptr,
+      renderTraceIndex() ? &indexOS : nullptr,
+      renderCfg() ? &cfgOS : nullptr, logOS,
+      getTraceIndexBinWriter() ? &out.spans : nullptr, &out.pathRecords);
+  }
+
+  // Render one function's trace, trace index and CFG records into the given
+  // streams (each may be null) and debug output into log. Nothing else is
+  // shared, so the module driver runs this on worker threads; analyses
+  // are only read. If spans is set, it receives the byte span of every
+  // trace record relative to the trace stream's position on entry, and
+  // pathRecords the number of path (or region segment) records written.
+  // Returns false when -public-data-fn-time-budget-ms cut it short.
+  static bool emitFunction(Function &F, const FunctionAnalyses &analyses,
+                           raw_ostream *trace,
+                           raw_ostream *traceIndex, raw_ostream *cfg,
+                           raw_ostream &log,
+                           FunctionTraceSpans *spans = nullptr,
+                           unsigned *pathRecords = nullptr) {
+    RegionInfo *RI = analyses.RI;
+    const std::vector<LoopSummary> *loops =
+      analyses.haveLoops ? &analyses.loops : nullptr;
+    const MemSummary *mem = analyses.haveMem ? &analyses.mem : nullptr;
+    bool quiet = Quiet;
+    bool verbose = Verbose && !Quiet;
+    PhaseTimes times;
+    times.analyses = analyses.analysisNs;
+    PhaseTimer totalTimer("PublicDataPass.emit", F.getName(), times.total);
+    uint64_t traceIndexBase = traceIndex ? traceIndex->tell() : 0;
+    uint64_t cfgBase = cfg ? cfg->tell() : 0;
+    FnBudget budget(cfg);
+
+    if (!quiet) {
+      log << "== PublicDataPass on function: " << F.getName() << " ==\n";
+    }
+
+    PhaseTimer idsTimer("PublicDataPass.ids", F.getName(), times.ids);
+    FunctionIds ids(F, InternIds);
+    for (const Argument &A : F.args()) {
+      ids.valueId(&A);
+    }
+    if (ids.interned()) {
+      ids.internFunction(F);
+      if (loops) {
+        for (const LoopSummary &S : *loops) {
+          internScev(S.indVarRec, ids);
+          internScev(S.backedgeTaken, ids);
+          for (const LoopAccess &A : S.accesses) internScev(A.addrScev, ids);
+        }
+      }
+    }
+    unsigned instCount = 0;
+    unsigned txCount = 0;
+    unsigned traceEmitted = 0;
+    bool traceTruncated = false;
+    unsigned traceLine = 0;
+
+    if (!trace) spans = nullptr;
+    uint64_t traceBase = trace ? trace->tell() : 0;
+    // Columnar blocks carry their own string table instead of a symtab.
+    std::unique_ptr<ColumnarBlockBuilder> columns;
+    if (trace && columnarTrace()) {
+      columns = std::make_unique<ColumnarBlockBuilder>(F.getName(),
+                                                       TraceTypes);
+    }
+    if (ids.interned()) {
+      if (trace && !columns) {
+        uint64_t start = trace->tell();
+        ids.emitSymtab(*trace, F);
+        if (spans) {
+          spans->symtabOffset = start - traceBase;
+          spans->symtabLength = trace->tell() - start - 1;
+        }
+      }
+      if (traceIndex) ids.emitSymtab(*traceIndex, F);
+      if (cfg) ids.emitSymtab(*cfg, F);
+    }
+    idsTimer.stop();
+    bool emitCondStr = true;
+    bool emitCondJson = false;
+
+    StringRef fmt = PathCondFormat;
+    if (fmt == "json") {
+      emitCondStr = false;
+      emitCondJson = true;
+    } else if (fmt == "both") {
+      emitCondStr = true;
+      emitCondJson = true;
+    } else if (fmt == "string") {
+      emitCondStr = true;
+      emitCondJson = false;
+    } else if (!fmt.empty()) {
+      if (!quiet) {
+        log << "Unknown -public-data-path-cond-format: " << fmt
+               << " (defaulting to string)\n";
+      }
+      emitCondStr = true;
+      emitCondJson = false;
+    }
+
+    bool trieEncoding = false;
+    StringRef enc = PathEncoding;
+    if (enc == "trie") {
+      trieEncoding = true;
+    } else if (enc != "full" && !enc.empty()) {
+      if (!quiet) {
+        log << "Unknown -public-data-path-encoding: " << enc
+               << " (defaulting to full)\n";
+      }
+    }
+
+    PhaseTimer traceTimer("PublicDataPass.trace", F.getName(), times.trace);
+    DenseMap<const Value *, StaticClass> staticClasses;
+    if (StaticPublic && trace) staticClasses = computeStaticClasses(F);
+    // Whether operand idx of I is provably equal across executions.
+    auto staticEqual = [&](const Instruction &I, int idx) {
+      if (!StaticPublic || idx < 0 ||
+          idx >= static_cast<int>(I.getNumOperands())) {
+        return false;
+      }
+      const Value *V = I.getOperand(idx);
+      if (isa<UndefValue>(V)) return false;
+      if (isa<Constant>(V)) return true;
+      auto it = staticClasses.find(V);
+      return it != staticClasses.end() &&
+             (it->second == StaticClass::Const ||
+              it->second == StaticClass::PublicArg);
+    };
+    // Whether I's own value is provably equal across executions.
+    auto defStaticEqual = [&](const Instruction &I) {
+      if (!StaticPublic || I.getType()->isVoidTy()) return false;
+      auto it = staticClasses.find(&I);
+      return it != staticClasses.end() &&
+             (it->second == StaticClass::Const ||
+              it->second == StaticClass::PublicArg);
+    };
+
+    // Columnar extra fields name pps and blocks, never interned ids.
+    std::unique_ptr<FunctionIds> plainIds;
+    auto addColumnarRow = [&](const Instruction &I,
+                              ArrayRef<TxInfo> txs) {
+      constexpr uint32_t none = ct_columnar::None;
+      bool hasDef = !I.getType()->isVoidTy();
+      uint8_t pred = ct_columnar::NoPred;
+      if (auto *Cmp = dyn_cast<CmpInst>(&I)) pred = Cmp->getPredicate();
+      uint32_t calleeId = none;
+      if (auto *CB = dyn_cast<CallBase>(&I)) {
+        if (const Function *Callee = CB->getCalledFunction()) {
+          calleeId = columns->str(Callee->getName());
+        }
+      }
+      unsigned bb = ids.bbId(I.getParent());
+      columns->beginRow(
+        ids.ppId(&I), columns->str(ids.bbLabel(I.getParent())),
+        ids.ppId(&I) - ids.bbFirstPpId(bb), I.getOpcode(),
+        hasDef ? columns->str(ids.valueId(&I)) : none,
+        TraceTypes && hasDef ? columns->str(typeToString(I.getType())) : none,
+        pred, calleeId);
+      bool isPhi = isa<PHINode>(I);
+      for (const Use &U : I.operands()) {
+        const Value *V = U.get();
+        if (isa<BasicBlock>(V) && !isPhi) continue;
+        columns->addUse(columns->str(ids.valueId(V)),
+                        TraceTypes ? columns->str(typeToString(V->getType()))
+                                   : none);
+      }
+      for (const TxInfo &tx : txs) {
+        const StringLiteral *kind = llvm::find(ColumnarTxKinds, tx.kind);
+        columns->addTx(kind - std::begin(ColumnarTxKinds), tx.operandIndex,
+                       staticEqual(I, tx.operandIndex));
+      }
+      std::string extraText;
+      raw_string_ostream extraOS(extraText);
+      auto emitIndices = [&](StringRef key, ArrayRef<unsigned> indices) {
+        extraOS << ",\"" << key << "\":[";
+        for (size_t i = 0; i < indices.size(); ++i) {
+          if (i) extraOS << ",";
+          extraOS << indices[i];
+        }
+        extraOS << "]";
+      };
+      if (auto *EV = dyn_cast<ExtractValueInst>(&I)) {
+        emitIndices("extract_indices", EV->getIndices());
+      }
+      if (auto *IV = dyn_cast<InsertValueInst>(&I)) {
+        emitIndices("insert_indices", IV->getIndices());
+      }
+      if (auto *ARMW = dyn_cast<AtomicRMWInst>(&I)) {
+        extraOS << ",\"atomic_op\":";
+        emitJsonString(extraOS, atomicRmwOpName(ARMW->getOperation()));
+      }
+      if (defStaticEqual(I)) extraOS << ",\"def_static\":\"equal\"";
+      if (mem) {
+        if (ids.interned() && !plainIds) {
+          plainIds = std::make_unique<FunctionIds>(F, false);
+        }
+        emitMemFields(extraOS, I, *mem, plainIds ? *plainIds : ids);
+      }
+      extraOS.flush();
+      if (extraText.empty()) {
+        columns->endRow(none);
+      } else {
+        extraText[0] = '{';
+        columns->endRow(columns->str(extraText + "}"));
+      }
+    };
+
+    bool regionMode = false;
+    StringRef mode = PathMode;
+    if (mode == "region") {
+      regionMode = true;
+    } else if (mode != "function" && !mode.empty()) {
+      if (!quiet) {
+        log << "Unknown -public-data-path-mode: " << mode
+               << " (defaulting to function)\n";
+      }
+    }
+
+    bool blockCoverage = false;
+    StringRef covFmt = PpCoverageFormat;
+    if (covFmt == "block") {
+      blockCoverage = true;
+    } else if (covFmt != "pp" && !covFmt.empty()) {
+      if (!quiet) {
+        log << "Unknown -public-data-pp-coverage-format: " << covFmt
+               << " (defaulting to pp)\n";
+      }
+    }
+
+    // Guided orders apply to function mode; region segments keep DFS order.
+    bool guidedOrder = false;
+    bool txOrder = false;
+    StringRef order = PathOrder;
+    if (order == "coverage" || order == "tx-density") {
+      guidedOrder = !regionMode;
+      txOrder = order == "tx-density";
+    } else if (order != "dfs" && !order.empty()) {
+      if (!quiet) {
+        log << "Unknown -public-data-path-order: " << order
+               << " (defaulting to dfs)\n";
+      }
+    }
+
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        if (verbose) {
+          log << "PP ";
+          ids.printPP(log, &I);
+          log << " : ";
+          I.print(log);
+          log << "\n";
+        }
+
+        std::vector<TxInfo> txs = getTransmitterInfos(I);
+        if (!txs.empty() && !quiet) {
+          for (const TxInfo &tx : txs) {
+            const Value *op = nullptr;
+            if (tx.operandIndex >= 0 &&
+                tx.operandIndex < static_cast<int>(I.getNumOperands())) {
+              op = I.getOperand(tx.operandIndex);
+            }
+            printTransmitter(log, I, tx.kind, op);
+          }
+        }
+        if (!txs.empty()) {
+          txCount += txs.size();
+        }
+
+        if (trace) {
+          if (MaxInst != 0 && traceEmitted >= MaxInst) {
+            traceTruncated = true;
+          } else if (columns) {
+            addColumnarRow(I, txs);
+            traceLine++;
+            traceEmitted++;
+            if (traceIndex) {
+              emitTraceIndexRecord(*traceIndex, I, ids, traceLine);
+            }
+          } else {
+          bool hasDef = !I.getType()->isVoidTy();
+          std::vector<std::string> useTypes;
+          if (TraceTypes) {
+            useTypes.reserve(I.getNumOperands());
+          }
+          bool isPhi = isa<PHINode>(I);
+          uint64_t recordStart = trace->tell();
+
+          *trace << "{";
+          *trace << "\"fn\":";
+          ids.emitFn(*trace);
+          *trace << ",\"bb\":";
+          ids.emitBB(*trace, &BB);
+          *trace << ",\"pp\":";
+          ids.emitPP(*trace, &I);
+          *trace << ",\"op\":";
+          emitJsonString(*trace, I.getOpcodeName());
+          *trace << ",\"def\":";
+          if (hasDef) ids.emitValue(*trace, &I);
+          else *trace << "null";
+          *trace << ",\"uses\":[";
+          bool firstUse = true;
+          for (const Use &U : I.operands()) {
+            const Value *V = U.get();
+            if (isa<BasicBlock>(V) && !isPhi) continue;
+            if (!firstUse) *trace << ",";
+            firstUse = false;
+            ids.emitValue(*trace, V);
+            if (TraceTypes) {
+              useTypes.push_back(typeToString(V->getType()));
+            }
+          }
+          *trace << "]";
+          if (TraceTypes) {
+            *trace << ",\"def_ty\":";
             if (hasDef) emitJsonString(*trace, typeToString(I.getType()));
             else *trace << "null";
             *trace << ",\"use_tys\":[";
@@ -677,6 +3516,9 @@ struct PublicDataPass : PassInfoMixin<PublicDataPass> {
               *trace << "\"kind\":";
               emitJsonString(*trace, txs[i].kind);
               *trace << ",\"which\":" << txs[i].operandIndex;
+              if (staticEqual(I, txs[i].operandIndex)) {
+                *trace << ",\"static\":\"equal\"";
+              }
               *trace << "}";
             }
             *trace << "]";
@@ -684,192 +3526,151 @@ struct PublicDataPass : PassInfoMixin<PublicDataPass> {
             *trace << "\"kind\":";
             emitJsonString(*trace, txs.front().kind);
             *trace << ",\"which\":" << txs.front().operandIndex;
+            if (staticEqual(I, txs.front().operandIndex)) {
+              *trace << ",\"static\":\"equal\"";
+            }
             *trace << "}";
           }
           if (auto *ARMW = dyn_cast<AtomicRMWInst>(&I)) {
             *trace << ",\"atomic_op\":";
             emitJsonString(*trace, atomicRmwOpName(ARMW->getOperation()));
           }
+          if (defStaticEqual(I)) *trace << ",\"def_static\":\"equal\"";
+          if (mem) emitMemFields(*trace, I, *mem, ids);
           *trace << "}\n";
+          if (spans) {
+            spans->spans.push_back(
+              {ids.ppId(&I), recordStart - traceBase,
+               static_cast<uint32_t>(trace->tell() - recordStart - 1)});
+          }
 
           traceLine++;
           traceEmitted++;
           if (traceIndex) {
-            emitTraceIndexRecord(*traceIndex, F.getName(), bbLabel, pp,
-                                 opcode, defId, traceLine);
+            emitTraceIndexRecord(*traceIndex, I, ids, traceLine);
           }
           }
         }
 
-        idx++;
         instCount++;
       }
     }
 
+    if (columns) columns->write(*trace);
+    traceTimer.stop();
+    uint64_t traceBytes = trace ? trace->tell() - traceBase : 0;
+
     if (cfg) {
-      *cfg << "{";
-      *cfg << "\"kind\":\"func_summary\",\"fn\":";
-      emitJsonString(*cfg, F.getName());
-      *cfg << ",\"inst_count\":" << instCount;
-      *cfg << ",\"bb_count\":" << bbIndex.size();
-      *cfg << ",\"tx_count\":" << txCount;
-      *cfg << ",\"trace_emitted\":" << traceEmitted;
-      *cfg << ",\"trace_truncated\":" << (traceTruncated ? "true" : "false");
-      *cfg << ",\"trace_max_inst\":" << MaxInst;
-      *cfg << ",\"arg_ids\":";
-      emitJsonStringArray(*cfg, argIds);
-      *cfg << "}\n";
+      PhaseTimer cfgTimer("PublicDataPass.cfg", F.getName(), times.cfg);
+      {
+        JsonRecord rec(*cfg, "func_summary", ids);
+        rec.field("inst_count") << instCount;
+        rec.field("bb_count") << ids.bbCount();
+        rec.field("tx_count") << txCount;
+        rec.field("trace_emitted") << traceEmitted;
+        rec.field("trace_truncated") << (traceTruncated ? "true" : "false");
+        rec.field("trace_max_inst") << MaxInst;
+        rec.field("arg_ids") << "[";
+        for (const Argument &A : F.args()) {
+          if (A.getArgNo()) *cfg << ",";
+          ids.emitValue(*cfg, &A);
+        }
+        *cfg << "]";
+        if (loops) rec.field("loop_count") << loops->size();
+      }
+      if (analyses.summary) {
+        emitCalleeSummary(*cfg, ids, *analyses.summary, mem, F);
+      }
 
       for (auto &BB : F) {
         const Instruction *T = BB.getTerminator();
-        std::vector<std::string> succs;
-        if (T) {
-          for (unsigned i = 0; i < T->getNumSuccessors(); ++i) {
-            const BasicBlock *Succ = T->getSuccessor(i);
-            succs.push_back(bbLabels[Succ]);
-          }
-        }
-
-        *cfg << "{";
-        *cfg << "\"kind\":\"block\",\"fn\":";
-        emitJsonString(*cfg, F.getName());
-        *cfg << ",\"bb\":";
-        emitJsonString(*cfg, bbLabels[&BB]);
-        *cfg << ",\"succs\":";
-        emitJsonStringArray(*cfg, succs);
-        if (T) {
-          *cfg << ",\"term_pp\":";
-          emitJsonString(*cfg, termPP[&BB]);
-          *cfg << ",\"term_op\":";
-          emitJsonString(*cfg, T->getOpcodeName());
-
-          if (auto *BI = dyn_cast<BranchInst>(T)) {
-            if (BI->isConditional()) {
-              *cfg << ",\"cond\":";
-              emitJsonString(*cfg,
-                             getValueId(BI->getCondition(),
-                                        valueIds, nextValueId));
+        {
+          JsonRecord rec(*cfg, "block", ids);
+          ids.emitBB(rec.field("bb"), &BB);
+          rec.field("succs") << "[";
+          if (T) {
+            for (unsigned i = 0; i < T->getNumSuccessors(); ++i) {
+              if (i) *cfg << ",";
+              ids.emitBB(*cfg, T->getSuccessor(i));
+            }
+          }
+          *cfg << "]";
+          if (T) {
+            ids.emitPP(rec.field("term_pp"), T);
+            emitJsonString(rec.field("term_op"), T->getOpcodeName());
+            if (auto *BI = dyn_cast<BranchInst>(T)) {
+              if (BI->isConditional()) {
+                ids.emitValue(rec.field("cond"), BI->getCondition());
+              }
+            } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
+              ids.emitValue(rec.field("cond"), SI->getCondition());
+            } else if (auto *IB = dyn_cast<IndirectBrInst>(T)) {
+              ids.emitValue(rec.field("target"), IB->getAddress());
             }
-          } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
-            *cfg << ",\"cond\":";
-            emitJsonString(*cfg,
-                           getValueId(SI->getCondition(),
-                                      valueIds, nextValueId));
-          } else if (auto *IB = dyn_cast<IndirectBrInst>(T)) {
-            *cfg << ",\"target\":";
-            emitJsonString(*cfg,
-                           getValueId(IB->getAddress(),
-                                      valueIds, nextValueId));
           }
         }
-        *cfg << "}\n";
 
         if (!T) continue;
+        // Every edge record starts from/to/term_pp/branch; callers add the
+        // branch-specific members before rec closes.
+        auto edgeHead = [&](JsonRecord &rec, const BasicBlock *to,
+                            StringRef branch) {
+          ids.emitBB(rec.field("from"), &BB);
+          ids.emitBB(rec.field("to"), to);
+          ids.emitPP(rec.field("term_pp"), T);
+          emitJsonString(rec.field("branch"), branch);
+        };
         if (auto *BI = dyn_cast<BranchInst>(T)) {
           if (BI->isConditional()) {
-            std::string condId =
-              getValueId(BI->getCondition(), valueIds, nextValueId);
             for (unsigned i = 0; i < BI->getNumSuccessors(); ++i) {
-              *cfg << "{";
-              *cfg << "\"kind\":\"edge\",\"fn\":";
-              emitJsonString(*cfg, F.getName());
-              *cfg << ",\"from\":";
-              emitJsonString(*cfg, bbLabels[&BB]);
-              *cfg << ",\"to\":";
-              emitJsonString(*cfg, bbLabels[BI->getSuccessor(i)]);
-              *cfg << ",\"term_pp\":";
-              emitJsonString(*cfg, termPP[&BB]);
-              *cfg << ",\"branch\":\"cond\",\"cond\":";
-              emitJsonString(*cfg, condId);
-              *cfg << ",\"sense\":";
-              emitJsonString(*cfg, (i == 0) ? "true" : "false");
-              *cfg << "}\n";
+              JsonRecord rec(*cfg, "edge", ids);
+              edgeHead(rec, BI->getSuccessor(i), "cond");
+              ids.emitValue(rec.field("cond"), BI->getCondition());
+              emitJsonString(rec.field("sense"), (i == 0) ? "true" : "false");
             }
           } else if (BI->getNumSuccessors() == 1) {
-            *cfg << "{";
-            *cfg << "\"kind\":\"edge\",\"fn\":";
-            emitJsonString(*cfg, F.getName());
-            *cfg << ",\"from\":";
-            emitJsonString(*cfg, bbLabels[&BB]);
-            *cfg << ",\"to\":";
-            emitJsonString(*cfg, bbLabels[BI->getSuccessor(0)]);
-            *cfg << ",\"term_pp\":";
-            emitJsonString(*cfg, termPP[&BB]);
-            *cfg << ",\"branch\":\"uncond\"";
-            *cfg << "}\n";
+            JsonRecord rec(*cfg, "edge", ids);
+            edgeHead(rec, BI->getSuccessor(0), "uncond");
           }
         } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
-          std::string condId =
-            getValueId(SI->getCondition(), valueIds, nextValueId);
           for (auto &Case : SI->cases()) {
-            *cfg << "{";
-            *cfg << "\"kind\":\"edge\",\"fn\":";
-            emitJsonString(*cfg, F.getName());
-            *cfg << ",\"from\":";
-            emitJsonString(*cfg, bbLabels[&BB]);
-            *cfg << ",\"to\":";
-            emitJsonString(*cfg, bbLabels[Case.getCaseSuccessor()]);
-            *cfg << ",\"term_pp\":";
-            emitJsonString(*cfg, termPP[&BB]);
-            *cfg << ",\"branch\":\"switch\",\"cond\":";
-            emitJsonString(*cfg, condId);
-            *cfg << ",\"case\":";
-            emitJsonString(*cfg,
-                           getValueId(Case.getCaseValue(),
-                                      valueIds, nextValueId));
-            *cfg << "}\n";
+            JsonRecord rec(*cfg, "edge", ids);
+            edgeHead(rec, Case.getCaseSuccessor(), "switch");
+            ids.emitValue(rec.field("cond"), SI->getCondition());
+            ids.emitValue(rec.field("case"), Case.getCaseValue());
           }
           if (const BasicBlock *Def = SI->getDefaultDest()) {
-            *cfg << "{";
-            *cfg << "\"kind\":\"edge\",\"fn\":";
-            emitJsonString(*cfg, F.getName());
-            *cfg << ",\"from\":";
-            emitJsonString(*cfg, bbLabels[&BB]);
-            *cfg << ",\"to\":";
-            emitJsonString(*cfg, bbLabels[Def]);
-            *cfg << ",\"term_pp\":";
-            emitJsonString(*cfg, termPP[&BB]);
-            *cfg << ",\"branch\":\"switch\",\"cond\":";
-            emitJsonString(*cfg, condId);
-            *cfg << ",\"default\":true";
-            *cfg << "}\n";
+            JsonRecord rec(*cfg, "edge", ids);
+            edgeHead(rec, Def, "switch");
+            ids.emitValue(rec.field("cond"), SI->getCondition());
+            rec.field("default") << "true";
           }
         } else if (auto *IB = dyn_cast<IndirectBrInst>(T)) {
-          std::string targetId =
-            getValueId(IB->getAddress(), valueIds, nextValueId);
           for (unsigned i = 0; i < IB->getNumSuccessors(); ++i) {
-            *cfg << "{";
-            *cfg << "\"kind\":\"edge\",\"fn\":";
-            emitJsonString(*cfg, F.getName());
-            *cfg << ",\"from\":";
-            emitJsonString(*cfg, bbLabels[&BB]);
-            *cfg << ",\"to\":";
-            emitJsonString(*cfg, bbLabels[IB->getSuccessor(i)]);
-            *cfg << ",\"term_pp\":";
-            emitJsonString(*cfg, termPP[&BB]);
-            *cfg << ",\"branch\":\"indirect\",\"target\":";
-            emitJsonString(*cfg, targetId);
-            *cfg << "}\n";
+            JsonRecord rec(*cfg, "edge", ids);
+            edgeHead(rec, IB->getSuccessor(i), "indirect");
+            ids.emitValue(rec.field("target"), IB->getAddress());
           }
         } else {
           for (unsigned i = 0; i < T->getNumSuccessors(); ++i) {
-            *cfg << "{";
-            *cfg << "\"kind\":\"edge\",\"fn\":";
-            emitJsonString(*cfg, F.getName());
-            *cfg << ",\"from\":";
-            emitJsonString(*cfg, bbLabels[&BB]);
-            *cfg << ",\"to\":";
-            emitJsonString(*cfg, bbLabels[T->getSuccessor(i)]);
-            *cfg << ",\"term_pp\":";
-            emitJsonString(*cfg, termPP[&BB]);
-            *cfg << ",\"branch\":";
-            emitJsonString(*cfg, T->getOpcodeName());
-            *cfg << "}\n";
+            JsonRecord rec(*cfg, "edge", ids);
+            edgeHead(rec, T->getSuccessor(i), T->getOpcodeName());
           }
         }
       }
 
+      if (loops) {
+        for (size_t i = 0; i < loops->size(); ++i) {
+          emitLoopRecord(*cfg, i, (*loops)[i], ids);
+        }
+      }
+
+      cfgTimer.stop();
+      size_t coverageBlocks = 0;
+      size_t coverageRanges = 0;
       if (MaxPaths > 0) {
+        PhaseTimer tablesTimer("PublicDataPass.path-tables", F.getName(),
+                               times.pathTables);
         unsigned emitted = 0;
         unsigned pathIdCounter = 0;
         bool truncated = false;
@@ -878,388 +3679,1459 @@ struct PublicDataPass : PassInfoMixin<PublicDataPass> {
         unsigned constPrunedBr = 0;
         unsigned constPrunedSwitch = 0;
         unsigned constPrunedIndirect = 0;
+        unsigned corrPrunedBr = 0;
+        unsigned corrPrunedSwitch = 0;
+        unsigned rangePruned = 0;
+        unsigned rangeImplied = 0;
+        unsigned rangeRestored = 0;
         unsigned dfsCalls = 0;
         unsigned dfsLeaves = 0;
         unsigned dfsPruneMaxPaths = 0;
         unsigned dfsPruneMaxDepth = 0;
         unsigned dfsPruneLoop = 0;
+        // Successor tables, built once per function so the enumerator only
+        // walks indices. Each block owns a contiguous run of choices; each
+        // conditional edge owns one Decision.
+        struct PathChoice {
+          unsigned succ;
+          int decision;  // index into decisionTable, -1 for plain edges
+        };
+        struct PathBlock {
+          const BasicBlock *bb = nullptr;
+          unsigned firstChoice = 0;
+          unsigned numChoices = 0;
+          bool leaf = false;
+          unsigned *constPruned = nullptr;  // bumped on every expansion
+        };
+        std::vector<PathBlock> blockTable(ids.bbCount());
+        std::vector<PathChoice> choiceTable;
+        std::vector<Decision> decisionTable;
+        // Each decision's successor number in its terminator, for
+        // RangeSummary::lookup.
+        std::vector<unsigned> decisionSucc;
+        for (const BasicBlock &BB : F) {
+          PathBlock &pb = blockTable[ids.bbId(&BB)];
+          pb.bb = &BB;
+          pb.firstChoice = choiceTable.size();
+          auto addEdge = [&](const BasicBlock *Succ) {
+            choiceTable.push_back({ids.bbId(Succ), -1});
+          };
+          auto addDecision = [&](const Decision &d, unsigned succ) {
+            choiceTable.push_back(
+              {ids.bbId(d.succ), static_cast<int>(decisionTable.size())});
+            decisionTable.push_back(d);
+            decisionSucc.push_back(succ);
+          };
+          const Instruction *T = BB.getTerminator();
+          pb.leaf = !T || T->getNumSuccessors() == 0;
+          if (pb.leaf) {
+            continue;
+          }
+          if (auto *BI = dyn_cast<BranchInst>(T)) {
+            if (BI->isConditional()) {
+              auto *CI = dyn_cast<ConstantInt>(BI->getCondition());
+              if (CI) pb.constPruned = &constPrunedBr;
+              for (unsigned i = 0; i < BI->getNumSuccessors(); ++i) {
+                if (CI && i != (CI->isZero() ? 1u : 0u)) continue;
+                Decision d;
+                d.term = T;
+                d.kind = "br";
+                d.cond = BI->getCondition();
+                d.succ = BI->getSuccessor(i);
+                d.sense = (i == 0) ? "true" : "false";
+                addDecision(d, i);
+              }
+            } else {
+              addEdge(BI->getSuccessor(0));
+            }
+          } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
+            Decision d;
+            d.term = T;
+            d.kind = "switch";
+            d.cond = SI->getCondition();
+            Decision def = d;
+            def.succ = SI->getDefaultDest();
+            def.isDefault = true;
+            if (auto *CI = dyn_cast<ConstantInt>(SI->getCondition())) {
+              pb.constPruned = &constPrunedSwitch;
+              auto Case = SI->findCaseValue(CI);
+              if (Case != SI->case_default()) {
+                d.succ = Case->getCaseSuccessor();
+                d.caseValue = Case->getCaseValue();
+                addDecision(d, Case->getCaseIndex());
+              } else if (def.succ) {
+                addDecision(def, SI->getNumCases());
+              }
+            } else {
+              for (auto &Case : SI->cases()) {
+                d.succ = Case.getCaseSuccessor();
+                d.caseValue = Case.getCaseValue();
+                addDecision(d, Case.getCaseIndex());
+              }
+              if (def.succ) addDecision(def, SI->getNumCases());
+            }
+          } else if (auto *IB = dyn_cast<IndirectBrInst>(T)) {
+            Decision d;
+            d.term = T;
+            d.kind = "indirect";
+            d.target = IB->getAddress();
+            if (auto *BA = dyn_cast<BlockAddress>(IB->getAddress())) {
+              pb.constPruned = &constPrunedIndirect;
+              d.succ = BA->getBasicBlock();
+              addDecision(d, 0);
+            } else {
+              for (unsigned i = 0; i < IB->getNumSuccessors(); ++i) {
+                d.succ = IB->getSuccessor(i);
+                addDecision(d, i);
+              }
+            }
+          } else {
+            for (unsigned i = 0; i < T->getNumSuccessors(); ++i) {
+              addEdge(T->getSuccessor(i));
+            }
+          }
+          pb.numChoices = choiceTable.size() - pb.firstChoice;
+        }
+
+        tablesTimer.stop();
+
+        // Exact path count under the enumerator's limits and range pruning,
+        // minus MaxPaths and correlation pruning. Memoized on (block,
+        // entering edge when range verdicts depend on it, depth when it can
+        // bind, visit counts of blocks on cycles), which is all the
+        // enumerator's future depends on, so acyclic functions cost one
+        // state per block or edge.
+        PhaseTimer countTimer("PublicDataPass.path-count", F.getName(),
+                              times.pathCount);
+        std::vector<unsigned> cyclicBlocks;
+        for (auto SCC = scc_begin(&F); !SCC.isAtEnd(); ++SCC) {
+          if (!SCC.hasCycle()) continue;
+          for (const BasicBlock *SBB : *SCC) cyclicBlocks.push_back(ids.bbId(SBB));
+        }
+        llvm::sort(cyclicBlocks);
+        std::vector<bool> rangeBlocks(ids.bbCount(), false);
+        for (const auto &entry : analyses.ranges.verdicts) {
+          rangeBlocks[ids.bbId(entry.first.second)] = true;
+        }
+        uint64_t maxPathLen =
+          static_cast<uint64_t>(ids.bbCount()) * (uint64_t(MaxLoopIters) + 1);
+        bool depthBinds = maxPathLen > MaxPathDepth;
+        bool pathCountKnown = PathCountMaxStates > 0;
+        PathCount pathCount = 0;
+        if (pathCountKnown) {
+          // Leaves below a state, and whether a depth or loop limit cut
+          // any of its paths (which makes a block retry its range-pruned
+          // choices when nothing else reaches a leaf).
+          struct CountResult {
+            PathCount count;
+            bool cutoff;
+          };
+          struct CountFrame {
+            unsigned bb;
+            unsigned pred;  // bbCount() for the entry block
+            unsigned nextChoice;
+            unsigned endChoice;
+            CountResult acc;
+            bool rangeCut;
+            bool rangeRetry;
+            std::string key;
+          };
+          StringMap<CountResult> memo;
+          std::vector<CountFrame> countStack;
+          std::vector<unsigned> countVisits(ids.bbCount(), 0);
+          auto appendKey = [](std::string &key, uint32_t v) {
+            key.append(reinterpret_cast<const char *>(&v), sizeof(v));
+          };
+          auto rangeInfeasible = [&](const PathChoice &c, unsigned pred) {
+            if (c.decision < 0 || analyses.ranges.verdicts.empty()) return false;
+            const BasicBlock *bb = decisionTable[c.decision].term->getParent();
+            const BasicBlock *from =
+              pred < ids.bbCount() ? blockTable[pred].bb : nullptr;
+            return analyses.ranges.lookup(from, bb, decisionSucc[c.decision]) ==
+                   RangeVerdict::Infeasible;
+          };
+          auto addResult = [](CountResult &acc, const CountResult &r) {
+            acc.count = addPathCount(acc.count, r.count);
+            acc.cutoff |= r.cutoff;
+          };
+          // Resolve bb to a known result, or push a frame and return true.
+          auto open = [&](unsigned bb, unsigned pred, CountResult &result) {
+            result = {0, false};
+            if (countStack.size() >= MaxPathDepth ||
+                countVisits[bb] >= MaxLoopIters + 1) {
+              result.cutoff = true;
+              return false;
+            }
+            const PathBlock &pb = blockTable[bb];
+            if (pb.leaf) {
+              result.count = 1;
+              return false;
+            }
+            std::string key;
+            appendKey(key, bb);
+            if (rangeBlocks[bb]) appendKey(key, pred);
+            if (depthBinds) appendKey(key, countStack.size());
+            for (unsigned cb : cyclicBlocks) appendKey(key, countVisits[cb]);
+            auto it = memo.find(key);
+            if (it != memo.end()) {
+              result = it->second;
+              return false;
+            }
+            countVisits[bb]++;
+            countStack.push_back({bb, pred, pb.firstChoice,
+                                  pb.firstChoice + pb.numChoices, {0, false},
+                                  false, false, std::move(key)});
+            return true;
+          };
+          CountResult result;
+          if (!open(ids.bbId(&F.getEntryBlock()), ids.bbCount(), result)) {
+            pathCount = result.count;
+          }
+          while (!countStack.empty()) {
+            CountFrame &top = countStack.back();
+            if (top.nextChoice < top.endChoice) {
+              const PathChoice &c = choiceTable[top.nextChoice++];
+              bool infeasible = rangeInfeasible(c, top.pred);
+              if (infeasible) top.rangeCut = true;
+              if (infeasible != top.rangeRetry) continue;
+              if (!open(c.succ, top.bb, result)) {
+                addResult(countStack.back().acc, result);
+              }
+              continue;
+            }
+            // Same fallback as the enumerator: retry the range-pruned
+            // choices when the others reached no leaf, only a limit.
+            if (top.rangeCut && !top.rangeRetry && top.acc.count == 0 &&
+                top.acc.cutoff) {
+              top.rangeRetry = true;
+              top.nextChoice = top.endChoice - blockTable[top.bb].numChoices;
+              continue;
+            }
+            countVisits[top.bb]--;
+            result = top.acc;
+            budget.hold(sizeof(StringMapEntry<CountResult>) + top.key.size());
+            memo[top.key] = result;
+            countStack.pop_back();
+            if (countStack.empty()) pathCount = result.count;
+            else addResult(countStack.back().acc, result);
+            if (memo.size() > PathCountMaxStates || budget.exhausted()) {
+              pathCountKnown = false;
+              break;
+            }
+          }
+        }
+
+        countTimer.stop();
+
+        PhaseTimer pathsTimer("PublicDataPass.paths", F.getName(), times.paths);
+        // Condition text is rendered the first time a decision reaches an
+        // emitted record and reused for every later path through that edge.
+        std::vector<std::string> condTexts(decisionTable.size());
+        std::vector<CondExpr> condExprs(decisionTable.size());
+        std::vector<bool> condRendered(decisionTable.size(), false);
+        auto renderCond = [&](unsigned di) {
+          if (condRendered[di]) return;
+          condRendered[di] = true;
+          if (emitCondStr) condTexts[di] = buildDecisionCond(decisionTable[di], ids);
+          if (emitCondJson) {
+            condExprs[di] = buildDecisionCondExpr(decisionTable[di], ids);
+          }
+        };
+        // DFS state: the current path, the decision taken into each block
+        // that has one, and one stack frame per path block.
+        struct PathFrame {
+          unsigned bb;
+          unsigned nextChoice;
+          unsigned endChoice;
+          bool hasDecision;
+          bool revisit;
+          // Range-pruning fallback: leaves reached and depth/loop cutoffs
+          // before the frame was entered, whether a choice was range-pruned,
+          // and whether the pruned choices are being retried.
+          unsigned leavesBefore = 0;
+          unsigned cutoffsBefore = 0;
+          bool rangeCut = false;
+          bool rangeRetry = false;
+        };
+        std::vector<PathFrame> stack;
         std::vector<const BasicBlock *> path;
-        std::vector<Decision> decisions;
-        std::vector<std::string> conds;
-        std::vector<CondExpr> condExprs;
-        StringMap<SmallVector<unsigned, 8>> ppToPaths;
-        DenseMap<const BasicBlock *, unsigned> visitCount;
-
-        std::function<void(const BasicBlock *)> dfs =
-          [&](const BasicBlock *BB) {
-            dfsCalls++;
-            if (emitted >= MaxPaths) {
-              truncated = true;
-              dfsPruneMaxPaths++;
-              return;
+        std::vector<unsigned> decisions;
+        std::vector<unsigned> visitCount(ids.bbCount(), 0);
+        // Cond table: each decision on the current path gets its cond
+        // record before the first path or segment record that names it.
+        std::vector<bool> condEmitted(CondTable ? decisionTable.size() : 0,
+                                      false);
+        auto emitPendingConds = [&]() {
+          for (unsigned di : decisions) {
+            if (condEmitted[di]) continue;
+            condEmitted[di] = true;
+            renderCond(di);
+            JsonRecord rec(*cfg, "cond", ids);
+            rec.field("cond_id") << di;
+            emitDecision(rec.field("decision"), decisionTable[di], ids);
+            if (emitCondStr) {
+              emitJsonString(rec.field("path_cond"), condTexts[di]);
+            }
+            if (emitCondJson) {
+              emitCondExpr(rec.field("path_cond_json"), condExprs[di]);
+            }
+          }
+        };
+        auto emitCondRefs = [&](raw_ostream &out, ArrayRef<unsigned> ds) {
+          out << ",\"conds\":[";
+          for (size_t i = 0; i < ds.size(); ++i) {
+            if (i) out << ",";
+            out << ds[i];
+          }
+          out << "]";
+        };
+
+        // Correlation pruning: the path index of the block each decision
+        // left from, and the indices of revisited blocks. Re-entering a
+        // block re-defines its values, so decisions made before the latest
+        // revisit no longer describe live SSA instances.
+        std::vector<unsigned> decisionFrom;
+        std::vector<unsigned> revisitDepths;
+        DenseMap<std::pair<unsigned, unsigned>, bool> contradictCache;
+        const DataLayout &DL = F.getParent()->getDataLayout();
+        auto contradictsPath = [&](unsigned di) {
+          unsigned liveFrom = revisitDepths.empty() ? 0 : revisitDepths.back();
+          for (size_t k = decisions.size(); k-- > 0;) {
+            if (decisionFrom[k] < liveFrom) break;
+            auto key = std::make_pair(decisions[k], di);
+            auto it = contradictCache.find(key);
+            if (it == contradictCache.end()) {
+              bool c = decisionContradicts(decisionTable[decisions[k]],
+                                           decisionTable[di], DL);
+              it = contradictCache.insert({key, c}).first;
+              budget.hold(sizeof(*it));
+            }
+            if (it->second) return true;
+          }
+          return false;
+        };
+        // Range pruning: a decision LazyValueInfo proves infeasible on the
+        // edge into its block is cut (RangePrunedDecision); one it proves
+        // implied is taken as a plain edge, so it adds no path condition.
+        constexpr int RangePrunedDecision = -2;
+        const RangeSummary &ranges = analyses.ranges;
+        auto rangeVerdict = [&](int decision, const BasicBlock *pred) {
+          if (decision < 0 || ranges.verdicts.empty()) {
+            return RangeVerdict::Unknown;
+          }
+          const BasicBlock *bb = decisionTable[decision].term->getParent();
+          return ranges.lookup(pred, bb, decisionSucc[decision]);
+        };
+        auto rangeDecision = [&](int decision, const BasicBlock *pred) {
+          switch (rangeVerdict(decision, pred)) {
+          case RangeVerdict::Infeasible:
+            rangePruned++;
+            return RangePrunedDecision;
+          case RangeVerdict::Implied:
+            rangeImplied++;
+            return -1;
+          case RangeVerdict::Unknown:
+            break;
+          }
+          return decision;
+        };
+        // pp coverage is tracked per block (every pp in a block shares its
+        // paths) and expanded per pp only when pp_coverage is written.
+        std::vector<PathIdRanges> blockPaths;
+        std::vector<unsigned> coveredOrder;
+        if (EmitPpCoverage) blockPaths.resize(ids.bbCount());
+        // Path dedup: leaf records are held back until enumeration ends,
+        // one per class of paths sharing the sequence of transmitter-relevant
+        // blocks. Members may differ in decisions whose arms are irrelevant,
+        // so the class keeps only the decisions every member takes equally
+        // often. Trie leaves imply their prefix's decisions, so trie
+        // encoding does not deduplicate.
+        bool dedup = DedupPaths && !regionMode && !trieEncoding;
+        bool sliceEnabled = PathSlice && !trieEncoding;
+        std::vector<bool> relevantBlocks;
+        if (dedup) relevantBlocks = txRelevantBlocks(F, ids);
+        struct PathClass {
+          // The representative's record up to its bbs, and its pp_seq and
+          // slice_pps fields.
+          std::string head;
+          std::string body;
+          SmallVector<unsigned, 8> decisions;
+          // Times each decision is taken by every member so far; ~0u once
+          // two members disagree.
+          DenseMap<unsigned, unsigned> shared;
+          SmallVector<unsigned, 4> members;
+        };
+        auto countDecisions = [&]() {
+          DenseMap<unsigned, unsigned> counts;
+          for (unsigned di : decisions) counts[di]++;
+          return counts;
+        };
+        auto emitPathConds = [&](raw_ostream &out, ArrayRef<unsigned> ds) {
+          if (emitCondStr && !CondTable) {
+            out << ",\"path_cond\":[";
+            for (size_t i = 0; i < ds.size(); ++i) {
+              if (i) out << ",";
+              emitJsonString(out, condTexts[ds[i]]);
             }
-            if (path.size() >= MaxPathDepth) {
-              cutoffDepth = true;
-              dfsPruneMaxDepth++;
-              return;
+            out << "]";
+          }
+          if (emitCondJson && !CondTable) {
+            out << ",\"path_cond_json\":[";
+            for (size_t i = 0; i < ds.size(); ++i) {
+              if (i) out << ",";
+              emitCondExpr(out, condExprs[ds[i]]);
             }
+            out << "]";
+          }
+        };
+        auto emitDecisionRefs = [&](raw_ostream &out, ArrayRef<unsigned> ds) {
+          if (CondTable) {
+            emitCondRefs(out, ds);
+            return;
+          }
+          out << ",\"decisions\":[";
+          for (size_t i = 0; i < ds.size(); ++i) {
+            if (i) out << ",";
+            emitDecision(out, decisionTable[ds[i]], ids);
+          }
+          out << "]";
+        };
+        std::vector<PathClass> pathClasses;
+        StringMap<unsigned> classByKey;
+        // Trie encoding: node id per path depth (-1 until first emitted) and
+        // the decisions.size() observed on entry to that depth.
+        std::vector<int> nodeIds;
+        std::vector<size_t> nodeDecisionCount;
+        unsigned nodeIdCounter = 0;
+        stack.reserve(MaxPathDepth < 1024 ? MaxPathDepth : 1024);
 
-            unsigned count = visitCount[BB];
-            unsigned maxVisits = MaxLoopIters + 1;
-            if (count >= maxVisits) {
-              cutoffLoop = true;
-              dfsPruneLoop++;
-              return;
+        // Emit path_node records for every not-yet-emitted prefix node.
+        auto emitPendingNodes = [&]() {
+          for (size_t depth = 0; depth < path.size(); ++depth) {
+            if (nodeIds[depth] >= 0) continue;
+            int nodeId = static_cast<int>(nodeIdCounter++);
+            nodeIds[depth] = nodeId;
+            JsonRecord rec(*cfg, "path_node", ids);
+            rec.field("node_id") << nodeId;
+            rec.field("parent");
+            if (depth == 0) *cfg << "null";
+            else *cfg << nodeIds[depth - 1];
+            rec.field("depth") << depth;
+            ids.emitBB(rec.field("bb"), path[depth]);
+            if (depth > 0 &&
+                nodeDecisionCount[depth] > nodeDecisionCount[depth - 1]) {
+              unsigned di = decisions[nodeDecisionCount[depth] - 1];
+              renderCond(di);
+              emitDecision(rec.field("decision"), decisionTable[di], ids);
+              if (emitCondStr) {
+                emitJsonString(rec.field("path_cond"), condTexts[di]);
+              }
+              if (emitCondJson) {
+                emitCondExpr(rec.field("path_cond_json"), condExprs[di]);
+              }
+            }
+            if (IncludePpSeq) {
+              rec.field("pp_seq") << "[";
+              bool firstPP = true;
+              for (const Instruction &I : *path[depth]) {
+                if (!firstPP) *cfg << ",";
+                firstPP = false;
+                ids.emitPP(*cfg, &I);
+              }
+              *cfg << "]";
             }
-            visitCount[BB] = count + 1;
-            path.push_back(BB);
+          }
+        };
 
-            const Instruction *T = BB->getTerminator();
-            unsigned succCount = T ? T->getNumSuccessors() : 0;
-            if (!T || succCount == 0) {
-              dfsLeaves++;
-              unsigned pathId = pathIdCounter++;
-              std::vector<std::string> ppSeq;
-              if (IncludePpSeq || EmitPpCoverage) {
-                for (const BasicBlock *PBB : path) {
-                  auto it = bbPpSeq.find(PBB);
-                  if (it == bbPpSeq.end()) continue;
-                  const std::vector<std::string> &pps = it->second;
-                  ppSeq.insert(ppSeq.end(), pps.begin(), pps.end());
+        // Blocks on emitted paths, and successors of range-pruned edges, for
+        // range_uncovered.
+        std::vector<bool> pathCovered;
+        std::vector<bool> rangeCutBlocks;
+        if (!ranges.verdicts.empty()) {
+          pathCovered.assign(ids.bbCount(), false);
+          rangeCutBlocks.assign(ids.bbCount(), false);
+        }
+
+        auto emitLeaf = [&]() {
+          dfsLeaves++;
+          unsigned pathId = pathIdCounter++;
+          if (!pathCovered.empty()) {
+            for (const BasicBlock *PBB : path) pathCovered[ids.bbId(PBB)] = true;
+          }
+          if (EmitPpCoverage) {
+            for (const BasicBlock *PBB : path) {
+              unsigned bb = ids.bbId(PBB);
+              PathIdRanges &ranges = blockPaths[bb];
+              if (ranges.empty()) coveredOrder.push_back(bb);
+              size_t runs = ranges.size();
+              addPathId(ranges, pathId);
+              if (ranges.size() != runs) budget.hold(sizeof(ranges[0]));
+            }
+          }
+
+          std::string leafText;
+          raw_string_ostream leafOS(leafText);
+          raw_ostream &out = dedup ? static_cast<raw_ostream &>(leafOS) : *cfg;
+          size_t headEnd = 0;
+          if (trieEncoding) {
+            emitPendingNodes();
+            out << "{";
+            out << "\"kind\":\"path\",\"fn\":";
+            ids.emitFn(out);
+            out << ",\"path_id\":" << pathId;
+            out << ",\"leaf\":" << nodeIds.back();
+            out << ",\"depth\":" << path.size();
+            out << "}\n";
+          } else {
+            if (CondTable) emitPendingConds();
+            else for (unsigned di : decisions) renderCond(di);
+            out << "{";
+            out << "\"kind\":\"path\",\"fn\":";
+            ids.emitFn(out);
+            out << ",\"path_id\":" << pathId;
+            out << ",\"bbs\":[";
+            for (size_t i = 0; i < path.size(); ++i) {
+              if (i) out << ",";
+              ids.emitBB(out, path[i]);
+            }
+            out << "]";
+            if (dedup) headEnd = leafOS.str().size();
+            else emitDecisionRefs(out, decisions);
+            if (IncludePpSeq) {
+              out << ",\"pp_seq\":[";
+              bool firstPP = true;
+              for (const BasicBlock *PBB : path) {
+                for (const Instruction &I : *PBB) {
+                  if (!firstPP) out << ",";
+                  firstPP = false;
+                  ids.emitPP(out, &I);
+                }
+              }
+              out << "]";
+            }
+            if (sliceEnabled) {
+              std::vector<bool> inSlice = pathSlice(path, ids);
+              out << ",\"slice_pps\":[";
+              bool firstPP = true;
+              for (const BasicBlock &SBB : F) {
+                for (const Instruction &I : SBB) {
+                  if (!inSlice[ids.ppId(&I)]) continue;
+                  if (!firstPP) out << ",";
+                  firstPP = false;
+                  ids.emitPP(out, &I);
                 }
               }
-              if (EmitPpCoverage) {
-                DenseSet<StringRef> seen;
-                for (const std::string &pp : ppSeq) {
-                  StringRef key(pp);
-                  if (!seen.insert(key).second) continue;
-                  ppToPaths[key].push_back(pathId);
+              out << "]";
+            }
+            if (!dedup) {
+              emitPathConds(out, decisions);
+              out << "}\n";
+            }
+          }
+          if (dedup) {
+            SmallVector<unsigned, 32> sig;
+            for (const BasicBlock *PBB : path) {
+              unsigned id = ids.bbId(PBB);
+              if (relevantBlocks[id]) sig.push_back(id);
+            }
+            StringRef key(reinterpret_cast<const char *>(sig.data()),
+                          sig.size() * sizeof(unsigned));
+            auto ins = classByKey.try_emplace(key, pathClasses.size());
+            DenseMap<unsigned, unsigned> counts = countDecisions();
+            if (ins.second) {
+              leafOS.flush();
+              PathClass pc;
+              pc.body = leafText.substr(headEnd);
+              leafText.resize(headEnd);
+              pc.head = std::move(leafText);
+              pc.decisions.assign(decisions.begin(), decisions.end());
+              pc.shared = std::move(counts);
+              budget.hold(sizeof(PathClass) + key.size() + pc.head.size() +
+                          pc.body.size() +
+                          pc.decisions.size() * sizeof(unsigned) +
+                          pc.shared.getMemorySize());
+              pathClasses.push_back(std::move(pc));
+            } else {
+              PathClass &pc = pathClasses[ins.first->second];
+              for (auto &entry : pc.shared) {
+                auto it = counts.find(entry.first);
+                if (it == counts.end() || it->second != entry.second) {
+                  entry.second = ~0u;
                 }
               }
+            }
+            pathClasses[ins.first->second].members.push_back(pathId);
+            budget.hold(sizeof(unsigned));
+          }
+          emitted++;
+        };
+
+        // Guided orders (-public-data-path-order): each walk follows the
+        // successor with the most not-yet-covered weight reachable over the
+        // loop-bounded DAG (back edges dropped), backtracks only past dead
+        // ends and stops at its first leaf. Walks repeat while they add
+        // coverage; plain DFS then fills the rest of the budget, skipping
+        // the paths the walks already emitted.
+        enum class WalkResult { None, Emitted, Repeated };
+        WalkResult walkResult = WalkResult::None;
+        bool guiding = false;
+        unsigned pathsGuided = 0;
+        StringSet<> guidedKeys;
+        std::vector<unsigned> guidedChoices;
+        std::vector<unsigned> rpoIndex;
+        std::vector<unsigned> rpoBlocks;
+        std::vector<uint64_t> orderWeight;
+        std::vector<uint64_t> orderGain;
+        std::vector<bool> orderCovered;
+        if (guidedOrder) {
+          rpoIndex.assign(ids.bbCount(), 0);
+          ReversePostOrderTraversal<const Function *> RPOT(&F);
+          for (const BasicBlock *RBB : RPOT) {
+            rpoIndex[ids.bbId(RBB)] = rpoBlocks.size();
+            rpoBlocks.push_back(ids.bbId(RBB));
+          }
+          // A block weighs its pps; under tx-density each transmitter also
+          // outweighs every pp in the function, so pps only break ties.
+          uint64_t txUnit = uint64_t(F.getInstructionCount()) + 1;
+          orderWeight.assign(ids.bbCount(), 0);
+          for (const BasicBlock &WBB : F) {
+            uint64_t &w = orderWeight[ids.bbId(&WBB)];
+            for (const Instruction &I : WBB) {
+              w++;
+              if (txOrder && !getTransmitterInfos(I).empty()) w += txUnit;
+            }
+          }
+          orderGain.assign(ids.bbCount(), 0);
+          orderCovered.assign(ids.bbCount(), false);
+        }
+        // Best uncovered weight on any forward path from each block.
+        auto recomputeGain = [&]() {
+          for (size_t k = rpoBlocks.size(); k-- > 0;) {
+            unsigned bb = rpoBlocks[k];
+            const PathBlock &pb = blockTable[bb];
+            uint64_t best = 0;
+            for (unsigned c = pb.firstChoice; c < pb.firstChoice + pb.numChoices;
+                 ++c) {
+              unsigned succ = choiceTable[c].succ;
+              if (rpoIndex[succ] > rpoIndex[bb]) {
+                best = std::max(best, orderGain[succ]);
+              }
+            }
+            orderGain[bb] = (orderCovered[bb] ? 0 : orderWeight[bb]) + best;
+          }
+        };
+        // Walk score of choice ci out of bb; blocks already on the walk add
+        // nothing new.
+        auto choiceScore = [&](unsigned bb, unsigned ci) -> uint64_t {
+          unsigned succ = choiceTable[ci].succ;
+          if (rpoIndex[succ] <= rpoIndex[bb]) return 0;
+          uint64_t gain = orderGain[succ];
+          if (visitCount[succ] > 0 && !orderCovered[succ]) {
+            gain -= orderWeight[succ];
+          }
+          return gain;
+        };
+        auto pathKey = [&]() {
+          std::string key;
+          auto append = [&key](uint32_t v) {
+            key.append(reinterpret_cast<const char *>(&v), sizeof(v));
+          };
+          for (const BasicBlock *PBB : path) append(ids.bbId(PBB));
+          append(~0u);
+          for (unsigned di : decisions) append(di);
+          return key;
+        };
+        unsigned leavesReached = 0;
+        auto reachLeaf = [&]() {
+          leavesReached++;
+          if (!guidedOrder) {
+            emitLeaf();
+          } else if (!guiding) {
+            if (!guidedKeys.count(pathKey())) emitLeaf();
+          } else if (guidedKeys.insert(pathKey()).second) {
+            budget.hold(sizeof(StringMapEntryBase) +
+                        (path.size() + decisions.size() + 1) * sizeof(uint32_t));
+            emitLeaf();
+            pathsGuided++;
+            for (const BasicBlock *PBB : path) orderCovered[ids.bbId(PBB)] = true;
+            walkResult = WalkResult::Emitted;
+          } else {
+            walkResult = WalkResult::Repeated;
+          }
+        };
 
-              *cfg << "{";
-              *cfg << "\"kind\":\"path\",\"fn\":";
-              emitJsonString(*cfg, F.getName());
-              *cfg << ",\"path_id\":" << pathId;
-              *cfg << ",\"bbs\":[";
-              for (size_t i = 0; i < path.size(); ++i) {
-                if (i) *cfg << ",";
-                emitJsonString(*cfg, bbLabels[path[i]]);
+        // Try to extend the path with block bb reached through decision
+        // (or -1). Applies the path/depth/loop limits before pushing.
+        auto enter = [&](unsigned bb, int decision) {
+          dfsCalls++;
+          if (budget.exhausted()) return;
+          if (emitted >= MaxPaths) {
+            truncated = true;
+            dfsPruneMaxPaths++;
+            return;
+          }
+          if (path.size() >= MaxPathDepth) {
+            cutoffDepth = true;
+            dfsPruneMaxDepth++;
+            return;
+          }
+          unsigned maxVisits = MaxLoopIters + 1;
+          if (visitCount[bb] >= maxVisits) {
+            cutoffLoop = true;
+            dfsPruneLoop++;
+            return;
+          }
+          bool revisit = visitCount[bb] > 0;
+          visitCount[bb]++;
+          const PathBlock &pb = blockTable[bb];
+          if (decision >= 0) {
+            decisions.push_back(decision);
+            decisionFrom.push_back(path.size() - 1);
+          }
+          if (revisit) revisitDepths.push_back(path.size());
+          path.push_back(pb.bb);
+          if (trieEncoding) {
+            nodeIds.push_back(-1);
+            nodeDecisionCount.push_back(decisions.size());
+          }
+          unsigned firstChoice = pb.firstChoice;
+          unsigned endChoice = pb.firstChoice + pb.numChoices;
+          if (guiding) {
+            // Frames index guidedChoices, best-scoring choice first.
+            firstChoice = guidedChoices.size();
+            for (unsigned c = pb.firstChoice; c < endChoice; ++c) {
+              guidedChoices.push_back(c);
+            }
+            endChoice = guidedChoices.size();
+            std::stable_sort(guidedChoices.begin() + firstChoice,
+                             guidedChoices.end(), [&](unsigned a, unsigned b) {
+                               return choiceScore(bb, a) > choiceScore(bb, b);
+                             });
+          }
+          stack.push_back({bb, firstChoice, endChoice, decision >= 0, revisit,
+                           leavesReached, dfsPruneMaxDepth + dfsPruneLoop});
+          if (pb.leaf) reachLeaf();
+          else if (pb.constPruned) ++*pb.constPruned;
+        };
+
+        auto leave = [&]() {
+          PathFrame &top = stack.back();
+          visitCount[top.bb]--;
+          if (top.hasDecision) {
+            decisions.pop_back();
+            decisionFrom.pop_back();
+          }
+          if (top.revisit) revisitDepths.pop_back();
+          path.pop_back();
+          if (trieEncoding) {
+            nodeIds.pop_back();
+            nodeDecisionCount.pop_back();
+          }
+          if (guiding) {
+            guidedChoices.resize(top.endChoice - blockTable[top.bb].numChoices);
+          }
+          stack.pop_back();
+        };
+        // Runs the DFS from the current stack until it empties or a guided
+        // walk reaches its leaf. A frame whose choices reached no leaf, only
+        // the depth or loop limit (e.g. a constant-trip loop under
+        // max_loop_iters 0), retries the choices range pruning cut, so the
+        // blocks past them keep a path.
+        auto runDfs = [&]() {
+          while (!stack.empty() && walkResult == WalkResult::None) {
+            PathFrame &top = stack.back();
+            if (top.nextChoice < top.endChoice) {
+              unsigned ci = top.nextChoice++;
+              const PathChoice &c = choiceTable[guiding ? guidedChoices[ci] : ci];
+              const BasicBlock *pred =
+                stack.size() > 1 ? blockTable[stack[stack.size() - 2].bb].bb
+                                 : nullptr;
+              int decision = c.decision;
+              if (top.rangeRetry) {
+                if (rangeVerdict(decision, pred) != RangeVerdict::Infeasible) {
+                  continue;
+                }
+              } else {
+                decision = rangeDecision(decision, pred);
+                if (decision == RangePrunedDecision) {
+                  top.rangeCut = true;
+                  rangeCutBlocks[c.succ] = true;
+                  continue;
+                }
+              }
+              if (PruneCorrelated && decision >= 0 &&
+                  contradictsPath(decision)) {
+                if (isa<SwitchInst>(decisionTable[decision].term)) {
+                  corrPrunedSwitch++;
+                } else {
+                  corrPrunedBr++;
+                }
+                continue;
+              }
+              if (top.rangeRetry) rangeRestored++;
+              enter(c.succ, decision);
+              continue;
+            }
+            if (top.rangeCut && !top.rangeRetry && emitted < MaxPaths &&
+                leavesReached == top.leavesBefore &&
+                dfsPruneMaxDepth + dfsPruneLoop != top.cutoffsBefore) {
+              top.rangeRetry = true;
+              top.nextChoice = top.endChoice - blockTable[top.bb].numChoices;
+              continue;
+            }
+            leave();
+          }
+        };
+
+        unsigned entryBB = ids.bbId(&F.getEntryBlock());
+        if (guidedOrder) {
+          guiding = true;
+          recomputeGain();
+          while (emitted < MaxPaths && orderGain[entryBB] > 0 &&
+                 !budget.exhausted()) {
+            walkResult = WalkResult::None;
+            enter(entryBB, -1);
+            runDfs();
+            while (!stack.empty()) leave();
+            if (walkResult != WalkResult::Emitted) break;
+            recomputeGain();
+          }
+          guiding = false;
+          walkResult = WalkResult::None;
+        }
+        // The count ignores correlation pruning, so reaching it means the
+        // walks already emitted every path.
+        bool allGuided = guidedOrder && pathCountKnown && emitted >= pathCount;
+        if (!regionMode && !allGuided) {
+          enter(entryBB, -1);
+          runDfs();
+        }
+        for (const PathClass &pc : pathClasses) {
+          SmallVector<unsigned, 8> shared;
+          for (unsigned di : pc.decisions) {
+            if (pc.shared.lookup(di) != ~0u) shared.push_back(di);
+          }
+          *cfg << pc.head;
+          emitDecisionRefs(*cfg, shared);
+          *cfg << pc.body;
+          emitPathConds(*cfg, shared);
+          *cfg << ",\"class_size\":" << pc.members.size();
+          *cfg << ",\"members\":[";
+          for (size_t i = 0; i < pc.members.size(); ++i) {
+            if (i) *cfg << ",";
+            *cfg << pc.members[i];
+          }
+          *cfg << "]}\n";
+        }
+        // Region mode: enumerate paths per single-entry/single-exit region
+        // with each child region collapsed to one element, so sequential
+        // diamonds cost a few segments each instead of multiplying.
+        unsigned segmentsEmitted = 0;
+        unsigned regionCount = 0;
+        if (regionMode && RI) {
+          auto regionFor = [&](const BasicBlock *BB) -> const Region * {
+            return RI->getRegionFor(const_cast<BasicBlock *>(BB));
+          };
+          // Preorder region list, children ordered by entry block.
+          std::vector<const Region *> regions;
+          DenseMap<const Region *, unsigned> regionIds;
+          std::vector<const Region *> work{RI->getTopLevelRegion()};
+          while (!work.empty()) {
+            const Region *R = work.back();
+            work.pop_back();
+            regionIds[R] = regions.size();
+            regions.push_back(R);
+            SmallVector<const Region *, 8> kids;
+            for (const auto &SR : *R) kids.push_back(SR.get());
+            llvm::sort(kids, [&](const Region *A, const Region *B) {
+              return ids.bbId(A->getEntry()) < ids.bbId(B->getEntry());
+            });
+            work.insert(work.end(), kids.rbegin(), kids.rend());
+          }
+          regionCount = regions.size();
+
+          for (unsigned r = 0; r < regions.size(); ++r) {
+            const Region *R = regions[r];
+            JsonRecord rec(*cfg, "region", ids);
+            rec.field("region_id") << r;
+            rec.field("parent");
+            if (R->getParent()) *cfg << regionIds.lookup(R->getParent());
+            else *cfg << "null";
+            rec.field("depth") << R->getDepth();
+            ids.emitBB(rec.field("entry"), R->getEntry());
+            rec.field("exit");
+            if (R->getExit()) ids.emitBB(*cfg, R->getExit());
+            else *cfg << "null";
+            rec.field("bbs") << "[";
+            bool firstBB = true;
+            for (const BasicBlock &BB : F) {
+              if (regionFor(&BB) != R) continue;
+              if (!firstBB) *cfg << ",";
+              firstBB = false;
+              ids.emitBB(*cfg, &BB);
+            }
+            *cfg << "],\"subregions\":[";
+            bool firstSub = true;
+            for (const auto &SR : *R) {
+              if (!firstSub) *cfg << ",";
+              firstSub = false;
+              *cfg << regionIds.lookup(SR.get());
+            }
+            *cfg << "]";
+          }
+
+          // Region-local element graph: a directly contained block or a
+          // child region; elem -1 is the region exit.
+          struct SegElem {
+            const BasicBlock *bb = nullptr;
+            const Region *region = nullptr;
+            unsigned firstChoice = 0;
+            unsigned numChoices = 0;
+            bool leaf = false;
+          };
+          struct SegChoice {
+            int elem;
+            int decision;
+          };
+          struct SegFrame {
+            unsigned elem;
+            unsigned nextChoice;
+            unsigned endChoice;
+            bool hasDecision;
+            bool revisit;
+          };
+          std::vector<SegElem> elems;
+          std::vector<SegChoice> segChoices;
+          std::vector<SegFrame> segStack;
+          std::vector<unsigned> elemVisits;
+          DenseMap<const void *, unsigned> elemIndex;
+          unsigned segmentIdCounter = 0;
+
+          for (unsigned r = 0; r < regions.size(); ++r) {
+            const Region *R = regions[r];
+            elems.clear();
+            segChoices.clear();
+            elemIndex.clear();
+            std::vector<unsigned> pending;
+            auto elemOf = [&](const BasicBlock *BB) -> int {
+              if (BB == R->getExit()) return -1;
+              const Region *X = regionFor(BB);
+              while (X && X != R && X->getParent() != R) X = X->getParent();
+              if (!X) return -1;
+              const void *key = X == R ? static_cast<const void *>(BB) : X;
+              auto it = elemIndex.find(key);
+              if (it != elemIndex.end()) return it->second;
+              SegElem e;
+              if (X == R) e.bb = BB;
+              else e.region = X;
+              unsigned idx = elems.size();
+              elems.push_back(e);
+              elemIndex[key] = idx;
+              pending.push_back(idx);
+              return idx;
+            };
+            elemOf(R->getEntry());
+            // Choices are laid out per element in discovery order.
+            for (size_t next = 0; next < pending.size(); ++next) {
+              unsigned idx = pending[next];
+              elems[idx].firstChoice = segChoices.size();
+              if (const Region *X = elems[idx].region) {
+                int succ = elemOf(X->getExit());
+                segChoices.push_back({succ, -1});
+              } else {
+                const PathBlock &pb = blockTable[ids.bbId(elems[idx].bb)];
+                elems[idx].leaf = pb.leaf;
+                for (unsigned c = pb.firstChoice;
+                     c < pb.firstChoice + pb.numChoices; ++c) {
+                  int succ = elemOf(blockTable[choiceTable[c].succ].bb);
+                  segChoices.push_back({succ, choiceTable[c].decision});
+                }
               }
-              *cfg << "],\"decisions\":[";
-              for (size_t i = 0; i < decisions.size(); ++i) {
+              elems[idx].numChoices = segChoices.size() - elems[idx].firstChoice;
+            }
+
+            std::vector<unsigned> segPath;
+            elemVisits.assign(elems.size(), 0);
+            unsigned regionEmitted = 0;
+
+            auto emitSegment = [&](bool reachesExit) {
+              dfsLeaves++;
+              if (CondTable) emitPendingConds();
+              else for (unsigned di : decisions) renderCond(di);
+              JsonRecord rec(*cfg, "segment", ids);
+              rec.field("region_id") << r;
+              rec.field("segment_id") << segmentIdCounter++;
+              rec.field("elems") << "[";
+              for (size_t i = 0; i < segPath.size(); ++i) {
                 if (i) *cfg << ",";
-                emitDecision(*cfg, decisions[i]);
+                const SegElem &e = elems[segPath[i]];
+                if (e.region) {
+                  *cfg << "{\"region\":" << regionIds.lookup(e.region) << "}";
+                } else {
+                  *cfg << "{\"bb\":";
+                  ids.emitBB(*cfg, e.bb);
+                  *cfg << "}";
+                }
               }
               *cfg << "]";
-              if (IncludePpSeq) {
-                *cfg << ",\"pp_seq\":[";
-                for (size_t i = 0; i < ppSeq.size(); ++i) {
+              if (CondTable) {
+                emitCondRefs(*cfg, decisions);
+              } else {
+                rec.field("decisions") << "[";
+                for (size_t i = 0; i < decisions.size(); ++i) {
                   if (i) *cfg << ",";
-                  emitJsonString(*cfg, ppSeq[i]);
+                  emitDecision(*cfg, decisionTable[decisions[i]], ids);
                 }
                 *cfg << "]";
               }
-              if (emitCondStr) {
-                *cfg << ",\"path_cond\":[";
-                for (size_t i = 0; i < conds.size(); ++i) {
+              if (emitCondStr && !CondTable) {
+                rec.field("path_cond") << "[";
+                for (size_t i = 0; i < decisions.size(); ++i) {
                   if (i) *cfg << ",";
-                  emitJsonString(*cfg, conds[i]);
+                  emitJsonString(*cfg, condTexts[decisions[i]]);
                 }
                 *cfg << "]";
               }
-              if (emitCondJson) {
-                *cfg << ",\"path_cond_json\":[";
-                for (size_t i = 0; i < condExprs.size(); ++i) {
+              if (emitCondJson && !CondTable) {
+                rec.field("path_cond_json") << "[";
+                for (size_t i = 0; i < decisions.size(); ++i) {
                   if (i) *cfg << ",";
-                  emitCondExpr(*cfg, condExprs[i]);
+                  emitCondExpr(*cfg, condExprs[decisions[i]]);
                 }
                 *cfg << "]";
               }
-              *cfg << "}\n";
-              emitted++;
-            } else {
-              if (auto *BI = dyn_cast<BranchInst>(T)) {
-                if (BI->isConditional()) {
-                  std::string condId =
-                    getValueId(BI->getCondition(), valueIds, nextValueId);
-                  if (auto *CI = dyn_cast<ConstantInt>(BI->getCondition())) {
-                    unsigned i = CI->isZero() ? 1 : 0;
-                    constPrunedBr++;
-                    Decision d;
-                    d.pp = termPP[BB];
-                    d.kind = "br";
-                    d.cond = condId;
-                    d.succ = bbLabels[BI->getSuccessor(i)];
-                    d.sense = (i == 0) ? "true" : "false";
-                    std::string condText =
-                      condId + "==" +
-                      std::string((i == 0) ? "const:i1:1" : "const:i1:0");
-                    CondExpr condJson = makeCmp(
-                      "==", condId,
-                      (i == 0) ? "const:i1:1" : "const:i1:0");
-                    decisions.push_back(d);
-                    conds.push_back(condText);
-                    condExprs.push_back(condJson);
-                    dfs(BI->getSuccessor(i));
-                    decisions.pop_back();
-                    conds.pop_back();
-                    condExprs.pop_back();
-                  } else {
-                    for (unsigned i = 0; i < BI->getNumSuccessors(); ++i) {
-                      Decision d;
-                      d.pp = termPP[BB];
-                      d.kind = "br";
-                      d.cond = condId;
-                      d.succ = bbLabels[BI->getSuccessor(i)];
-                      d.sense = (i == 0) ? "true" : "false";
-                      std::string condText =
-                        condId + "==" +
-                        std::string((i == 0) ? "const:i1:1" : "const:i1:0");
-                      CondExpr condJson = makeCmp(
-                        "==", condId,
-                        (i == 0) ? "const:i1:1" : "const:i1:0");
-                      decisions.push_back(d);
-                      conds.push_back(condText);
-                      condExprs.push_back(condJson);
-                      dfs(BI->getSuccessor(i));
-                      decisions.pop_back();
-                      conds.pop_back();
-                      condExprs.pop_back();
-                    }
-                  }
-                } else {
-                  dfs(BI->getSuccessor(0));
-                }
-              } else if (auto *SI = dyn_cast<SwitchInst>(T)) {
-                std::string condId =
-                  getValueId(SI->getCondition(), valueIds, nextValueId);
-                if (auto *CI = dyn_cast<ConstantInt>(SI->getCondition())) {
-                  constPrunedSwitch++;
-                  const BasicBlock *Dest = nullptr;
-                  const ConstantInt *CaseVal = nullptr;
-                  for (auto &Case : SI->cases()) {
-                    if (Case.getCaseValue()->getValue() == CI->getValue()) {
-                      Dest = Case.getCaseSuccessor();
-                      CaseVal = Case.getCaseValue();
-                      break;
-                    }
-                  }
-                  if (Dest) {
-                    Decision d;
-                    d.pp = termPP[BB];
-                    d.kind = "switch";
-                    d.cond = condId;
-                    d.succ = bbLabels[Dest];
-                    d.caseValue =
-                      getValueId(CaseVal, valueIds, nextValueId);
-                    std::string condText = condId + "==" + d.caseValue;
-                    CondExpr condJson = makeCmp("==", condId, d.caseValue);
-                    decisions.push_back(d);
-                    conds.push_back(condText);
-                    condExprs.push_back(condJson);
-                    dfs(Dest);
-                    decisions.pop_back();
-                    conds.pop_back();
-                    condExprs.pop_back();
-                  } else if (const BasicBlock *Def = SI->getDefaultDest()) {
-                    Decision d;
-                    d.pp = termPP[BB];
-                    d.kind = "switch";
-                    d.cond = condId;
-                    d.succ = bbLabels[Def];
-                    d.isDefault = true;
-                    std::string condText =
-                      buildSwitchDefaultCond(*SI, condId, valueIds, nextValueId);
-                    std::vector<CondExpr> terms;
-                    for (auto &Case : SI->cases()) {
-                      std::string caseVal =
-                        getValueId(Case.getCaseValue(), valueIds, nextValueId);
-                      terms.push_back(makeCmp("!=", condId, caseVal));
-                    }
-                    CondExpr condJson;
-                    if (terms.empty()) {
-                      condJson = makeCmp("!=", condId, "<any>");
-                    } else if (terms.size() == 1) {
-                      condJson = terms[0];
-                    } else {
-                      condJson = makeAnd(std::move(terms));
-                    }
-                    decisions.push_back(d);
-                    conds.push_back(condText);
-                    condExprs.push_back(condJson);
-                    dfs(Def);
-                    decisions.pop_back();
-                    conds.pop_back();
-                    condExprs.pop_back();
-                  }
-                } else {
-                  for (auto &Case : SI->cases()) {
-                    Decision d;
-                    d.pp = termPP[BB];
-                    d.kind = "switch";
-                    d.cond = condId;
-                    d.succ = bbLabels[Case.getCaseSuccessor()];
-                    d.caseValue =
-                      getValueId(Case.getCaseValue(), valueIds, nextValueId);
-                    std::string condText = condId + "==" + d.caseValue;
-                    CondExpr condJson = makeCmp("==", condId, d.caseValue);
-                    decisions.push_back(d);
-                    conds.push_back(condText);
-                    condExprs.push_back(condJson);
-                    dfs(Case.getCaseSuccessor());
-                    decisions.pop_back();
-                    conds.pop_back();
-                    condExprs.pop_back();
-                  }
-                  if (const BasicBlock *Def = SI->getDefaultDest()) {
-                    Decision d;
-                    d.pp = termPP[BB];
-                    d.kind = "switch";
-                    d.cond = condId;
-                    d.succ = bbLabels[Def];
-                    d.isDefault = true;
-                    std::string condText =
-                      buildSwitchDefaultCond(*SI, condId, valueIds, nextValueId);
-                    std::vector<CondExpr> terms;
-                    for (auto &Case : SI->cases()) {
-                      std::string caseVal =
-                        getValueId(Case.getCaseValue(), valueIds, nextValueId);
-                      terms.push_back(makeCmp("!=", condId, caseVal));
-                    }
-                    CondExpr condJson;
-                    if (terms.empty()) {
-                      condJson = makeCmp("!=", condId, "<any>");
-                    } else if (terms.size() == 1) {
-                      condJson = terms[0];
-                    } else {
-                      condJson = makeAnd(std::move(terms));
-                    }
-                    decisions.push_back(d);
-                    conds.push_back(condText);
-                    condExprs.push_back(condJson);
-                    dfs(Def);
-                    decisions.pop_back();
-                    conds.pop_back();
-                    condExprs.pop_back();
-                  }
-                }
-              } else if (auto *IB = dyn_cast<IndirectBrInst>(T)) {
-                std::string targetId =
-                  getValueId(IB->getAddress(), valueIds, nextValueId);
-                if (auto *BA = dyn_cast<BlockAddress>(IB->getAddress())) {
-                  constPrunedIndirect++;
-                  const BasicBlock *Dest = BA->getBasicBlock();
-                  Decision d;
-                  d.pp = termPP[BB];
-                  d.kind = "indirect";
-                  d.target = targetId;
-                  d.succ = bbLabels[Dest];
-                  std::string condText =
-                    targetId + "==label:" + d.succ;
-                  CondExpr condJson =
-                    makeCmp("==", targetId, "label:" + d.succ);
-                  decisions.push_back(d);
-                  conds.push_back(condText);
-                  condExprs.push_back(condJson);
-                  dfs(Dest);
+              rec.field("reaches_exit") << (reachesExit ? "true" : "false");
+              regionEmitted++;
+              segmentsEmitted++;
+            };
+
+            auto segEnter = [&](int elem, int decision) {
+              dfsCalls++;
+              if (budget.exhausted()) return;
+              if (regionEmitted >= MaxPaths) {
+                truncated = true;
+                dfsPruneMaxPaths++;
+                return;
+              }
+              if (elem >= 0 && segPath.size() >= MaxPathDepth) {
+                cutoffDepth = true;
+                dfsPruneMaxDepth++;
+                return;
+              }
+              if (elem >= 0 && elemVisits[elem] >= MaxLoopIters + 1) {
+                cutoffLoop = true;
+                dfsPruneLoop++;
+                return;
+              }
+              if (decision >= 0) {
+                decisions.push_back(decision);
+                decisionFrom.push_back(segPath.size() - 1);
+              }
+              if (elem < 0) {
+                emitSegment(true);
+                if (decision >= 0) {
                   decisions.pop_back();
-                  conds.pop_back();
-                  condExprs.pop_back();
-                } else {
-                  for (unsigned i = 0; i < IB->getNumSuccessors(); ++i) {
-                    Decision d;
-                    d.pp = termPP[BB];
-                    d.kind = "indirect";
-                    d.target = targetId;
-                    d.succ = bbLabels[IB->getSuccessor(i)];
-                    std::string condText =
-                      targetId + "==label:" + d.succ;
-                    CondExpr condJson =
-                      makeCmp("==", targetId, "label:" + d.succ);
-                    decisions.push_back(d);
-                    conds.push_back(condText);
-                    condExprs.push_back(condJson);
-                    dfs(IB->getSuccessor(i));
-                    decisions.pop_back();
-                    conds.pop_back();
-                    condExprs.pop_back();
-                  }
+                  decisionFrom.pop_back();
                 }
-              } else {
-                for (unsigned i = 0; i < succCount; ++i) {
-                  dfs(T->getSuccessor(i));
+                return;
+              }
+              bool revisit = elemVisits[elem] > 0;
+              elemVisits[elem]++;
+              if (revisit) revisitDepths.push_back(segPath.size());
+              segPath.push_back(elem);
+              const SegElem &e = elems[elem];
+              segStack.push_back({static_cast<unsigned>(elem), e.firstChoice,
+                                  e.firstChoice + e.numChoices, decision >= 0,
+                                  revisit});
+              if (e.bb && e.leaf) {
+                emitSegment(false);
+              } else if (e.bb) {
+                if (unsigned *cp = blockTable[ids.bbId(e.bb)].constPruned) ++*cp;
+              }
+            };
+
+            segEnter(0, -1);
+            while (!segStack.empty()) {
+              SegFrame &top = segStack.back();
+              if (top.nextChoice < top.endChoice) {
+                const SegChoice &c = segChoices[top.nextChoice++];
+                // Segments do not track the edge into a block, so only
+                // verdicts that hold for any way in apply.
+                int decision = rangeDecision(c.decision, nullptr);
+                if (decision == RangePrunedDecision) continue;
+                if (PruneCorrelated && decision >= 0 &&
+                    contradictsPath(decision)) {
+                  if (isa<SwitchInst>(decisionTable[decision].term)) {
+                    corrPrunedSwitch++;
+                  } else {
+                    corrPrunedBr++;
+                  }
+                  continue;
                 }
+                segEnter(c.elem, decision);
+                continue;
               }
+              elemVisits[top.elem]--;
+              if (top.hasDecision) {
+                decisions.pop_back();
+                decisionFrom.pop_back();
+              }
+              if (top.revisit) revisitDepths.pop_back();
+              segPath.pop_back();
+              segStack.pop_back();
             }
-
-            path.pop_back();
-            visitCount[BB] = count;
-          };
-
-        dfs(&F.getEntryBlock());
-        if (EmitPpCoverage) {
-          for (auto &entry : ppToPaths) {
-            StringRef pp = entry.getKey();
-            SmallVector<unsigned, 8> &ids = entry.getValue();
-            *cfg << "{";
-            *cfg << "\"kind\":\"pp_coverage\",\"fn\":";
-            emitJsonString(*cfg, F.getName());
-            *cfg << ",\"pp\":";
-            emitJsonString(*cfg, pp);
-            *cfg << ",\"path_count\":" << ids.size();
-            *cfg << ",\"path_ids\":[";
-            unsigned limit = MaxPpPathIds;
-            for (unsigned i = 0; i < ids.size() && i < limit; ++i) {
+          }
+        }
+        pathsTimer.stop();
+        PhaseTimer coverageTimer("PublicDataPass.pp-coverage", F.getName(),
+                                 times.ppCoverage);
+        if (EmitPpCoverage && blockCoverage) {
+          for (unsigned bb = 0; bb < blockPaths.size(); ++bb) {
+            const PathIdRanges &ranges = blockPaths[bb];
+            if (ranges.empty()) continue;
+            JsonRecord rec(*cfg, "block_coverage", ids);
+            ids.emitBB(rec.field("bb"), blockTable[bb].bb);
+            rec.field("pps") << blockTable[bb].bb->size();
+            rec.field("path_count") << pathIdCount(ranges);
+            rec.field("path_ranges") << "[";
+            for (size_t i = 0; i < ranges.size(); ++i) {
               if (i) *cfg << ",";
-              *cfg << ids[i];
+              *cfg << "[" << ranges[i].first << "," << ranges[i].second << "]";
+            }
+            *cfg << "]";
+          }
+        } else if (EmitPpCoverage) {
+          auto emitCoverage = [&](function_ref<void()> emitPpKey,
+                                  const PathIdRanges &ranges) {
+            JsonRecord rec(*cfg, "pp_coverage", ids);
+            rec.field("pp");
+            emitPpKey();
+            uint64_t count = pathIdCount(ranges);
+            rec.field("path_count") << count;
+            rec.field("path_ids") << "[";
+            unsigned limit = MaxPpPathIds;
+            unsigned listed = 0;
+            for (const auto &r : ranges) {
+              for (unsigned id = r.first; listed < limit; ++id) {
+                if (listed++) *cfg << ",";
+                *cfg << id;
+                if (id == r.second) break;
+              }
             }
             *cfg << "]";
-            if (ids.size() > limit) {
-              *cfg << ",\"truncated\":true";
+            if (count > limit) {
+              rec.field("truncated") << "true";
+            }
+          };
+          if (ids.interned()) {
+            for (unsigned bb = 0; bb < blockPaths.size(); ++bb) {
+              if (blockPaths[bb].empty()) continue;
+              unsigned first = ids.bbFirstPpId(bb);
+              for (unsigned k = 0; k < blockTable[bb].bb->size(); ++k) {
+                emitCoverage([&]() { *cfg << first + k; }, blockPaths[bb]);
+              }
+            }
+          } else {
+            // Insert labels in first-coverage order, so records come out in
+            // the same (hash) order as a pp-keyed table filled per leaf.
+            StringMap<unsigned> ppBlocks;
+            for (unsigned bb : coveredOrder) {
+              for (const Instruction &I : *blockTable[bb].bb) {
+                ppBlocks[ids.ppLabel(&I)] = bb;
+              }
             }
-            *cfg << "}\n";
+            for (auto &entry : ppBlocks) {
+              emitCoverage([&]() { emitJsonString(*cfg, entry.getKey()); },
+                           blockPaths[entry.getValue()]);
+            }
+          }
+        }
+        coverageTimer.stop();
+        for (const PathIdRanges &ranges : blockPaths) {
+          if (ranges.empty()) continue;
+          coverageBlocks++;
+          coverageRanges += ranges.size();
+        }
+        if (pathRecords) *pathRecords = emitted + segmentsEmitted;
+        JsonRecord rec(*cfg, "path_summary", ids);
+        rec.field("paths_emitted") << emitted;
+        rec.field("truncated") << (truncated ? "true" : "false");
+        rec.field("max_paths") << MaxPaths;
+        rec.field("max_depth") << MaxPathDepth;
+        rec.field("max_loop_iters") << MaxLoopIters;
+        rec.field("cutoff_depth") << (cutoffDepth ? "true" : "false");
+        rec.field("cutoff_loop") << (cutoffLoop ? "true" : "false");
+        if (budget.cutoffTime) rec.field("cutoff_time") << "true";
+        if (budget.cutoffMem) rec.field("cutoff_mem") << "true";
+        rec.field("const_pruned_br") << constPrunedBr;
+        rec.field("const_pruned_switch") << constPrunedSwitch;
+        rec.field("const_pruned_indirect") << constPrunedIndirect;
+        rec.field("corr_pruned_br") << corrPrunedBr;
+        rec.field("corr_pruned_switch") << corrPrunedSwitch;
+        rec.field("range_pruned") << rangePruned;
+        rec.field("range_implied") << rangeImplied;
+        rec.field("range_restored") << rangeRestored;
+        if (!regionMode) {
+          unsigned uncovered = 0;
+          for (size_t bb = 0; bb < rangeCutBlocks.size(); ++bb) {
+            if (rangeCutBlocks[bb] && !pathCovered[bb]) uncovered++;
           }
+          rec.field("range_uncovered") << uncovered;
+        }
+        rec.field("dfs_calls") << dfsCalls;
+        rec.field("dfs_leaves") << dfsLeaves;
+        rec.field("dfs_prune_max_paths") << dfsPruneMaxPaths;
+        rec.field("dfs_prune_max_depth") << dfsPruneMaxDepth;
+        rec.field("dfs_prune_loop") << dfsPruneLoop;
+        rec.field("path_count_exact");
+        if (pathCountKnown) emitPathCount(*cfg, pathCount);
+        else *cfg << "null";
+        if (pathCountKnown && pathCount == ~PathCount(0)) {
+          rec.field("path_count_saturated") << "true";
+        }
+        // The count does not see correlation pruning, so once that cut a
+        // path it is only an upper bound.
+        if (pathCountKnown && corrPrunedBr + corrPrunedSwitch > 0) {
+          rec.field("path_count_bound") << "true";
+        }
+        if (regionMode) {
+          rec.field("path_mode") << "\"region\"";
+          rec.field("regions") << regionCount;
+          rec.field("segments_emitted") << segmentsEmitted;
+        }
+        if (dedup) {
+          rec.field("path_classes") << pathClasses.size();
+        }
+        if (guidedOrder) {
+          emitJsonString(rec.field("path_order"), order);
+          rec.field("paths_guided") << pathsGuided;
+        }
+        if (trieEncoding) {
+          rec.field("path_encoding") << "\"trie\"";
+          rec.field("path_nodes_emitted") << nodeIdCounter;
         }
-        *cfg << "{";
-        *cfg << "\"kind\":\"path_summary\",\"fn\":";
-        emitJsonString(*cfg, F.getName());
-        *cfg << ",\"paths_emitted\":" << emitted;
-        *cfg << ",\"truncated\":" << (truncated ? "true" : "false");
-        *cfg << ",\"max_paths\":" << MaxPaths;
-        *cfg << ",\"max_depth\":" << MaxPathDepth;
-        *cfg << ",\"max_loop_iters\":" << MaxLoopIters;
-        *cfg << ",\"cutoff_depth\":" << (cutoffDepth ? "true" : "false");
-        *cfg << ",\"cutoff_loop\":" << (cutoffLoop ? "true" : "false");
-        *cfg << ",\"const_pruned_br\":" << constPrunedBr;
-        *cfg << ",\"const_pruned_switch\":" << constPrunedSwitch;
-        *cfg << ",\"const_pruned_indirect\":" << constPrunedIndirect;
-        *cfg << ",\"dfs_calls\":" << dfsCalls;
-        *cfg << ",\"dfs_leaves\":" << dfsLeaves;
-        *cfg << ",\"dfs_prune_max_paths\":" << dfsPruneMaxPaths;
-        *cfg << ",\"dfs_prune_max_depth\":" << dfsPruneMaxDepth;
-        *cfg << ",\"dfs_prune_loop\":" << dfsPruneLoop;
-        *cfg << "}\n";
       } else {
-        *cfg << "{";
-        *cfg << "\"kind\":\"path_summary\",\"fn\":";
-        emitJsonString(*cfg, F.getName());
-        *cfg << ",\"paths_emitted\":0";
-        *cfg << ",\"disabled\":true";
-        *cfg << ",\"max_paths\":" << MaxPaths;
-        *cfg << ",\"max_depth\":" << MaxPathDepth;
-        *cfg << ",\"max_loop_iters\":" << MaxLoopIters;
-        *cfg << "}\n";
+        JsonRecord rec(*cfg, "path_summary", ids);
+        rec.field("paths_emitted") << "0";
+        rec.field("disabled") << "true";
+        rec.field("max_paths") << MaxPaths;
+        rec.field("max_depth") << MaxPathDepth;
+        rec.field("max_loop_iters") << MaxLoopIters;
+      }
+
+      if (EmitPerf) {
+        totalTimer.stop();
+        // Bytes count this function's records before the perf record.
+        uint64_t cfgBytes = cfg->tell() - cfgBase;
+        JsonRecord rec(*cfg, "perf", ids);
+        rec.field("total_ns") << times.analyses + times.total;
+        rec.field("phase_ns") << "{";
+        *cfg << "\"analyses\":" << times.analyses;
+        *cfg << ",\"ids\":" << times.ids;
+        *cfg << ",\"trace\":" << times.trace;
+        *cfg << ",\"cfg\":" << times.cfg;
+        *cfg << ",\"path_tables\":" << times.pathTables;
+        *cfg << ",\"path_count\":" << times.pathCount;
+        *cfg << ",\"paths\":" << times.paths;
+        *cfg << ",\"pp_coverage\":" << times.ppCoverage;
+        *cfg << "}";
+        rec.field("bytes") << "{\"trace\":";
+        if (trace) *cfg << traceBytes;
+        else *cfg << "null";
+        *cfg << ",\"trace_index\":";
+        if (traceIndex) *cfg << traceIndex->tell() - traceIndexBase;
+        else *cfg << "null";
+        *cfg << ",\"cfg\":" << cfgBytes;
+        *cfg << "}";
+        rec.field("coverage_peak") << "{\"blocks\":" << coverageBlocks;
+        *cfg << ",\"ranges\":" << coverageRanges << "}";
+        rec.field("value_ids_peak") << ids.valueIdCount();
+        if (ids.interned()) {
+          rec.field("symtab_values") << ids.symtabValueCount();
+        }
+      }
+    }
+    return !budget.cutoffTime;
+  }
+};
+
+// Module driver: renders every function on a thread pool into private
+// buffers, then commits them to the shared streams in module order, so the
+// output matches a sequential -passes='function(public-data)' run.
+struct PublicDataModulePass : PassInfoMixin<PublicDataModulePass> {
+  static bool isRequired() { return true; }
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) {
+    TimeTraceScope scope("PublicDataModulePass", M.getName());
+    FunctionAnalysisManager &FAM =
+      MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    // Open the outputs here; workers only ask which streams are enabled.
+    getTraceFile();
+    getTraceIndexStream();
+    getCfgStream();
+    getTraceIndexBinWriter();
+    warnIgnoredPathOptions();
+
+    std::vector<Function *> fns;
+    for (Function &F : M) {
+      if (!F.isDeclaration()) fns.push_back(&F);
+    }
+    // Callee summaries make a function's records depend on other
+    // functions, which the cache key does not cover.
+    bool caching = cacheEnabled() && !CalleeSummaries;
+    if (cacheEnabled() && CalleeSummaries && !Quiet) {
+      errs() << "-public-data-cache-dir/-cache-manifest are ignored with "
+                "-public-data-callee-summaries\n";
+    } else if (!CacheDir.empty() && EmitPerf && !Quiet) {
+      errs() << "-public-data-cache-dir is not read or written with "
+                "-public-data-perf\n";
+    }
+    // Keys are hashed and hits loaded up front; only misses get analyses
+    // and a render job.
+    std::vector<FunctionOutput> outs(fns.size());
+    std::vector<std::string> keys(fns.size());
+    std::vector<bool> hits(fns.size(), false);
+    if (caching) {
+      TimeTraceScope cacheScope("PublicDataPass.cache-lookup");
+      for (size_t i = 0; i < fns.size(); ++i) {
+        keys[i] = functionCacheKey(*fns[i]);
+        hits[i] = loadCachedFunction(fns[i]->getName(), keys[i], outs[i]);
+      }
+    }
+    // Analyses are computed here; workers only read them.
+    std::vector<std::unique_ptr<FunctionAnalyses>> analyses(fns.size());
+    for (size_t i = 0; i < fns.size(); ++i) {
+      if (!hits[i]) analyses[i] = computeAnalyses(*fns[i], FAM);
+    }
+    CalleeSummaryMap summaries;
+    if (CalleeSummaries) {
+      TimeTraceScope summaryScope("PublicDataPass.callee-summaries");
+      summaries = summarizeCallGraph(MAM.getResult<CallGraphAnalysis>(M), FAM);
+      for (size_t i = 0; i < fns.size(); ++i) {
+        auto it = summaries.find(fns[i]);
+        if (it != summaries.end()) analyses[i]->summary = &it->second;
       }
     }
 
+    // Workers also store their misses, so cache writes run in parallel.
+    std::vector<std::shared_future<void>> done(fns.size());
+    ThreadPool pool(hardware_concurrency(Threads));
+    for (size_t i = 0; i < fns.size(); ++i) {
+      if (hits[i]) continue;
+      done[i] = pool.async([&, i]() {
+        bool complete = PublicDataPass::renderFunction(*fns[i], *analyses[i],
+                                                       outs[i]);
+        if (caching && complete) storeCachedFunction(keys[i], outs[i]);
+      });
+    }
+    // Commit in order as each function finishes; trace_index lines and
+    // binary index spans are function-relative, so concatenation keeps them
+    // valid once spans are rebased on the commit offset.
+    TimeTraceScope commitScope("PublicDataPass.commit");
+    for (size_t i = 0; i < fns.size(); ++i) {
+      if (done[i].valid()) done[i].wait();
+      commitFunctionOutput(*fns[i], outs[i]);
+      if (caching) emitCacheManifestEntry(fns[i]->getName(), keys[i], hits[i]);
+      outs[i] = FunctionOutput();
+    }
     return PreservedAnalyses::all();
   }
 };
 
 } // namespace
 
+void setPublicDataOutputStem(StringRef stem) {
+  OutputStem = stem.str();
+}
+
+std::string publicDataOutputPath(StringRef path) {
+  return outputPath(path);
+}
+
+bool publicDataOutputsPerInput() {
+  for (StringRef path : {StringRef(TraceOut), StringRef(TraceIndexOut),
+                         StringRef(TraceIndexBinOut), StringRef(CfgOut),
+                         StringRef(CacheManifestOut), StringRef(ShardDir)}) {
+    if (!path.empty() && !path.contains("{}")) return false;
+  }
+  return true;
+}
+
+void closePublicDataOutputs() {
+  // The binary index is written on destruction and only refers to the
+  // trace by path, so its order relative to the trace does not matter.
+  TraceIndexBin.reset();
+  Shards.reset();
+  TraceFile.reset();
+  TraceIndexFile.reset();
+  CfgFile.reset();
+  CacheManifestFile.reset();
+}
+
+bool renderPublicDataFunction(Function &F, FunctionAnalysisManager &FAM,
+                              const PublicDataLimits &limits,
+                              std::string *trace, std::string *cfg) {
+  // The limits are read as options throughout emitFunction, so they are
+  // swapped in for this call only, as is the NDJSON trace format.
+  std::string savedFormat = TraceFormat;
+  TraceFormat.setValue("ndjson");
+  unsigned savedPaths = MaxPaths;
+  unsigned savedDepth = MaxPathDepth;
+  unsigned savedIters = MaxLoopIters;
+  if (limits.maxPaths >= 0) MaxPaths.setValue(unsigned(limits.maxPaths));
+  if (limits.maxPathDepth >= 0) {
+    MaxPathDepth.setValue(unsigned(limits.maxPathDepth));
+  }
+  if (limits.maxLoopIters >= 0) {
+    MaxLoopIters.setValue(unsigned(limits.maxLoopIters));
+  }
+  std::string traceText, cfgText;
+  raw_string_ostream traceOS(traceText);
+  raw_string_ostream cfgOS(cfgText);
+  bool complete = PublicDataPass::emitFunction(
+    F, *computeAnalyses(F, FAM), trace ? &traceOS : nullptr, nullptr,
+    cfg ? &cfgOS : nullptr, errs());
+  MaxPaths.setValue(savedPaths);
+  MaxPathDepth.setValue(savedDepth);
+  MaxLoopIters.setValue(savedIters);
+  TraceFormat.setValue(savedFormat);
+  if (trace) *trace = std::move(traceOS.str());
+  if (cfg) *cfg = std::move(cfgOS.str());
+  return complete;
+}
+
+void emitPublicDataRunSummary(raw_ostream &os, StringRef source,
+                              ArrayRef<uint64_t> elapsedMs, int64_t maxRssKb) {
+  std::vector<uint64_t> sorted(elapsedMs.begin(), elapsedMs.end());
+  std::sort(sorted.begin(), sorted.end());
+  uint64_t sum = 0;
+  for (uint64_t ms : sorted) sum += ms;
+  size_t runs = sorted.size();
+  uint64_t mean = runs ? sum / runs : 0;
+  uint64_t median = 0;
+  if (runs) {
+    median = runs % 2 ? sorted[runs / 2]
+                      : (sorted[runs / 2 - 1] + sorted[runs / 2]) / 2;
+  }
+  os << "{";
+  os << "\"kind\":\"run_summary\",\"source\":";
+  emitJsonString(os, source);
+  os << ",\"elapsed_ms\":" << mean;
+  os << ",\"elapsed_ms_min\":" << (runs ? sorted.front() : 0);
+  os << ",\"elapsed_ms_max\":" << (runs ? sorted.back() : 0);
+  os << ",\"elapsed_ms_median\":" << median;
+  os << ",\"elapsed_ms_mean\":" << mean;
+  os << ",\"elapsed_runs\":" << runs;
+  os << ",\"max_paths\":" << MaxPaths;
+  os << ",\"max_path_depth\":" << MaxPathDepth;
+  os << ",\"max_loop_iters\":" << MaxLoopIters;
+  os << ",\"max_inst\":" << MaxInst;
+  if (maxRssKb >= 0) os << ",\"max_rss_kb\":" << maxRssKb;
+  os << "}\n";
+}
+
 // Pass registration for `opt -load-pass-plugin ... -passes=public-data`
+// (per function) or `-passes=public-data-module` (threaded module driver).
 extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
   return {
     LLVM_PLUGIN_API_VERSION, "PublicDataPass", LLVM_VERSION_STRING,
@@ -1274,6 +5146,16 @@ extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
           return false;
         }
       );
+      PB.registerPipelineParsingCallback(
+        [](StringRef Name, ModulePassManager &MPM,
+           ArrayRef<PassBuilder::PipelineElement>) {
+          if (Name == "public-data-module") {
+            MPM.addPass(PublicDataModulePass());
+            return true;
+          }
+          return false;
+        }
+      );
     }
   };
 }
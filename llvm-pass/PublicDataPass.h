@@ -0,0 +1,57 @@
+#ifndef PUBLIC_DATA_PASS_H
+#define PUBLIC_DATA_PASS_H
+
+// Hooks for drivers that link PublicDataPass.cpp directly instead of loading
+// it with opt -load-pass-plugin (ct-trace). The passes themselves register
+// through llvmGetPassPluginInfo() and read the same -public-data-* options.
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdint>
+#include <string>
+
+// Substitute stem for "{}" in the output path options when the outputs for
+// the next module are opened. The empty stem uses the paths verbatim.
+void setPublicDataOutputStem(llvm::StringRef stem);
+
+// Expand "{}" in path with the current output stem.
+std::string publicDataOutputPath(llvm::StringRef path);
+
+// Whether every enabled output path option contains "{}", so each input
+// gets its own files.
+bool publicDataOutputsPerInput();
+
+// Flush and close every output file, writing the binary trace index, so the
+// next module opens fresh ones.
+void closePublicDataOutputs();
+
+// Path limits for one renderPublicDataFunction call; a negative field keeps
+// the -public-data-* option's value.
+struct PublicDataLimits {
+  int64_t maxPaths = -1;
+  int64_t maxPathDepth = -1;
+  int64_t maxLoopIters = -1;
+};
+
+// Render F's trace (always NDJSON) and CFG records, as the function pass
+// writes them, into whichever of trace and cfg is set, under limits.
+// Nothing is written to the output files (the driver owns the records) and
+// LLVM analyses come from FAM, so a driver that keeps FAM alive re-renders
+// without recomputing them. Not thread-safe: the limits are swapped into
+// the options. Returns false when -public-data-fn-time-budget-ms cut the
+// function short.
+bool renderPublicDataFunction(llvm::Function &F,
+                              llvm::FunctionAnalysisManager &FAM,
+                              const PublicDataLimits &limits,
+                              std::string *trace, std::string *cfg);
+
+// Write a run_summary record (see gen_traces.sh) for one input's timed runs,
+// with the process's peak RSS when maxRssKb is not negative.
+void emitPublicDataRunSummary(llvm::raw_ostream &os, llvm::StringRef source,
+                              llvm::ArrayRef<uint64_t> elapsedMs,
+                              int64_t maxRssKb = -1);
+
+#endif // PUBLIC_DATA_PASS_H
@@ -0,0 +1,411 @@
+// Microbenchmarks for the pass's emission hot paths (google-benchmark).
+// The pass TU is included directly so its internal helpers can be timed on
+// their own: JSON escaping, value ids, program point labels, condition
+// rendering, and whole emission phases against null streams.
+//
+//   PublicDataPassBench [--benchmark_*] [-public-data-*] [-csv=out.csv]
+//                       [inputs.ll ...]
+//
+// Without inputs it loads the IR built next to the binary (see
+// CMakeLists.txt). Every -public-data-* option applies to the phases.
+
+#include "PublicDataPass.cpp"
+
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SourceMgr.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <map>
+#include <new>
+
+// Allocation counter behind allocs/path. Only operator new is counted, so
+// LLVM's direct malloc users (SmallVector growth, BumpPtrAllocator slabs)
+// are not.
+static std::atomic<uint64_t> AllocCount{0};
+
+void *operator new(size_t n) {
+  AllocCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t n) { return ::operator new(n); }
+// Not inlined: GCC's -Wmismatched-new-delete flags std::free inlined at
+// sites whose pointer came from operator new.
+LLVM_ATTRIBUTE_NOINLINE void operator delete(void *p) noexcept {
+  std::free(p);
+}
+LLVM_ATTRIBUTE_NOINLINE void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+LLVM_ATTRIBUTE_NOINLINE void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+LLVM_ATTRIBUTE_NOINLINE void operator delete[](void *p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+static cl::list<std::string> BenchInputs(
+  cl::Positional,
+  cl::desc("<input .ll/.bc files>"),
+  cl::ZeroOrMore
+);
+static cl::opt<std::string> BenchCsv(
+  "csv",
+  cl::desc("Also write results as CSV to this path"),
+  cl::init("")
+);
+
+// One loaded input with the analyses emitFunction reads.
+struct BenchModule {
+  std::string source;
+  std::unique_ptr<LLVMContext> ctx;
+  std::unique_ptr<Module> module;
+  std::vector<Function *> fns;
+  std::vector<std::unique_ptr<FunctionAnalyses>> analyses;
+  unsigned instCount = 0;
+  unsigned pathCount = 0;  // path/segment records per paths-phase run
+};
+
+// Analysis managers outlive every benchmark since FunctionAnalyses points
+// into their results.
+struct BenchAnalysisManagers {
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PassBuilder PB;
+
+  BenchAnalysisManagers() {
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+  }
+};
+
+enum class Phase { Trace, Cfg, Paths };
+
+// Render every function of M once for phase into the given streams.
+static void runPhase(BenchModule &M, Phase phase, raw_ostream &out,
+                     raw_ostream &log) {
+  for (size_t i = 0; i < M.fns.size(); ++i) {
+    bool trace = phase == Phase::Trace;
+    PublicDataPass::emitFunction(*M.fns[i], *M.analyses[i],
+                                 trace ? &out : nullptr,
+                                 trace ? &out : nullptr,
+                                 trace ? nullptr : &out, log);
+  }
+}
+
+// Count path and segment records in one paths-phase run.
+static unsigned countPaths(BenchModule &M) {
+  std::string cfg;
+  raw_string_ostream os(cfg);
+  raw_null_ostream log;
+  runPhase(M, Phase::Paths, os, log);
+  os.flush();
+  SmallVector<StringRef, 64> lines;
+  StringRef(cfg).split(lines, '\n', -1, false);
+  unsigned n = 0;
+  for (StringRef line : lines) {
+    if (line.startswith("{\"kind\":\"path\",") ||
+        line.startswith("{\"kind\":\"segment\",")) {
+      n++;
+    }
+  }
+  return n;
+}
+
+// Per-item time as a counter: the inverted iteration-invariant rate is
+// seconds per item (CsvReporter writes it as nanoseconds).
+static benchmark::Counter timePer(double items) {
+  return benchmark::Counter(
+    items,
+    benchmark::Counter::kIsIterationInvariantRate |
+      benchmark::Counter::kInvert);
+}
+
+static void setAllocCounters(benchmark::State &state, uint64_t allocs,
+                             const char *perName, double perItems) {
+  state.counters["allocs/iter"] =
+    benchmark::Counter(allocs, benchmark::Counter::kAvgIterations);
+  if (perItems > 0) {
+    state.counters[perName] = benchmark::Counter(
+      allocs / perItems, benchmark::Counter::kAvgIterations);
+  }
+}
+
+static void benchPhase(benchmark::State &state, BenchModule *M, Phase phase) {
+  // MaxPaths=0 leaves the cfg phase with func_summary, blocks and edges.
+  unsigned savedMaxPaths = MaxPaths;
+  if (phase == Phase::Cfg) MaxPaths = 0;
+  raw_null_ostream out;
+  raw_null_ostream log;
+  uint64_t allocStart = AllocCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    runPhase(*M, phase, out, log);
+  }
+  uint64_t allocs = AllocCount.load(std::memory_order_relaxed) - allocStart;
+  MaxPaths = savedMaxPaths;
+  state.counters["insts"] = M->instCount;
+  state.counters["ns/inst"] = timePer(M->instCount);
+  if (phase == Phase::Paths) {
+    state.counters["paths"] = M->pathCount;
+    if (M->pathCount) state.counters["ns/path"] = timePer(M->pathCount);
+    setAllocCounters(state, allocs, "allocs/path", M->pathCount);
+  } else {
+    setAllocCounters(state, allocs, "allocs/inst", M->instCount);
+  }
+}
+
+// Time body, which performs calls operations per iteration.
+template <typename Body>
+static void benchCalls(benchmark::State &state, unsigned calls, Body body) {
+  uint64_t allocStart = AllocCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    body();
+  }
+  uint64_t allocs = AllocCount.load(std::memory_order_relaxed) - allocStart;
+  state.counters["calls"] = calls;
+  if (calls) state.counters["ns/call"] = timePer(calls);
+  setAllocCounters(state, allocs, "allocs/call", calls);
+}
+
+static void benchEscapeJson(benchmark::State &state, BenchModule *M) {
+  // Value names and pp labels are what the records escape most.
+  std::vector<std::string> strs;
+  for (Function *F : M->fns) {
+    FunctionIds ids(*F, false);
+    for (const Instruction &I : instructions(*F)) {
+      strs.push_back(ids.ppLabel(&I).str());
+      if (I.hasName()) strs.push_back(I.getName().str());
+    }
+  }
+  raw_null_ostream out;
+  benchCalls(state, strs.size(), [&]() {
+    for (const std::string &s : strs) emitJsonString(out, s);
+  });
+}
+
+static void benchValueId(benchmark::State &state, BenchModule *M) {
+  std::vector<std::unique_ptr<FunctionIds>> ids;
+  unsigned calls = 0;
+  for (Function *F : M->fns) {
+    ids.push_back(std::make_unique<FunctionIds>(*F, false));
+    for (const Instruction &I : instructions(*F)) calls += 1 + I.getNumOperands();
+  }
+  benchCalls(state, calls, [&]() {
+    for (size_t i = 0; i < M->fns.size(); ++i) {
+      for (const Instruction &I : instructions(*M->fns[i])) {
+        benchmark::DoNotOptimize(ids[i]->valueId(&I));
+        for (const Use &U : I.operands()) {
+          benchmark::DoNotOptimize(ids[i]->valueId(U.get()));
+        }
+      }
+    }
+  });
+}
+
+static void benchProgramPointLabel(benchmark::State &state, BenchModule *M) {
+  benchCalls(state, M->instCount, [&]() {
+    for (Function *F : M->fns) {
+      for (const BasicBlock &BB : *F) {
+        int idx = 0;
+        for (const Instruction &I : BB) {
+          (void)I;
+          benchmark::DoNotOptimize(
+            programPointLabel(F->getName(), BB.getName(), idx++));
+        }
+      }
+    }
+  });
+}
+
+static void benchCondExpr(benchmark::State &state, BenchModule *M) {
+  // One decision per conditional branch arm and switch case, as the
+  // enumerator builds them.
+  struct FnDecisions {
+    std::unique_ptr<FunctionIds> ids;
+    std::vector<Decision> decisions;
+  };
+  std::vector<FnDecisions> fns;
+  unsigned calls = 0;
+  for (Function *F : M->fns) {
+    FnDecisions fd;
+    fd.ids = std::make_unique<FunctionIds>(*F, false);
+    for (const BasicBlock &BB : *F) {
+      const Instruction *T = BB.getTerminator();
+      Decision d;
+      d.term = T;
+      if (auto *BI = dyn_cast_or_null<BranchInst>(T)) {
+        if (!BI->isConditional()) continue;
+        d.kind = "br";
+        d.cond = BI->getCondition();
+        for (unsigned i = 0; i < 2; ++i) {
+          d.succ = BI->getSuccessor(i);
+          d.sense = i == 0 ? "true" : "false";
+          fd.decisions.push_back(d);
+        }
+      } else if (auto *SI = dyn_cast_or_null<SwitchInst>(T)) {
+        d.kind = "switch";
+        d.cond = SI->getCondition();
+        for (auto &Case : SI->cases()) {
+          d.succ = Case.getCaseSuccessor();
+          d.caseValue = Case.getCaseValue();
+          fd.decisions.push_back(d);
+        }
+        d.succ = SI->getDefaultDest();
+        d.caseValue = nullptr;
+        d.isDefault = true;
+        fd.decisions.push_back(d);
+      }
+    }
+    calls += fd.decisions.size();
+    fns.push_back(std::move(fd));
+  }
+  raw_null_ostream out;
+  benchCalls(state, calls, [&]() {
+    for (FnDecisions &fd : fns) {
+      for (const Decision &d : fd.decisions) {
+        emitCondExpr(out, buildDecisionCondExpr(d, *fd.ids));
+      }
+    }
+  });
+}
+
+// Console output as usual, plus one CSV row per run in the column style of
+// benchmarks.final.csv.
+class CsvReporter : public benchmark::ConsoleReporter {
+public:
+  explicit CsvReporter(raw_ostream *csv) : csv(csv) {
+    if (csv) {
+      *csv << "source,benchmark,iterations,ns_per_iter,inst_count,"
+              "path_count,calls,ns_per_inst,ns_per_path,ns_per_call,"
+              "allocs_per_iter,allocs_per_path,allocs_per_inst,"
+              "allocs_per_call\n";
+    }
+  }
+
+  void ReportRuns(const std::vector<Run> &reports) override {
+    ConsoleReporter::ReportRuns(reports);
+    if (!csv) return;
+    for (const Run &run : reports) {
+      if (run.error_occurred || run.run_type != Run::RT_Iteration) continue;
+      std::string name = run.benchmark_name();
+      StringRef bench, source;
+      std::tie(bench, source) = StringRef(name).split('/');
+      *csv << source << "," << bench << "," << run.iterations << ",";
+      *csv << format("%.3f", run.GetAdjustedRealTime());
+      for (const char *name : {"insts", "paths", "calls"}) {
+        *csv << ",";
+        auto it = run.counters.find(name);
+        if (it != run.counters.end()) *csv << uint64_t(it->second.value);
+      }
+      for (const char *name : {"ns/inst", "ns/path", "ns/call"}) {
+        *csv << ",";
+        auto it = run.counters.find(name);
+        if (it != run.counters.end()) {
+          *csv << format("%.3f", it->second.value * 1e9);
+        }
+      }
+      for (const char *name :
+           {"allocs/iter", "allocs/path", "allocs/inst", "allocs/call"}) {
+        *csv << ",";
+        auto it = run.counters.find(name);
+        if (it != run.counters.end()) *csv << format("%.3f", it->second.value);
+      }
+      *csv << "\n";
+    }
+  }
+
+private:
+  raw_ostream *csv;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  Quiet = true;
+  cl::ParseCommandLineOptions(argc, argv,
+                              "PublicDataPass emission microbenchmarks\n");
+
+  std::vector<std::string> paths(BenchInputs.begin(), BenchInputs.end());
+#ifdef PUBLIC_DATA_BENCH_INPUTS
+  if (paths.empty()) {
+    SmallVector<StringRef, 4> defaults;
+    StringRef(PUBLIC_DATA_BENCH_INPUTS).split(defaults, ';', -1, false);
+    for (StringRef path : defaults) paths.push_back(path.str());
+  }
+#endif
+  if (paths.empty()) {
+    errs() << "PublicDataPassBench: no inputs\n";
+    return 1;
+  }
+
+  BenchAnalysisManagers AM;
+  std::vector<std::unique_ptr<BenchModule>> modules;
+  for (const std::string &path : paths) {
+    auto M = std::make_unique<BenchModule>();
+    M->source = sys::path::stem(path).str();
+    M->ctx = std::make_unique<LLVMContext>();
+    SMDiagnostic err;
+    M->module = parseIRFile(path, err, *M->ctx);
+    if (!M->module) {
+      err.print("PublicDataPassBench", errs());
+      return 1;
+    }
+    for (Function &F : *M->module) {
+      if (F.isDeclaration()) continue;
+      M->fns.push_back(&F);
+      M->analyses.push_back(computeAnalyses(F, AM.FAM));
+      M->instCount += F.getInstructionCount();
+    }
+    M->pathCount = countPaths(*M);
+    modules.push_back(std::move(M));
+  }
+
+  for (auto &M : modules) {
+    BenchModule *P = M.get();
+    auto reg = [&](const char *bench, auto fn) {
+      std::string name = std::string(bench) + "/" + P->source;
+      benchmark::RegisterBenchmark(name.c_str(), fn, P)
+        ->Unit(benchmark::kNanosecond);
+    };
+    reg("trace", [](benchmark::State &s, BenchModule *M) {
+      benchPhase(s, M, Phase::Trace);
+    });
+    reg("cfg", [](benchmark::State &s, BenchModule *M) {
+      benchPhase(s, M, Phase::Cfg);
+    });
+    reg("paths", [](benchmark::State &s, BenchModule *M) {
+      benchPhase(s, M, Phase::Paths);
+    });
+    reg("escape_json", benchEscapeJson);
+    reg("value_id", benchValueId);
+    reg("pp_label", benchProgramPointLabel);
+    reg("cond_expr", benchCondExpr);
+  }
+
+  std::unique_ptr<raw_fd_ostream> csv;
+  if (!BenchCsv.empty()) {
+    std::error_code ec;
+    csv = std::make_unique<raw_fd_ostream>(BenchCsv, ec, sys::fs::OF_Text);
+    if (ec) {
+      errs() << "Failed to open CSV file: " << ec.message() << "\n";
+      return 1;
+    }
+  }
+  CsvReporter reporter(csv.get());
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,243 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+// Shared-memory handoff of rendered functions (-public-data-shm): a POSIX
+// shared-memory object holding a single-producer, single-reader byte ring
+// of completed functions. Plain C++17 with no LLVM dependency, like
+// ColumnarTrace.h; symex/shm.py is the reader.
+//
+// Integers are in host byte order; the region never leaves the machine.
+//
+//   region:  "CTPSHM01", u32 version, u32 header_size (64),
+//            u64 capacity, u64 head, u64 tail, u32 closed, u32 flags,
+//            u64 functions, u64 dropped, then capacity bytes of ring.
+//   message: u32 kind, u32 0, u64 size, u32 module_len, u32 fn_len,
+//            u64 trace_len, u64 trace_index_len, u64 cfg_len, then the
+//            module, fn, trace, trace index and CFG bytes, zero-padded to
+//            size (a multiple of 8).
+//
+// head and tail count bytes ever written and consumed; a message starts at
+// head % capacity and never wraps. When fewer than MessageHeaderSize bytes
+// remain before the end of the ring both sides skip them, and otherwise the
+// producer fills a gap that is too small with a Pad message; either way
+// head moves past the gap before the message is written at offset 0. The
+// producer publishes head (release) after the message bytes; the reader
+// stores tail once it has copied a message out. closed is set once the
+// producer is done.
+//
+// With the columnar trace format (flags & FlagColumnar) the first message
+// carries the columnar file header and every function's trace is its block,
+// so header + block is a complete columnar file.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CT_SHM_AVAILABLE 1
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#endif
+
+namespace ct_shm {
+
+inline constexpr char Magic[8] = {'C', 'T', 'P', 'S', 'H', 'M', '0', '1'};
+inline constexpr uint32_t Version = 1;
+inline constexpr uint32_t HeaderSize = 64;
+inline constexpr uint32_t MessageHeaderSize = 48;
+inline constexpr uint32_t FlagColumnar = 1;
+
+enum MessageKind : uint32_t {
+  FunctionMessage = 1,
+  ColumnarHeaderMessage = 2,
+  PadMessage = 3,
+};
+
+// Region header offsets.
+inline constexpr size_t CapacityOffset = 16;
+inline constexpr size_t HeadOffset = 24;
+inline constexpr size_t TailOffset = 32;
+inline constexpr size_t ClosedOffset = 40;
+inline constexpr size_t FlagsOffset = 44;
+inline constexpr size_t FunctionsOffset = 48;
+inline constexpr size_t DroppedOffset = 56;
+
+inline constexpr uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+#ifdef CT_SHM_AVAILABLE
+
+// The producer side. create() replaces any object of the same name, so a
+// reader still attached to an older run keeps its own (closed) region.
+class Producer {
+public:
+  Producer() = default;
+  Producer(const Producer &) = delete;
+  Producer &operator=(const Producer &) = delete;
+  ~Producer() { close(); }
+
+  // name is a POSIX shm name ("/ct-trace"; a missing '/' is added).
+  // Returns false with error set when the region cannot be created.
+  bool create(std::string_view name, uint64_t capacity, uint32_t flags,
+              std::string &error) {
+    shmName = std::string(name);
+    if (shmName.empty() || shmName[0] != '/') shmName.insert(0, "/");
+    capacity = align8(capacity);
+    if (capacity < 2 * MessageHeaderSize) capacity = 2 * MessageHeaderSize;
+    shm_unlink(shmName.c_str());
+    int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+      error = std::strerror(errno);
+      return false;
+    }
+    size = HeaderSize + capacity;
+    if (ftruncate(fd, off_t(size)) != 0) {
+      error = std::strerror(errno);
+      ::close(fd);
+      shm_unlink(shmName.c_str());
+      return false;
+    }
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+      error = std::strerror(errno);
+      shm_unlink(shmName.c_str());
+      return false;
+    }
+    base = static_cast<unsigned char *>(map);
+    this->capacity = capacity;
+    std::memset(base, 0, HeaderSize);
+    store32(8, Version);
+    store32(12, HeaderSize);
+    std::memcpy(base + CapacityOffset, &capacity, 8);
+    store32(FlagsOffset, flags);
+    // Readers poll for the magic, so it goes last.
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    std::memcpy(base, Magic, 8);
+    return true;
+  }
+
+  bool valid() const { return base != nullptr; }
+  uint64_t maxMessage() const { return capacity - MessageHeaderSize; }
+
+  // Append one message, waiting while the reader has not freed enough of
+  // the ring. waitMs bounds the wait (0 = no limit); a message that times
+  // out or can never fit is dropped and counted, and false is returned.
+  // After a timeout, messages are dropped without waiting until the reader
+  // frees space again, so a run without a reader is not slowed per message.
+  bool publish(MessageKind kind, std::string_view module, std::string_view fn,
+               std::string_view trace, std::string_view traceIndex,
+               std::string_view cfg, unsigned waitMs) {
+    if (!base) return false;
+    uint64_t payload = module.size() + fn.size() + trace.size() +
+                       traceIndex.size() + cfg.size();
+    uint64_t msgSize = align8(MessageHeaderSize + payload);
+    if (msgSize > capacity) return drop();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t head = load64(HeadOffset);
+    uint64_t pos = head % capacity;
+    // Skip (or pad) the end of the ring when the message does not fit. The
+    // skip is published on its own: the message goes to offset 0, which the
+    // reader only frees once it has consumed everything up to the skip.
+    if (capacity - pos < msgSize) {
+      uint64_t gap = capacity - pos;
+      if (!waitForSpace(head, gap, start, waitMs)) {
+        stalled = true;
+        return drop();
+      }
+      if (gap >= MessageHeaderSize) {
+        unsigned char *pad = base + HeaderSize + pos;
+        std::memset(pad, 0, MessageHeaderSize);
+        writeU32(pad, PadMessage);
+        std::memcpy(pad + 8, &gap, 8);
+      }
+      head += gap;
+      storeHead(head);
+    }
+    if (!waitForSpace(head, msgSize, start, waitMs)) {
+      stalled = true;
+      return drop();
+    }
+    stalled = false;
+    unsigned char *msg = base + HeaderSize + head % capacity;
+    std::memset(msg, 0, MessageHeaderSize);
+    writeU32(msg, kind);
+    std::memcpy(msg + 8, &msgSize, 8);
+    writeU32(msg + 16, uint32_t(module.size()));
+    writeU32(msg + 20, uint32_t(fn.size()));
+    uint64_t lens[3] = {trace.size(), traceIndex.size(), cfg.size()};
+    std::memcpy(msg + 24, lens, sizeof(lens));
+    unsigned char *at = msg + MessageHeaderSize;
+    for (std::string_view part : {module, fn, trace, traceIndex, cfg}) {
+      if (!part.empty()) std::memcpy(at, part.data(), part.size());
+      at += part.size();
+    }
+    std::memset(at, 0, msg + msgSize - at);
+    if (kind == FunctionMessage) {
+      __atomic_fetch_add(reinterpret_cast<uint64_t *>(base + FunctionsOffset),
+                         1, __ATOMIC_RELAXED);
+    }
+    storeHead(head + msgSize);
+    return true;
+  }
+
+  // Mark the ring closed and unmap it. The object stays until the reader
+  // unlinks it (or the next create()).
+  void close() {
+    if (!base) return;
+    __atomic_store_n(reinterpret_cast<uint32_t *>(base + ClosedOffset), 1u,
+                     __ATOMIC_RELEASE);
+    munmap(base, size);
+    base = nullptr;
+  }
+
+private:
+  bool waitForSpace(uint64_t head, uint64_t bytes,
+                    std::chrono::steady_clock::time_point start,
+                    unsigned waitMs) {
+    while (head + bytes - load64(TailOffset) > capacity) {
+      if (waitMs && (stalled || std::chrono::steady_clock::now() - start >
+                                  std::chrono::milliseconds(waitMs))) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
+  bool drop() {
+    __atomic_fetch_add(reinterpret_cast<uint64_t *>(base + DroppedOffset), 1,
+                       __ATOMIC_RELAXED);
+    return false;
+  }
+
+  void storeHead(uint64_t head) {
+    __atomic_store_n(reinterpret_cast<uint64_t *>(base + HeadOffset), head,
+                     __ATOMIC_RELEASE);
+  }
+  uint64_t load64(size_t offset) const {
+    return __atomic_load_n(reinterpret_cast<uint64_t *>(base + offset),
+                           __ATOMIC_ACQUIRE);
+  }
+  void store32(size_t offset, uint32_t v) { writeU32(base + offset, v); }
+  static void writeU32(unsigned char *p, uint32_t v) {
+    std::memcpy(p, &v, 4);
+  }
+
+  std::string shmName;
+  unsigned char *base = nullptr;
+  uint64_t capacity = 0;
+  size_t size = 0;
+  bool stalled = false;
+};
+
+#endif // CT_SHM_AVAILABLE
+
+} // namespace ct_shm
+
+#endif // SHM_RING_H
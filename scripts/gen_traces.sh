@@ -4,16 +4,33 @@ set -euo pipefail
 ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
 BUILD_DIR="${ROOT}/build"
 PLUGIN="${BUILD_DIR}/PublicDataPass.so"
+CT_TRACE="${BUILD_DIR}/ct-trace"
 OUT_DIR="${BUILD_DIR}/traces"
 
-if [[ ! -f "${PLUGIN}" ]]; then
-  echo "Missing ${PLUGIN}. Build the plugin first." >&2
+# PASS_RUNNER=ct-trace runs every source through one ct-trace process
+# (parsing on a thread pool) instead of one opt process per source.
+runner="${PASS_RUNNER:-opt}"
+if [[ "${runner}" == "ct-trace" ]]; then
+  tool="${CT_TRACE}"
+else
+  tool="${PLUGIN}"
+fi
+if [[ ! -f "${tool}" ]]; then
+  echo "Missing ${tool}. Build the plugin first." >&2
   echo "Hint: (cd \"${BUILD_DIR}\" && ninja)" >&2
   exit 1
 fi
 
 mkdir -p "${OUT_DIR}"
 
+# PASS_DRIVER=module renders functions on a thread pool (PUBLIC_DATA_THREADS,
+# 0 = all cores); output is identical to the per-function pass.
+# CALLEE_SUMMARIES=1 only takes effect with the module driver.
+passes="function(public-data)"
+if [[ "${PASS_DRIVER:-function}" == "module" ]]; then
+  passes="public-data-module"
+fi
+
 sources=()
 if [[ -n "${BENCH_LIST:-}" ]]; then
   if [[ ! -f "${BENCH_LIST}" ]]; then
@@ -34,6 +51,55 @@ if (( ${#sources[@]} == 0 )); then
   exit 1
 fi
 
+# PUBLIC_ARGS: comma-separated fn:arg list for -public-data-public-arg.
+public_arg=()
+if [[ -n "${PUBLIC_ARGS:-}" ]]; then
+  public_arg=(-public-data-public-arg="${PUBLIC_ARGS}")
+fi
+pass_flags=(
+  -passes="${passes}"
+  -public-data-threads="${PUBLIC_DATA_THREADS:-0}"
+  -public-data-quiet
+  -public-data-trace-types="${TRACE_TYPES:-0}"
+  -public-data-max-inst="${MAX_INST:-0}"
+  -public-data-max-loop-iters="${MAX_LOOP_ITERS:-0}"
+  -public-data-max-paths="${MAX_PATHS:-200}"
+  -public-data-max-path-depth="${MAX_PATH_DEPTH:-256}"
+  -public-data-path-count-max-states="${PATH_COUNT_MAX_STATES:-1000000}"
+  -public-data-fn-time-budget-ms="${FN_TIME_BUDGET_MS:-0}"
+  -public-data-fn-mem-budget-mb="${FN_MEM_BUDGET_MB:-0}"
+  -public-data-prune-correlated="${PRUNE_CORRELATED:-1}"
+  -public-data-prune-ranges="${PRUNE_RANGES:-1}"
+  -public-data-path-cond-format="${PATH_COND_FORMAT:-string}"
+  -public-data-path-encoding="${PATH_ENCODING:-full}"
+  -public-data-cond-table="${COND_TABLE:-0}"
+  -public-data-path-mode="${PATH_MODE:-function}"
+  -public-data-path-order="${PATH_ORDER:-dfs}"
+  -public-data-dedup-paths="${DEDUP_PATHS:-0}"
+  -public-data-static-public="${STATIC_PUBLIC:-0}"
+  -public-data-path-slice="${PATH_SLICE:-0}"
+  -public-data-loops="${LOOPS:-0}"
+  -public-data-mem-ssa="${MEM_SSA:-0}"
+  -public-data-callee-summaries="${CALLEE_SUMMARIES:-0}"
+  -public-data-perf="${PERF:-0}"
+  -public-data-intern-ids="${INTERN_IDS:-0}"
+  -public-data-compress="${COMPRESS:-none}"
+  -public-data-trace-format="${TRACE_FORMAT:-ndjson}"
+  -public-data-path-include-pp-seq="${INCLUDE_PP_SEQ:-0}"
+  -public-data-pp-coverage="${EMIT_PP_COVERAGE:-0}"
+  -public-data-pp-coverage-format="${PP_COVERAGE_FORMAT:-pp}"
+  -public-data-cache-dir="${CACHE_DIR:-}"
+  -public-data-shard-fns="${SHARD_FNS:-1}"
+  -public-data-shard-kb="${SHARD_KB:-0}"
+  "${public_arg[@]}"
+)
+
+runs="${RUN_REPEAT:-1}"
+if (( runs < 1 )); then
+  runs=1
+fi
+
+lls=()
 for src in "${sources[@]}"; do
   ext="${src##*.}"
   case "${ext}" in
@@ -50,37 +116,44 @@ for src in "${sources[@]}"; do
   trace="${OUT_DIR}/${base}.ndjson"
   cfg="${OUT_DIR}/${base}.cfg.ndjson"
   index="${OUT_DIR}/${base}.trace_index.ndjson"
+  index_bin="${OUT_DIR}/${base}.trace_index.bin"
 
   if [[ "${ext}" == "c" ]]; then
     clang -O0 -Xclang -disable-O0-optnone -S -emit-llvm "${src}" -o "${ll}"
   else
     cp "${src}" "${ll}"
   fi
+  if [[ "${runner}" == "ct-trace" ]]; then
+    lls+=("${ll}")
+    continue
+  fi
   trace_index_arg=()
   if [[ "${TRACE_INDEX:-0}" == "1" ]]; then
     trace_index_arg=(-public-data-trace-index="${index}")
   fi
-
-  runs="${RUN_REPEAT:-1}"
-  if (( runs < 1 )); then
-    runs=1
+  if [[ "${TRACE_INDEX_BIN:-0}" == "1" ]]; then
+    trace_index_arg+=(-public-data-trace-index-bin="${index_bin}")
+  fi
+  # CACHE_DIR reuses unchanged functions; the manifest lets
+  # run_benchmarks.sh reuse their symex results too.
+  if [[ -n "${CACHE_DIR:-}" ]]; then
+    trace_index_arg+=(
+      -public-data-cache-manifest="${OUT_DIR}/${base}.cache_manifest.ndjson")
+  fi
+  # SHARDS=1 writes per-function shards and a manifest next to the trace.
+  if [[ -n "${SHARD_DIR:-}" ]]; then
+    trace_index_arg+=(-public-data-shard-dir="${SHARD_DIR}")
+  elif [[ "${SHARDS:-0}" == "1" ]]; then
+    trace_index_arg+=(-public-data-shard-dir="${OUT_DIR}/${base}.shards")
   fi
+
   times=()
   for ((i = 0; i < runs; i++)); do
     start_ns="$(date +%s%N)"
     opt -load-pass-plugin "${PLUGIN}" \
-      -passes="function(public-data)" \
-      -public-data-quiet \
+      "${pass_flags[@]}" \
       -public-data-trace="${trace}" \
-      -public-data-trace-types="${TRACE_TYPES:-0}" \
-      -public-data-max-inst="${MAX_INST:-0}" \
       -public-data-cfg="${cfg}" \
-      -public-data-max-loop-iters="${MAX_LOOP_ITERS:-0}" \
-      -public-data-max-paths="${MAX_PATHS:-200}" \
-      -public-data-max-path-depth="${MAX_PATH_DEPTH:-256}" \
-      -public-data-path-cond-format="${PATH_COND_FORMAT:-string}" \
-      -public-data-path-include-pp-seq="${INCLUDE_PP_SEQ:-0}" \
-      -public-data-pp-coverage="${EMIT_PP_COVERAGE:-0}" \
       "${trace_index_arg[@]}" \
       -disable-output "${ll}"
     end_ns="$(date +%s%N)"
@@ -109,6 +182,9 @@ for src in "${sources[@]}"; do
   if [[ "${TRACE_INDEX:-0}" == "1" ]]; then
     echo "Wrote ${index}"
   fi
+  if [[ "${TRACE_INDEX_BIN:-0}" == "1" ]]; then
+    echo "Wrote ${index_bin}"
+  fi
   if [[ "${EMIT_RUN_SUMMARY:-0}" == "1" ]]; then
     summary="${OUT_DIR}/${base}.run_summary.ndjson"
     printf '{"kind":"run_summary","source":"%s","elapsed_ms":%s,"elapsed_ms_min":%s,"elapsed_ms_max":%s,"elapsed_ms_median":%s,"elapsed_ms_mean":%s,"elapsed_runs":%s,"max_paths":%s,"max_path_depth":%s,"max_loop_iters":%s,"max_inst":%s}\n' \
@@ -127,3 +203,40 @@ for src in "${sources[@]}"; do
     echo "Wrote ${summary}"
   fi
 done
+
+if [[ "${runner}" == "ct-trace" ]] && (( ${#lls[@]} > 0 )); then
+  # Same artifact names as above, with {} standing for each source's stem.
+  # run_summary timings exclude parsing, which overlaps on the thread pool.
+  ct_args=(
+    -public-data-trace="${OUT_DIR}/{}.ndjson"
+    -public-data-cfg="${OUT_DIR}/{}.cfg.ndjson"
+    -repeat="${runs}"
+  )
+  if [[ "${TRACE_INDEX:-0}" == "1" ]]; then
+    ct_args+=(-public-data-trace-index="${OUT_DIR}/{}.trace_index.ndjson")
+  fi
+  if [[ "${TRACE_INDEX_BIN:-0}" == "1" ]]; then
+    ct_args+=(-public-data-trace-index-bin="${OUT_DIR}/{}.trace_index.bin")
+  fi
+  if [[ -n "${CACHE_DIR:-}" ]]; then
+    ct_args+=(-public-data-cache-manifest="${OUT_DIR}/{}.cache_manifest.ndjson")
+  fi
+  if [[ -n "${SHARD_DIR:-}" ]]; then
+    ct_args+=(-public-data-shard-dir="${SHARD_DIR}")
+  elif [[ "${SHARDS:-0}" == "1" ]]; then
+    ct_args+=(-public-data-shard-dir="${OUT_DIR}/{}.shards")
+  fi
+  # SHM=<name> also publishes every function to a shared-memory ring for a
+  # concurrent symex.shm.ShmReader (one ring for all sources).
+  if [[ -n "${SHM:-}" ]]; then
+    ct_args+=(
+      -public-data-shm="${SHM}"
+      -public-data-shm-mb="${SHM_MB:-64}"
+      -public-data-shm-wait-ms="${SHM_WAIT_MS:-0}")
+  fi
+  if [[ "${EMIT_RUN_SUMMARY:-0}" == "1" ]]; then
+    ct_args+=(-run-summary="${OUT_DIR}/{}.run_summary.ndjson")
+  fi
+  "${CT_TRACE}" "${pass_flags[@]}" "${ct_args[@]}" "${lls[@]}"
+  echo "Wrote ${#lls[@]} artifact sets to ${OUT_DIR}"
+fi
@@ -6,12 +6,34 @@ ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
 TRACE_INDEX="${TRACE_INDEX:-1}"
 TRACE_TYPES="${TRACE_TYPES:-0}"
 EMIT_PP_COVERAGE="${EMIT_PP_COVERAGE:-1}"
+PP_COVERAGE_FORMAT="${PP_COVERAGE_FORMAT:-pp}"
 INCLUDE_PP_SEQ="${INCLUDE_PP_SEQ:-0}"
 PATH_COND_FORMAT="${PATH_COND_FORMAT:-both}"
+PATH_ENCODING="${PATH_ENCODING:-full}"
+COND_TABLE="${COND_TABLE:-0}"
+INTERN_IDS="${INTERN_IDS:-0}"
+PATH_MODE="${PATH_MODE:-function}"
+PATH_ORDER="${PATH_ORDER:-dfs}"
+COMPRESS="${COMPRESS:-none}"
+TRACE_FORMAT="${TRACE_FORMAT:-ndjson}"
+DEDUP_PATHS="${DEDUP_PATHS:-0}"
+STATIC_PUBLIC="${STATIC_PUBLIC:-0}"
+PATH_SLICE="${PATH_SLICE:-0}"
+LOOPS="${LOOPS:-0}"
+MEM_SSA="${MEM_SSA:-0}"
+CALLEE_SUMMARIES="${CALLEE_SUMMARIES:-0}"
+PERF="${PERF:-0}"
+CACHE_DIR="${CACHE_DIR:-}"
+SHARDS="${SHARDS:-0}"
+SHARD_DIR="${SHARD_DIR:-}"
+SHARD_FNS="${SHARD_FNS:-1}"
+SHARD_KB="${SHARD_KB:-0}"
 MAX_PATHS="${MAX_PATHS:-200}"
 MAX_PATH_DEPTH="${MAX_PATH_DEPTH:-256}"
 MAX_LOOP_ITERS="${MAX_LOOP_ITERS:-0}"
 MAX_INST="${MAX_INST:-0}"
+FN_TIME_BUDGET_MS="${FN_TIME_BUDGET_MS:-0}"
+FN_MEM_BUDGET_MB="${FN_MEM_BUDGET_MB:-0}"
 BENCH_LIST="${BENCH_LIST:-${ROOT}/benchmarks.txt}"
 EMIT_RUN_SUMMARY="${EMIT_RUN_SUMMARY:-1}"
 RUN_REPEAT="${RUN_REPEAT:-1}"
@@ -22,8 +44,8 @@ ANALYZE_LOOP_INVARIANTS="${ANALYZE_LOOP_INVARIANTS:-0}"
 AGGREGATE_RESULTS="${AGGREGATE_RESULTS:-1}"
 AGGREGATE_ENHANCED="${AGGREGATE_ENHANCED:-1}"
 
-export TRACE_INDEX TRACE_TYPES EMIT_PP_COVERAGE INCLUDE_PP_SEQ PATH_COND_FORMAT
-export MAX_PATHS MAX_PATH_DEPTH MAX_LOOP_ITERS MAX_INST
+export TRACE_INDEX TRACE_TYPES EMIT_PP_COVERAGE PP_COVERAGE_FORMAT INCLUDE_PP_SEQ PATH_COND_FORMAT PATH_ENCODING COND_TABLE INTERN_IDS PATH_MODE PATH_ORDER COMPRESS TRACE_FORMAT DEDUP_PATHS STATIC_PUBLIC PATH_SLICE LOOPS MEM_SSA CALLEE_SUMMARIES PERF CACHE_DIR SHARDS SHARD_DIR SHARD_FNS SHARD_KB
+export MAX_PATHS MAX_PATH_DEPTH MAX_LOOP_ITERS MAX_INST FN_TIME_BUDGET_MS FN_MEM_BUDGET_MB
 export BENCH_LIST EMIT_RUN_SUMMARY RUN_REPEAT RUN_SYMEX ANALYZE_MODE ANALYZE_NO_CACHE ANALYZE_LOOP_INVARIANTS AGGREGATE_RESULTS AGGREGATE_ENHANCED
 ./scripts/gen_traces.sh
 
@@ -67,6 +89,10 @@ if [[ "${RUN_SYMEX}" == "1" ]]; then
   if [[ "${ANALYZE_LOOP_INVARIANTS}" == "1" ]]; then
     loop_inv_arg=(--loop-invariants)
   fi
+  slice_arg=()
+  if [[ "${PATH_SLICE}" == "1" ]]; then
+    slice_arg=(--slice)
+  fi
   for cfg in "${cfg_files[@]}"; do
     base="$(basename "${cfg}" .cfg.ndjson)"
     dir="$(dirname "${cfg}")"
@@ -78,12 +104,19 @@ if [[ "${RUN_SYMEX}" == "1" ]]; then
       echo "Skipping symexec: trace not found for ${cfg} (${trace})" >&2
       continue
     fi
+    result_cache_arg=()
+    manifest="${dir}/${base}.cache_manifest.ndjson"
+    if [[ -n "${CACHE_DIR}" && -f "${manifest}" ]]; then
+      result_cache_arg=(--manifest "${manifest}" --result-cache "${CACHE_DIR}/symex")
+    fi
     python3 -m symex.analyze \
       --mode "${ANALYZE_MODE}" \
       --trace "${trace}" \
       --cfg "${cfg}" \
       --out "${path_public}" \
       "${loop_inv_arg[@]}" \
+      "${slice_arg[@]}" \
+      "${result_cache_arg[@]}" \
       "${no_cache_arg[@]}"
     if [[ "${AGGREGATE_RESULTS}" == "1" ]]; then
       enhanced_arg=()
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Path-explosion scaling sweep: ct-synth emits one module per
+# (shape, size, tx density) point, ct-trace runs the pass over it in its own
+# process (so max_rss_kb is per point) with perf records, and symex.scaling
+# collects time, memory and output bytes per point into a CSV.
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="${ROOT}/build"
+OUT_DIR="${BUILD_DIR}/scaling"
+
+SCALING_SHAPES="${SCALING_SHAPES:-diamonds loops switch indirectbr}"
+SCALING_SIZES="${SCALING_SIZES:-2 4 6 8 10 12 14}"
+SCALING_TX_DENSITIES="${SCALING_TX_DENSITIES:-0.5}"
+# Large enough that the enumerator, not the budget, is measured until the
+# diamonds exceed it; dfs_prune_max_paths shows where they do.
+MAX_PATHS="${MAX_PATHS:-10000}"
+MAX_PATH_DEPTH="${MAX_PATH_DEPTH:-256}"
+MAX_LOOP_ITERS="${MAX_LOOP_ITERS:-1}"
+RUN_REPEAT="${RUN_REPEAT:-1}"
+
+for tool in ct-synth ct-trace; do
+  if [[ ! -x "${BUILD_DIR}/${tool}" ]]; then
+    echo "Missing ${BUILD_DIR}/${tool}. Build the pass first." >&2
+    echo "Hint: (cd \"${BUILD_DIR}\" && ninja)" >&2
+    exit 1
+  fi
+done
+
+mkdir -p "${OUT_DIR}"
+rm -f "${OUT_DIR}"/*.ll "${OUT_DIR}"/*.ndjson
+
+for shape in ${SCALING_SHAPES}; do
+  for size in ${SCALING_SIZES}; do
+    for density in ${SCALING_TX_DENSITIES}; do
+      base="${shape}_${size}_d${density}"
+      ll="${OUT_DIR}/${base}.ll"
+      "${BUILD_DIR}/ct-synth" -shape="${shape}" -size="${size}" \
+        -tx-density="${density}" -o "${ll}"
+      "${BUILD_DIR}/ct-trace" \
+        -public-data-quiet \
+        -public-data-perf \
+        -public-data-trace="${OUT_DIR}/${base}.ndjson" \
+        -public-data-cfg="${OUT_DIR}/${base}.cfg.ndjson" \
+        -public-data-max-paths="${MAX_PATHS}" \
+        -public-data-max-path-depth="${MAX_PATH_DEPTH}" \
+        -public-data-max-loop-iters="${MAX_LOOP_ITERS}" \
+        -public-data-path-cond-format="${PATH_COND_FORMAT:-string}" \
+        -public-data-pp-coverage="${EMIT_PP_COVERAGE:-0}" \
+        -repeat="${RUN_REPEAT}" \
+        -run-summary="${OUT_DIR}/${base}.run_summary.ndjson" \
+        "${ll}"
+    done
+  done
+done
+
+OUT="${1:-${ROOT}/benchmarks.scaling.csv}"
+python3 -m symex.scaling --dir "${OUT_DIR}" --out "${OUT}"
+echo "Wrote ${OUT}"
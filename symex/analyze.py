@@ -3,12 +3,19 @@ from __future__ import annotations
 """Analyzer entry point (stub or minimal symexec)."""
 
 import argparse
+import hashlib
+import io
 import json
+import os
+import tempfile
 from collections import defaultdict
+from typing import Dict, Iterator, List, Optional, Tuple
 
-from .loop_invariants import analyze_loop_invariants
-from .pipeline import build_pipeline
-from .symexec import SymExecEngine
+from .loop_invariants import analyze_loop_accesses, analyze_loop_invariants
+from .parser import load_cache_manifest
+from .pipeline import FunctionPipeline, build_pipeline, path_node_insts
+from .publicness import PathPublicness
+from .symexec import PathAnalysisSummary, SymExecEngine
 
 
 def emit_path_publicness_stub(trace_path: str, cfg_path: str, out_path: str) -> None:
@@ -40,30 +47,129 @@ def emit_path_publicness_stub(trace_path: str, cfg_path: str, out_path: str) ->
                     f.write(json.dumps(rec) + "\n")
 
 
+def _analyze_function_paths(
+    engine: SymExecEngine,
+    pipe: FunctionPipeline,
+) -> Iterator[Tuple[List[PathPublicness], PathAnalysisSummary]]:
+    """Yield per-path symexec results for one function.
+
+    Trie-encoded CFGs share prefix execution and solver scopes across paths;
+    fully materialized paths are analyzed independently.
+    """
+    if pipe.path_nodes:
+        leaves = {
+            b.path.leaf_node: b.path.path_id
+            for b in pipe.paths
+            if b.path.leaf_node is not None and b.path.path_id is not None
+        }
+        yield from engine.analyze_path_trie(
+            nodes=pipe.path_nodes,
+            leaves=leaves,
+            node_insts=lambda node: path_node_insts(pipe, node),
+        )
+        return
+    for bundle in pipe.paths:
+        path_id = bundle.path.path_id
+        if path_id is None:
+            continue
+        yield engine.analyze_path(
+            path_id=path_id,
+            insts=bundle.insts,
+            path_conditions=bundle.path.path_cond,
+            path_conditions_json=bundle.path.path_cond_json,
+        )
+
+
+def _result_cache_path(
+    cache_dir: str, key: str, loop_invariants: bool, use_slices: bool
+) -> str:
+    """Cached results for one function key under one set of analysis options."""
+    variant = ("slice." if use_slices else "") + ("loopinv." if loop_invariants else "")
+    return os.path.join(cache_dir, f"{key}.{variant}path_public.ndjson")
+
+
+def _result_keys(pipes: Dict[str, FunctionPipeline], keys: Dict[str, str]) -> Dict[str, str]:
+    """Result-cache key per function: its manifest key, combined with the keys
+    of every function defined in the module that it reaches through direct
+    calls, since symexec inlines or summarizes those callees' bodies. A
+    function reaching a defined callee without a manifest key gets none."""
+    callees = {
+        fn: {i.callee for i in pipe.insts if i.callee in pipes and i.callee != fn}
+        for fn, pipe in pipes.items()
+    }
+    out: Dict[str, str] = {}
+    for fn in keys:
+        if fn not in pipes:
+            continue
+        reached = {fn}
+        work = [fn]
+        while work:
+            for callee in callees[work.pop()]:
+                if callee not in reached:
+                    reached.add(callee)
+                    work.append(callee)
+        if any(callee not in keys for callee in reached):
+            continue
+        if reached == {fn}:
+            out[fn] = keys[fn]
+            continue
+        h = hashlib.sha256()
+        for callee in sorted(reached):
+            h.update(f"{callee}={keys[callee]}\n".encode("utf-8"))
+        out[fn] = h.hexdigest()
+    return out
+
+
+def _store_result(path: str, text: str) -> None:
+    """Write a cache entry through a rename so readers never see it partial."""
+    os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+    fd, tmp = tempfile.mkstemp(dir=os.path.dirname(path) or ".", suffix=".tmp")
+    with os.fdopen(fd, "w", encoding="utf-8") as f:
+        f.write(text)
+    os.replace(tmp, path)
+
+
 def emit_path_publicness_symexec(
     trace_path: str,
     cfg_path: str,
     out_path: str,
     use_cache: bool = True,
     emit_loop_invariants: bool = False,
+    use_slices: bool = False,
+    manifest_path: Optional[str] = None,
+    result_cache: Optional[str] = None,
 ) -> None:
-    """Run minimal symexec per path and emit path_publicness records."""
-    pipes = build_pipeline(trace_path, cfg_path)
+    """Run minimal symexec per path and emit path_publicness records.
+
+    With use_slices, paths carrying slice_pps only execute (and report defs
+    of) the instructions their transmitters and path conditions depend on.
+    With a cache manifest (-public-data-cache-manifest) and a result_cache
+    directory, a function whose key already has results there reuses them
+    (summaries included) instead of being analyzed again. The key also
+    covers the function's defined callees (see _result_keys).
+    """
+    pipes = build_pipeline(trace_path, cfg_path, use_slices=use_slices)
     engine = SymExecEngine(enable_query_cache=use_cache, function_pipelines=pipes)
-    with open(out_path, "w", encoding="utf-8") as f:
+    keys: Dict[str, str] = {}
+    if manifest_path and result_cache:
+        keys = _result_keys(
+            pipes, {e.fn: e.key for e in load_cache_manifest(manifest_path)}
+        )
+    with open(out_path, "w", encoding="utf-8") as out:
         for fn, pipe in pipes.items():
+            cached = None
+            if fn in keys:
+                cached = _result_cache_path(
+                    result_cache, keys[fn], emit_loop_invariants, use_slices
+                )
+                if os.path.exists(cached):
+                    with open(cached, "r", encoding="utf-8") as c:
+                        out.write(c.read())
+                    continue
+            f = io.StringIO()
             fn_stats = defaultdict(float)
             paths_analyzed = 0
-            for bundle in pipe.paths:
-                path_id = bundle.path.path_id
-                if path_id is None:
-                    continue
-                results, summary = engine.analyze_path(
-                    path_id=path_id,
-                    insts=bundle.insts,
-                    path_conditions=bundle.path.path_cond,
-                    path_conditions_json=bundle.path.path_cond_json,
-                )
+            for results, summary in _analyze_function_paths(engine, pipe):
                 paths_analyzed += 1
                 fn_stats["inst_count"] += summary.inst_count
                 fn_stats["def_count"] += summary.def_count
@@ -74,6 +180,7 @@ def emit_path_publicness_symexec(
                 fn_stats["solver_time_ms"] += summary.solver_time_ms
                 fn_stats["cache_hits"] += summary.cache_hits
                 fn_stats["cache_misses"] += summary.cache_misses
+                fn_stats["static_count"] += summary.static_count
                 for r in results:
                     rec = {
                         "kind": "path_publicness",
@@ -99,30 +206,32 @@ def emit_path_publicness_symexec(
                             "solver_time_ms": round(summary.solver_time_ms, 3),
                             "cache_hits": summary.cache_hits,
                             "cache_misses": summary.cache_misses,
+                            "static_count": summary.static_count,
                         }
                     )
                     + "\n"
                 )
             if paths_analyzed > 0:
-                f.write(
-                    json.dumps(
-                        {
-                            "kind": "function_analysis_summary",
-                            "fn": fn,
-                            "paths_analyzed": int(paths_analyzed),
-                            "inst_count": int(fn_stats["inst_count"]),
-                            "def_count": int(fn_stats["def_count"]),
-                            "query_count": int(fn_stats["query_count"]),
-                            "sat_count": int(fn_stats["sat_count"]),
-                            "unsat_count": int(fn_stats["unsat_count"]),
-                            "unknown_count": int(fn_stats["unknown_count"]),
-                            "solver_time_ms": round(float(fn_stats["solver_time_ms"]), 3),
-                            "cache_hits": int(fn_stats["cache_hits"]),
-                            "cache_misses": int(fn_stats["cache_misses"]),
-                        }
-                    )
-                    + "\n"
-                )
+                fn_summary = {
+                    "kind": "function_analysis_summary",
+                    "fn": fn,
+                    "paths_analyzed": int(paths_analyzed),
+                    "inst_count": int(fn_stats["inst_count"]),
+                    "def_count": int(fn_stats["def_count"]),
+                    "query_count": int(fn_stats["query_count"]),
+                    "sat_count": int(fn_stats["sat_count"]),
+                    "unsat_count": int(fn_stats["unsat_count"]),
+                    "unknown_count": int(fn_stats["unknown_count"]),
+                    "solver_time_ms": round(float(fn_stats["solver_time_ms"]), 3),
+                    "cache_hits": int(fn_stats["cache_hits"]),
+                    "cache_misses": int(fn_stats["cache_misses"]),
+                    "static_count": int(fn_stats["static_count"]),
+                }
+                # Deduplicated CFGs: each analyzed path stands for its class.
+                class_sizes = [b.path.class_size for b in pipe.paths if b.path.class_size is not None]
+                if class_sizes:
+                    fn_summary["paths_represented"] = int(sum(class_sizes))
+                f.write(json.dumps(fn_summary) + "\n")
             if emit_loop_invariants:
                 inv_records = analyze_loop_invariants(pipe, engine=engine)
                 for rec in inv_records:
@@ -158,6 +267,27 @@ def emit_path_publicness_symexec(
                         )
                         + "\n"
                     )
+                for acc in analyze_loop_accesses(pipe, engine=engine):
+                    f.write(
+                        json.dumps(
+                            {
+                                "kind": "loop_access_publicness",
+                                "fn": acc.fn,
+                                "loop_id": acc.loop_id,
+                                "pp": acc.pp,
+                                "addr": acc.addr,
+                                "form": acc.form,
+                                "public": acc.public,
+                                "operands": list(acc.operands),
+                                "trip_count": acc.trip_count,
+                                "entry_paths": acc.entry_paths,
+                            }
+                        )
+                        + "\n"
+                    )
+            out.write(f.getvalue())
+            if cached is not None:
+                _store_result(cached, f.getvalue())
 
 
 def main() -> int:
@@ -182,7 +312,22 @@ def main() -> int:
     parser.add_argument(
         "--loop-invariants",
         action="store_true",
-        help="Emit loop-invariant publicness from first-iteration loop slices",
+        help="Emit loop-invariant publicness from first-iteration loop slices "
+        "(plus closed-form loop access publicness with -public-data-loops)",
+    )
+    parser.add_argument(
+        "--slice",
+        action="store_true",
+        help="Execute only each path's slice_pps (CFG from -public-data-path-slice)",
+    )
+    parser.add_argument(
+        "--manifest",
+        help="Cache manifest from -public-data-cache-manifest (symexec mode)",
+    )
+    parser.add_argument(
+        "--result-cache",
+        help="Directory of per-function results reused for matching "
+        "manifest keys (symexec mode)",
     )
     args = parser.parse_args()
 
@@ -193,6 +338,9 @@ def main() -> int:
             args.out,
             use_cache=not args.no_cache,
             emit_loop_invariants=args.loop_invariants,
+            use_slices=args.slice,
+            manifest_path=args.manifest,
+            result_cache=args.result_cache,
         )
     else:
         emit_path_publicness_stub(args.trace, args.cfg, args.out)
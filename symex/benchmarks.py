@@ -36,6 +36,8 @@ def _collect_rows(cfg_path: str) -> List[dict]:
             "max_loop_iters": s.max_loop_iters,
             "cutoff_depth": s.cutoff_depth,
             "cutoff_loop": s.cutoff_loop,
+            "cutoff_time": s.cutoff_time,
+            "cutoff_mem": s.cutoff_mem,
             "const_pruned_br": s.const_pruned_br,
             "const_pruned_switch": s.const_pruned_switch,
             "const_pruned_indirect": s.const_pruned_indirect,
@@ -59,6 +61,8 @@ def _collect_rows(cfg_path: str) -> List[dict]:
                 "max_loop_iters": None,
                 "cutoff_depth": None,
                 "cutoff_loop": None,
+                "cutoff_time": None,
+                "cutoff_mem": None,
                 "const_pruned_br": None,
                 "const_pruned_switch": None,
                 "const_pruned_indirect": None,
@@ -276,6 +280,8 @@ def main() -> int:
         "max_loop_iters",
         "cutoff_depth",
         "cutoff_loop",
+        "cutoff_time",
+        "cutoff_mem",
         "const_pruned_br",
         "const_pruned_switch",
         "const_pruned_indirect",
@@ -0,0 +1,282 @@
+from __future__ import annotations
+
+"""Reader for columnar traces (-public-data-trace-format=columnar).
+
+Mirrors llvm-pass/ColumnarTrace.h. An uncompressed file is mmap'ed and
+every column is a view into it: a memoryview, or a numpy array when numpy
+is installed. zstd-compressed files are decoded into memory first.
+"""
+
+import json
+import mmap
+from typing import Dict, Iterator, List, Optional, Union
+
+from .models import TraceInst, TxInfo
+from .parser import Source, open_output
+
+try:
+    import numpy as _np
+except ImportError:  # numpy is optional; columns are memoryviews without it
+    _np = None
+
+MAGIC = b"CTPCOL01"
+VERSION = 1
+FLAG_TYPES = 1
+NONE = 0xFFFFFFFF
+NO_PRED = 0xFF
+
+_FILE_HEADER = 32
+_BLOCK_HEADER = 32
+
+# Section name -> (element bytes, counted per: rows, rows+1, uses, txs,
+# strings+1 or string bytes), in file order (BlockLayout::compute).
+_SECTIONS = (
+    ("pp", 4, "rows"),
+    ("bb", 4, "rows"),
+    ("inst", 4, "rows"),
+    ("def", 4, "rows"),
+    ("callee", 4, "rows"),
+    ("extra", 4, "rows"),
+    ("def_ty", 4, "rows"),
+    ("tx_mask", 4, "rows"),
+    ("use_start", 4, "rows1"),
+    ("tx_start", 4, "rows1"),
+    ("uses", 4, "uses"),
+    ("use_ty", 4, "uses"),
+    ("tx_which", 4, "txs"),
+    ("op", 1, "rows"),
+    ("pred", 1, "rows"),
+    ("tx_kind", 1, "txs"),
+    ("tx_static", 1, "txs"),
+    ("string_start", 4, "strings1"),
+    ("string_bytes", 1, "string_bytes"),
+)
+_TYPED_SECTIONS = ("def_ty", "use_ty")
+
+
+def _align8(n: int) -> int:
+    return (n + 7) & ~7
+
+
+def _u32(buf: memoryview, offset: int) -> int:
+    return int.from_bytes(buf[offset : offset + 4], "little")
+
+
+def is_columnar(path: Source) -> bool:
+    """Whether path (possibly zstd-compressed) holds a columnar trace."""
+    with open_output(path) as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+class ColumnarBlock:
+    """One function's rows. column(name) returns a zero-copy view."""
+
+    def __init__(self, trace: ColumnarTrace, buf: memoryview, offset: int):
+        self.trace = trace
+        self._buf = buf
+        self.offset = offset
+        self.size = int.from_bytes(buf[offset : offset + 8], "little")
+        self.flags = _u32(buf, offset + 8)
+        self.rows = _u32(buf, offset + 12)
+        counts = {
+            "rows": self.rows,
+            "rows1": self.rows + 1,
+            "uses": _u32(buf, offset + 16),
+            "txs": _u32(buf, offset + 20),
+            "strings1": _u32(buf, offset + 24) + 1,
+            "string_bytes": _u32(buf, offset + 28),
+        }
+        self._sections: Dict[str, tuple] = {}
+        at = _BLOCK_HEADER
+        for name, width, per in _SECTIONS:
+            if name in _TYPED_SECTIONS and not self.flags & FLAG_TYPES:
+                continue
+            self._sections[name] = (at, width, counts[per])
+            at = _align8(at + width * counts[per])
+        if at != self.size:
+            raise ValueError(f"malformed columnar trace block at offset {offset}")
+        self._strings: Optional[List[str]] = None
+        self._lists: Dict[str, list] = {}
+
+    @property
+    def types(self) -> bool:
+        return bool(self.flags & FLAG_TYPES)
+
+    def column(self, name: str):
+        """A section as a numpy array (if available) or memoryview; no copy.
+
+        The memoryview fallback uses native byte order, which is the file's
+        on little-endian hosts.
+        """
+        start, width, count = self._sections[name]
+        start += self.offset
+        if _np is not None:
+            dtype = {4: "<i4" if name == "tx_which" else "<u4", 1: "u1"}[width]
+            return _np.frombuffer(self._buf, dtype=dtype, count=count, offset=start)
+        view = self._buf[start : start + width * count]
+        if width == 1:
+            return view
+        return view.cast("i" if name == "tx_which" else "I")
+
+    def _list(self, name: str) -> list:
+        if name not in self._lists:
+            col = self.column(name)
+            self._lists[name] = col.tolist()
+        return self._lists[name]
+
+    @property
+    def strings(self) -> List[str]:
+        """The block's string table; strings[0] is the function name."""
+        if self._strings is None:
+            starts = self._list("string_start")
+            data = bytes(self.column("string_bytes"))
+            self._strings = [
+                data[starts[i] : starts[i + 1]].decode("utf-8")
+                for i in range(len(starts) - 1)
+            ]
+        return self._strings
+
+    @property
+    def fn(self) -> str:
+        return self.strings[0]
+
+    def _rows(self) -> Iterator[tuple]:
+        """Per row: (bb, pp label, op, def, uses, def_ty, use_tys, pred
+        field and name, callee, txs, extra dict)."""
+        s = self.strings
+        trace = self.trace
+        fn = self.fn
+        bb, inst, op, dfn = self._list("bb"), self._list("inst"), self._list("op"), self._list("def")
+        pred, callee, extra = self._list("pred"), self._list("callee"), self._list("extra")
+        use_start, uses = self._list("use_start"), self._list("uses")
+        tx_start, tx_kind = self._list("tx_start"), self._list("tx_kind")
+        tx_which, tx_static = self._list("tx_which"), self._list("tx_static")
+        def_ty = self._list("def_ty") if self.types else None
+        use_ty = self._list("use_ty") if self.types else None
+        for row in range(self.rows):
+            bb_name = s[bb[row]]
+            u0, u1 = use_start[row], use_start[row + 1]
+            t0, t1 = tx_start[row], tx_start[row + 1]
+            p = pred[row]
+            yield (
+                bb_name,
+                f"{fn}:{bb_name}:i{inst[row]}",
+                trace.opcodes[op[row]],
+                None if dfn[row] == NONE else s[dfn[row]],
+                [s[v] for v in uses[u0:u1]],
+                None if def_ty is None or def_ty[row] == NONE else s[def_ty[row]],
+                None if use_ty is None else [s[v] for v in use_ty[u0:u1]],
+                None if p == NO_PRED else ("fcmp_pred" if p < 32 else "icmp_pred"),
+                None if p == NO_PRED else trace.preds[p],
+                None if callee[row] == NONE else s[callee[row]],
+                [(trace.tx_kinds[tx_kind[i]], tx_which[i], bool(tx_static[i])) for i in range(t0, t1)],
+                None if extra[row] == NONE else json.loads(s[extra[row]]),
+            )
+
+    def records(self) -> Iterator[dict]:
+        """Rows as the dicts read_records() yields for an NDJSON trace."""
+        for bb, pp, op, def_id, uses, def_ty, use_tys, pred_key, pred, callee, txs, extra in self._rows():
+            rec: dict = {"fn": self.fn, "bb": bb, "pp": pp, "op": op, "def": def_id, "uses": uses}
+            if use_tys is not None:
+                rec["def_ty"] = def_ty
+                rec["use_tys"] = use_tys
+            if pred_key is not None:
+                rec[pred_key] = pred
+            if callee is not None:
+                rec["callee"] = callee
+            if txs:
+                rec["txs"] = [
+                    {"kind": k, "which": w, **({"static": "equal"} if st else {})} for k, w, st in txs
+                ]
+                rec["tx"] = dict(rec["txs"][0])
+            if extra:
+                rec.update(extra)
+            yield rec
+
+    def trace_insts(self) -> List[TraceInst]:
+        """Rows as TraceInsts, without building record dicts."""
+        out: List[TraceInst] = []
+        fn = self.fn
+        for bb, pp, op, def_id, uses, def_ty, use_tys, pred_key, pred, callee, txs, extra in self._rows():
+            extra = extra or {}
+            out.append(
+                TraceInst(
+                    fn=fn,
+                    bb=bb,
+                    pp=pp,
+                    op=op,
+                    def_id=def_id,
+                    uses=uses,
+                    txs=[TxInfo(kind=k, which=w, static="equal" if st else None) for k, w, st in txs],
+                    def_ty=def_ty,
+                    use_tys=use_tys,
+                    icmp_pred=pred if pred_key == "icmp_pred" else None,
+                    fcmp_pred=pred if pred_key == "fcmp_pred" else None,
+                    atomic_op=extra.get("atomic_op"),
+                    callee=callee,
+                    extract_indices=extra.get("extract_indices"),
+                    insert_indices=extra.get("insert_indices"),
+                    mem_class=extra.get("mem_class"),
+                    mem_def=extra.get("mem_def"),
+                    mem_phi=extra.get("mem_phi"),
+                    def_static=extra.get("def_static"),
+                )
+            )
+        return out
+
+
+class ColumnarTrace:
+    """A columnar trace file: enum tables and one ColumnarBlock per function."""
+
+    def __init__(self, data: Union[bytes, bytearray, mmap.mmap, memoryview]):
+        buf = memoryview(data)
+        if bytes(buf[:8]) != MAGIC:
+            raise ValueError("not a columnar trace")
+        version = _u32(buf, 8)
+        if version > VERSION:
+            raise ValueError(
+                f"columnar trace version {version} is newer than supported version {VERSION}; update symex"
+            )
+        header_size = _u32(buf, 12)
+        tables: List[List[str]] = []
+        at = _FILE_HEADER
+        for count in (_u32(buf, 16), _u32(buf, 20), _u32(buf, 24)):
+            names = []
+            for _ in range(count):
+                n = _u32(buf, at)
+                names.append(bytes(buf[at + 4 : at + 4 + n]).decode("utf-8"))
+                at += 4 + n
+            tables.append(names)
+        self.opcodes, self.preds, self.tx_kinds = tables
+        self._buf = buf
+        self.blocks: List[ColumnarBlock] = []
+        offset = header_size
+        while offset < len(buf):
+            block = ColumnarBlock(self, buf, offset)
+            self.blocks.append(block)
+            offset += block.size
+
+    @classmethod
+    def open(cls, path: Source) -> ColumnarTrace:
+        """mmap an uncompressed file; decode a zstd-compressed one. An
+        in-memory trace (bytes) is read in place."""
+        if isinstance(path, (bytes, bytearray, memoryview)):
+            return cls(path)
+        with open(path, "rb") as f:
+            if f.read(len(MAGIC)) == MAGIC:
+                return cls(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ))
+        with open_output(path) as f:
+            return cls(f.read())
+
+    def block(self, fn: str) -> Optional[ColumnarBlock]:
+        return next((b for b in self.blocks if b.fn == fn), None)
+
+    def records(self) -> Iterator[dict]:
+        for block in self.blocks:
+            yield from block.records()
+
+    def trace_insts(self) -> List[TraceInst]:
+        out: List[TraceInst] = []
+        for block in self.blocks:
+            out.extend(block.trace_insts())
+        return out
@@ -14,11 +14,19 @@ This is a conservative extension for the current bounded-path pipeline:
 
 This follows the project feedback heuristic: prove publicness on the first
 iteration and propagate that fact to later iterations.
+
+When the CFG carries loop records (-public-data-loops), their blocks replace
+the SCC heuristic, and analyze_loop_accesses decides in-loop loads and
+stores in closed form: an affine address {start,+,step} is public in every
+iteration exactly when start and step are, and a loop-invariant address
+when its operands are, both evaluated once on paths entering the loop
+header. That needs no unrolled paths, so it works with MaxLoopIters=0.
 """
 
 from dataclasses import dataclass
 from typing import Dict, Iterable, List, Optional, Sequence, Set, Tuple
 
+from .models import LoopAccess
 from .pipeline import FunctionPipeline, PathBundle
 from .symexec import SymExecEngine
 
@@ -42,6 +50,19 @@ class LoopInvariantRecord:
     first_iter_paths: int
 
 
+@dataclass(frozen=True)
+class LoopAccessRecord:
+    fn: str
+    loop_id: int
+    pp: str
+    addr: str
+    form: Optional[str]
+    public: Optional[bool]
+    operands: Tuple[str, ...]
+    trip_count: Optional[int]
+    entry_paths: int
+
+
 @dataclass(frozen=True)
 class LoopSlice:
     loop: LoopInfo
@@ -116,6 +137,16 @@ def _compute_sccs(pipe: FunctionPipeline) -> List[LoopInfo]:
     return loops
 
 
+def _function_loops(pipe: FunctionPipeline) -> List[LoopInfo]:
+    """Loops from the pass's loop records, else the SCC heuristic."""
+    if pipe.loops:
+        return [
+            LoopInfo(fn=pipe.fn, loop_id=lp.loop_id, blocks=frozenset(lp.blocks))
+            for lp in pipe.loops
+        ]
+    return _compute_sccs(pipe)
+
+
 def _block_from_pp(pp: str) -> str:
     """Extract the basic-block label from a pp of the form fn:bb:iN."""
     _fn, bb, _idx = pp.rsplit(":", 2)
@@ -142,13 +173,16 @@ def _find_first_loop_repeat(path_bbs: Sequence[str], loop: LoopInfo) -> Optional
     return None
 
 
-def _build_slice(pipe: FunctionPipeline, bundle: PathBundle, loop: LoopInfo) -> Optional[LoopSlice]:
-    repeat_idx = _find_first_loop_repeat(bundle.path.bbs, loop)
-    if repeat_idx is None or bundle.path.path_id is None:
-        return None
-
-    prefix_bbs = tuple(bundle.path.bbs[:repeat_idx])
-    if not prefix_bbs:
+def _prefix_slice(
+    pipe: FunctionPipeline,
+    bundle: PathBundle,
+    loop: LoopInfo,
+    end: int,
+) -> Optional[LoopSlice]:
+    """Slice of bundle's path covering bbs[:end], with the decisions taken
+    before its last block."""
+    prefix_bbs = tuple(bundle.path.bbs[:end])
+    if not prefix_bbs or bundle.path.path_id is None:
         return None
 
     insts = []
@@ -178,9 +212,16 @@ def _build_slice(pipe: FunctionPipeline, bundle: PathBundle, loop: LoopInfo) ->
     )
 
 
+def _build_slice(pipe: FunctionPipeline, bundle: PathBundle, loop: LoopInfo) -> Optional[LoopSlice]:
+    repeat_idx = _find_first_loop_repeat(bundle.path.bbs, loop)
+    if repeat_idx is None:
+        return None
+    return _prefix_slice(pipe, bundle, loop, repeat_idx)
+
+
 def extract_loop_slices(pipe: FunctionPipeline) -> List[LoopSlice]:
     """Return first-iteration loop prefixes for all loop-containing paths."""
-    loops = _compute_sccs(pipe)
+    loops = _function_loops(pipe)
     out: List[LoopSlice] = []
     for bundle in pipe.paths:
         for loop in loops:
@@ -246,3 +287,106 @@ def analyze_loop_invariants(
             )
         )
     return out
+
+
+def _scev_leaves(node: Optional[dict]) -> List[str]:
+    """Value ids at the leaves of a SCEV tree, or ["?"] for opaque nodes."""
+    if node is None:
+        return []
+    if "value" in node:
+        return [node["value"]]
+    if node.get("op") == "other":
+        return ["?"]
+    out: List[str] = []
+    for op in node.get("ops", []):
+        out.extend(_scev_leaves(op))
+    return out
+
+
+def _access_operands(acc: LoopAccess) -> Tuple[Optional[str], Tuple[str, ...]]:
+    """Closed form of an access address and the values it is built from."""
+    if acc.invariant:
+        return "invariant", tuple(dict.fromkeys(_scev_leaves(acc.scev)))
+    if acc.affine:
+        leaves = _scev_leaves(acc.start) + _scev_leaves(acc.step)
+        return "affine", tuple(dict.fromkeys(leaves))
+    return None, ()
+
+
+def _combine(vals: Iterable[Optional[bool]]) -> Optional[bool]:
+    vals = list(vals)
+    if any(v is False for v in vals):
+        return False
+    if any(v is None for v in vals):
+        return None
+    return True
+
+
+def analyze_loop_accesses(
+    pipe: FunctionPipeline,
+    engine: Optional[SymExecEngine] = None,
+) -> List[LoopAccessRecord]:
+    """Decide in-loop loads and stores from loop records in closed form.
+
+    Each path reaching a loop header is executed up to that header and the
+    access's address operands are queried there; the publicness of an
+    access combines them over all entries (constants are public, operands
+    no entry prefix touches are unknown). Accesses with neither an affine nor an
+    invariant address get public=None and form=None.
+    """
+    if not pipe.loops:
+        return []
+    if engine is None:
+        engine = SymExecEngine()
+
+    out: List[LoopAccessRecord] = []
+    for lp in pipe.loops:
+        if not lp.accesses:
+            continue
+        info = LoopInfo(fn=pipe.fn, loop_id=lp.loop_id, blocks=frozenset(lp.blocks))
+        shapes = [_access_operands(acc) for acc in lp.accesses]
+        wanted = sorted(
+            {v for _form, ops in shapes for v in ops if not v.startswith("const:")}
+        )
+        entry_facts: Dict[str, List[Optional[bool]]] = {}
+        entries = 0
+        for bundle in pipe.paths:
+            if lp.header not in bundle.path.bbs:
+                continue
+            end = list(bundle.path.bbs).index(lp.header) + 1
+            sl = _prefix_slice(pipe, bundle, info, end)
+            if sl is None:
+                continue
+            entries += 1
+            facts = engine.analyze_values(
+                insts=sl.insts,
+                path_conditions=sl.path_cond,
+                path_conditions_json=sl.path_cond_json,
+                values=wanted,
+            )
+            for value, public in facts.items():
+                entry_facts.setdefault(value, []).append(public)
+
+        def operand_public(value: str) -> Optional[bool]:
+            if value.startswith("const:"):
+                return True
+            return _combine(entry_facts.get(value, [None]))
+
+        for acc, (form, operands) in zip(lp.accesses, shapes):
+            public: Optional[bool] = None
+            if form is not None and entries > 0:
+                public = _combine(operand_public(v) for v in operands)
+            out.append(
+                LoopAccessRecord(
+                    fn=pipe.fn,
+                    loop_id=lp.loop_id,
+                    pp=acc.pp,
+                    addr=acc.addr,
+                    form=form,
+                    public=public,
+                    operands=operands,
+                    trip_count=lp.trip_count,
+                    entry_paths=entries,
+                )
+            )
+    return out
@@ -6,7 +6,7 @@ import argparse
 import csv
 from typing import Dict
 
-from .parser import load_cfg, load_func_summary
+from .parser import load_cfg, load_func_summary, load_perf
 
 
 def main() -> int:
@@ -20,6 +20,7 @@ def main() -> int:
 
     _blocks, _edges, _paths, summaries, _pp_cov = load_cfg(args.cfg)
     func_summaries = load_func_summary(args.cfg)
+    perf = load_perf(args.cfg)
 
     by_fn: Dict[str, dict] = {}
     for s in summaries:
@@ -38,14 +39,26 @@ def main() -> int:
             "max_loop_iters": s.max_loop_iters,
             "cutoff_depth": s.cutoff_depth,
             "cutoff_loop": s.cutoff_loop,
+            "cutoff_time": s.cutoff_time,
+            "cutoff_mem": s.cutoff_mem,
             "const_pruned_br": s.const_pruned_br,
             "const_pruned_switch": s.const_pruned_switch,
             "const_pruned_indirect": s.const_pruned_indirect,
+            "corr_pruned_br": s.corr_pruned_br,
+            "corr_pruned_switch": s.corr_pruned_switch,
+            "range_pruned": s.range_pruned,
+            "range_implied": s.range_implied,
+            "range_restored": s.range_restored,
+            "range_uncovered": s.range_uncovered,
             "dfs_calls": s.dfs_calls,
             "dfs_leaves": s.dfs_leaves,
             "dfs_prune_max_paths": s.dfs_prune_max_paths,
             "dfs_prune_max_depth": s.dfs_prune_max_depth,
             "dfs_prune_loop": s.dfs_prune_loop,
+            "path_count_exact": s.path_count_exact,
+            "path_count_saturated": s.path_count_saturated,
+            "path_count_bound": s.path_count_bound,
+            "path_classes": s.path_classes,
         }
 
     for f in func_summaries:
@@ -60,14 +73,26 @@ def main() -> int:
                 "max_loop_iters": None,
                 "cutoff_depth": None,
                 "cutoff_loop": None,
+                "cutoff_time": None,
+                "cutoff_mem": None,
                 "const_pruned_br": None,
                 "const_pruned_switch": None,
                 "const_pruned_indirect": None,
+                "corr_pruned_br": None,
+                "corr_pruned_switch": None,
+                "range_pruned": None,
+                "range_implied": None,
+                "range_restored": None,
+                "range_uncovered": None,
                 "dfs_calls": None,
                 "dfs_leaves": None,
                 "dfs_prune_max_paths": None,
                 "dfs_prune_max_depth": None,
                 "dfs_prune_loop": None,
+                "path_count_exact": None,
+                "path_count_saturated": None,
+                "path_count_bound": None,
+                "path_classes": None,
             },
         )
         by_fn[f.fn].update(
@@ -81,6 +106,33 @@ def main() -> int:
             }
         )
 
+    # Perf columns are added only when the pass ran with -public-data-perf.
+    perf_fields = [
+        "total_ns",
+        "analyses_ns",
+        "ids_ns",
+        "trace_ns",
+        "cfg_ns",
+        "path_tables_ns",
+        "path_count_ns",
+        "paths_ns",
+        "pp_coverage_ns",
+        "trace_bytes",
+        "trace_index_bytes",
+        "cfg_bytes",
+        "coverage_ranges_peak",
+        "value_ids_peak",
+    ]
+    for p in perf:
+        row = by_fn.setdefault(p.fn, {"fn": p.fn})
+        row["total_ns"] = p.total_ns
+        for phase, ns in p.phase_ns.items():
+            row[f"{phase}_ns"] = ns
+        for stream, nbytes in p.stream_bytes.items():
+            row[f"{stream}_bytes"] = nbytes
+        row["coverage_ranges_peak"] = p.coverage_ranges
+        row["value_ids_peak"] = p.value_ids_peak
+
     with open(args.out, "w", newline="", encoding="utf-8") as f:
         fieldnames = [
             "fn",
@@ -97,16 +149,30 @@ def main() -> int:
             "max_loop_iters",
             "cutoff_depth",
             "cutoff_loop",
+        "cutoff_time",
+        "cutoff_mem",
             "const_pruned_br",
             "const_pruned_switch",
             "const_pruned_indirect",
+            "corr_pruned_br",
+            "corr_pruned_switch",
+            "range_pruned",
+            "range_implied",
+            "range_restored",
+            "range_uncovered",
             "dfs_calls",
             "dfs_leaves",
             "dfs_prune_max_paths",
             "dfs_prune_max_depth",
             "dfs_prune_loop",
+            "path_count_exact",
+            "path_count_saturated",
+            "path_count_bound",
+            "path_classes",
         ]
-        writer = csv.DictWriter(f, fieldnames=fieldnames)
+        if perf:
+            fieldnames += perf_fields
+        writer = csv.DictWriter(f, fieldnames=fieldnames, extrasaction="ignore")
         writer.writeheader()
         for fn in sorted(by_fn.keys()):
             writer.writerow(by_fn[fn])
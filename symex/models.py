@@ -6,8 +6,9 @@ These models define the input/output contracts between the LLVM pass (Person A)
 and the Python analysis pipeline (Person B).
 """
 
+import bisect
 from dataclasses import dataclass
-from typing import Optional, Sequence
+from typing import Dict, Iterator, Optional, Sequence, Tuple, Union, overload
 
 
 @dataclass(frozen=True)
@@ -15,6 +16,9 @@ class TxInfo:
     """Transmitter metadata for an instruction."""
     kind: str
     which: int
+    # "equal" when the pass proved the operand identical across executions
+    # (-public-data-static-public).
+    static: Optional[str] = None
 
 
 @dataclass(frozen=True)
@@ -35,6 +39,15 @@ class TraceInst:
     callee: Optional[str]
     extract_indices: Optional[Sequence[int]]
     insert_indices: Optional[Sequence[int]]
+    # With -public-data-mem-ssa: must-alias class of the accessed location,
+    # pp of the clobbering MemoryDef (None for live-on-entry memory or a
+    # MemoryPhi, whose block is then mem_phi).
+    mem_class: Optional[int] = None
+    mem_def: Optional[str] = None
+    mem_phi: Optional[str] = None
+    # "equal" when the pass proved the def identical across executions
+    # (-public-data-static-public).
+    def_static: Optional[str] = None
 
     @property
     def tx(self) -> Optional[TxInfo]:
@@ -66,6 +79,103 @@ class FuncSummary:
     arg_ids: Sequence[str]
 
 
+@dataclass(frozen=True)
+class CalleeSummary:
+    """Bottom-up interprocedural summary (-public-data-callee-summaries).
+
+    Argument sets hold argument numbers. arg_tx_must arguments are a
+    transmitter operand themselves on every returning execution; arg_ret
+    arguments reach the return value, which additionally depends on memory
+    when ret_reads_mem is set.
+    """
+    fn: str
+    scc: int
+    recursive: bool
+    arg_tx: Sequence[int]
+    arg_tx_must: Sequence[int]
+    arg_ret: Sequence[int]
+    ret_reads_mem: bool
+    reads_args: Sequence[int]
+    writes_args: Sequence[int]
+    reads_other: bool
+    writes_other: bool
+    mem_reads: Optional[Sequence[int]] = None
+    mem_writes: Optional[Sequence[int]] = None
+
+
+@dataclass(frozen=True)
+class PerfRecord:
+    """Per-function pass cost (-public-data-perf).
+
+    phase_ns maps phase name to nanoseconds; stream_bytes maps stream name
+    to bytes written, None when that stream was not requested.
+    """
+    fn: str
+    total_ns: int
+    phase_ns: Dict[str, int]
+    stream_bytes: Dict[str, Optional[int]]
+    coverage_blocks: int
+    coverage_ranges: int
+    value_ids_peak: int
+    symtab_values: Optional[int] = None
+
+
+@dataclass(frozen=True)
+class CacheEntry:
+    """Function cache manifest entry (-public-data-cache-manifest).
+
+    key hashes everything the function's records depend on, so equal keys
+    mean equal trace/CFG records and reusable analysis results.
+    """
+    fn: str
+    key: str
+    hit: bool
+
+
+@dataclass(frozen=True)
+class ShardFunction:
+    """One function's entry in a shard manifest (-public-data-shard-dir)."""
+    fn: str
+    inst_count: int
+    paths: int
+    stream_bytes: Dict[str, int]
+
+    @property
+    def cost(self) -> int:
+        """Estimated symexec cost: every emitted path replays the function."""
+        return self.inst_count * max(1, self.paths)
+
+
+@dataclass(frozen=True)
+class Shard:
+    """One shard's trace/trace index/CFG files (absolute paths) and functions."""
+    shard: int
+    trace: str
+    trace_index: str
+    cfg: str
+    fns: Sequence[ShardFunction]
+    stream_bytes: Dict[str, int]
+
+    @property
+    def cost(self) -> int:
+        return sum(f.cost for f in self.fns)
+
+
+@dataclass(frozen=True)
+class ShmFunction:
+    """One function read from a -public-data-shm ring (see symex/shm.py).
+
+    trace, trace_index and cfg hold the function's records as the pass
+    writes them to files (a columnar trace is a complete one-block file),
+    so the parser's loaders accept them in place of paths.
+    """
+    module: str
+    fn: str
+    trace: bytes
+    trace_index: bytes
+    cfg: bytes
+
+
 @dataclass(frozen=True)
 class CfgBlock:
     """Basic block record from CFG NDJSON."""
@@ -116,6 +226,186 @@ class CfgPath:
     path_cond: Sequence[str]
     path_cond_json: Sequence[dict]
     pp_seq: Sequence[str]
+    leaf_node: Optional[int] = None
+    # With -public-data-dedup-paths: path ids this record stands for.
+    class_size: Optional[int] = None
+    members: Optional[Sequence[int]] = None
+    # With -public-data-path-slice: pps the path's transmitters depend on.
+    slice_pps: Optional[Sequence[str]] = None
+
+
+@dataclass(frozen=True)
+class CfgRegion:
+    """Single-entry/single-exit region (-public-data-path-mode=region)."""
+    fn: str
+    region_id: int
+    parent: Optional[int]
+    depth: int
+    entry: str
+    exit: Optional[str]
+    bbs: Sequence[str]
+    subregions: Sequence[int]
+
+
+@dataclass(frozen=True)
+class LoopAccess:
+    """In-loop load or store from a loop record.
+
+    SCEV fields are trees of {"value": id} leaves and
+    {"op": name, "ops": [...]} nodes (addrecs also carry "loop": header).
+    """
+    pp: str
+    op: str
+    addr: str
+    scev: dict
+    invariant: bool
+    affine: bool
+    start: Optional[dict] = None
+    step: Optional[dict] = None
+
+
+@dataclass(frozen=True)
+class CfgLoop:
+    """Natural loop with ScalarEvolution facts (-public-data-loops)."""
+    fn: str
+    loop_id: int
+    parent: Optional[int]
+    depth: int
+    header: str
+    latches: Sequence[str]
+    exiting: Sequence[str]
+    exits: Sequence[str]
+    blocks: Sequence[str]
+    indvar: Optional[str]
+    indvar_start: Optional[dict]
+    indvar_step: Optional[dict]
+    trip_count: Optional[int]
+    backedge_taken: Optional[dict]
+    accesses: Sequence[LoopAccess]
+
+
+@dataclass(frozen=True)
+class SegmentElem:
+    """One step of a segment: a block of the region or a whole child region."""
+    bb: Optional[str] = None
+    region: Optional[int] = None
+
+
+@dataclass(frozen=True)
+class CfgSegment:
+    """Path through one region, from its entry to its exit or a return."""
+    fn: str
+    region_id: int
+    segment_id: int
+    elems: Sequence[SegmentElem]
+    decisions: Sequence[PathDecision]
+    path_cond: Sequence[str]
+    path_cond_json: Sequence[dict]
+    reaches_exit: bool
+
+
+@dataclass(frozen=True)
+class PathNode:
+    """Prefix-trie node from CFG NDJSON (-public-data-path-encoding=trie).
+
+    Each node adds one block to its parent's prefix, plus the decision taken
+    on the edge into that block (None for unconditional edges and the root).
+    """
+    fn: str
+    node_id: int
+    parent: Optional[int]
+    depth: int
+    bb: str
+    decision: Optional[PathDecision]
+    path_cond: Optional[str]
+    path_cond_json: Optional[dict]
+    pp_seq: Sequence[str]
+
+
+class PathIdRanges(Sequence[int]):
+    """Sorted path ids stored as inclusive (first, last) runs.
+
+    block_coverage records carry their path ids in this form; it behaves as
+    a read-only sequence of ints without expanding the runs.
+    """
+
+    def __init__(self, ranges: Sequence[Sequence[int]]) -> None:
+        self.ranges: Tuple[Tuple[int, int], ...] = tuple(
+            (int(r[0]), int(r[1])) for r in ranges
+        )
+        self._starts = [r[0] for r in self.ranges]
+        # Number of ids before each run, for indexing.
+        self._offsets = []
+        total = 0
+        for first, last in self.ranges:
+            self._offsets.append(total)
+            total += last - first + 1
+        self._len = total
+
+    def __len__(self) -> int:
+        return self._len
+
+    def __iter__(self) -> Iterator[int]:
+        for first, last in self.ranges:
+            yield from range(first, last + 1)
+
+    def __contains__(self, pid: object) -> bool:
+        if not isinstance(pid, int):
+            return False
+        k = bisect.bisect_right(self._starts, pid) - 1
+        return k >= 0 and pid <= self.ranges[k][1]
+
+    @overload
+    def __getitem__(self, i: int) -> int: ...
+
+    @overload
+    def __getitem__(self, i: slice) -> Sequence[int]: ...
+
+    def __getitem__(self, i: Union[int, slice]) -> Union[int, Sequence[int]]:
+        if isinstance(i, slice):
+            return list(self)[i]
+        if i < 0:
+            i += self._len
+        if not 0 <= i < self._len:
+            raise IndexError(i)
+        k = bisect.bisect_right(self._offsets, i) - 1
+        return self.ranges[k][0] + (i - self._offsets[k])
+
+    def intersection(self, other: "PathIdRanges") -> "PathIdRanges":
+        """Ids in both, computed run by run."""
+        out = []
+        a, b = 0, 0
+        while a < len(self.ranges) and b < len(other.ranges):
+            lo = max(self.ranges[a][0], other.ranges[b][0])
+            hi = min(self.ranges[a][1], other.ranges[b][1])
+            if lo <= hi:
+                out.append((lo, hi))
+            if self.ranges[a][1] < other.ranges[b][1]:
+                a += 1
+            else:
+                b += 1
+        return PathIdRanges(out)
+
+    def __eq__(self, other: object) -> bool:
+        if isinstance(other, PathIdRanges):
+            return self.ranges == other.ranges
+        return NotImplemented
+
+    def __hash__(self) -> int:
+        return hash(self.ranges)
+
+    def __repr__(self) -> str:
+        return f"PathIdRanges({list(self.ranges)!r})"
+
+
+@dataclass(frozen=True)
+class BlockCoverage:
+    """Block coverage record (block -> path id ranges)."""
+    fn: str
+    bb: str
+    pps: int
+    path_count: int
+    path_ids: PathIdRanges
 
 
 @dataclass(frozen=True)
@@ -143,8 +433,20 @@ class PathSummary:
     const_pruned_br: Optional[int]
     const_pruned_switch: Optional[int]
     const_pruned_indirect: Optional[int]
+    corr_pruned_br: Optional[int]
+    corr_pruned_switch: Optional[int]
     dfs_calls: Optional[int]
     dfs_leaves: Optional[int]
     dfs_prune_max_paths: Optional[int]
     dfs_prune_max_depth: Optional[int]
     dfs_prune_loop: Optional[int]
+    path_count_exact: Optional[int] = None
+    path_count_saturated: Optional[bool] = None
+    path_count_bound: Optional[bool] = None
+    path_classes: Optional[int] = None
+    cutoff_time: Optional[bool] = None
+    cutoff_mem: Optional[bool] = None
+    range_pruned: Optional[int] = None
+    range_implied: Optional[int] = None
+    range_restored: Optional[int] = None
+    range_uncovered: Optional[int] = None
@@ -2,33 +2,99 @@ from __future__ import annotations
 
 """NDJSON parsers for trace and CFG artifacts."""
 
+import contextlib
+import io
 import json
+import os
+import subprocess
 from dataclasses import dataclass
-from typing import Dict, Iterable, List, Tuple
+from typing import IO, Dict, Iterable, Iterator, List, Tuple, Union
 
 from .models import (
+    CacheEntry,
+    CalleeSummary,
     CfgBlock,
     CfgEdge,
+    CfgLoop,
     CfgPath,
+    CfgRegion,
+    CfgSegment,
+    BlockCoverage,
+    Shard,
+    ShardFunction,
     PathDecision,
+    PathIdRanges,
+    PathNode,
     PathSummary,
+    PerfRecord,
     PpCoverage,
+    SegmentElem,
     TraceIndex,
     FuncSummary,
+    LoopAccess,
     TraceInst,
     TxInfo,
 )
 
 
+_ZSTD_MAGIC = b"\x28\xb5\x2f\xfd"
+
+# A pass output: a file path, or its contents in memory.
+Source = Union[str, bytes, bytearray, memoryview]
+
+
+@contextlib.contextmanager
+def open_output(path: Source, offset: int = 0) -> Iterator[IO[bytes]]:
+    """Open a pass output file as a binary stream starting at offset.
+
+    Files written with -public-data-compress=zstd are decompressed
+    transparently (python-zstandard if installed, else the zstd CLI); offset
+    is then a compressed frame offset, e.g. from the binary trace index.
+    path may also be the records themselves as bytes (e.g. a ShmFunction's).
+    """
+    if isinstance(path, (bytes, bytearray, memoryview)):
+        f = io.BytesIO(path)
+        f.seek(offset)
+        yield f
+        return
+    f = open(path, "rb")
+    try:
+        f.seek(offset)
+        compressed = f.read(4) == _ZSTD_MAGIC
+        f.seek(offset)
+        if not compressed:
+            yield f
+            return
+        try:
+            import zstandard
+        except ImportError:
+            zstandard = None
+        if zstandard is not None:
+            reader = zstandard.ZstdDecompressor().stream_reader(f, read_across_frames=True)
+            yield io.BufferedReader(reader)
+            return
+        os.lseek(f.fileno(), offset, os.SEEK_SET)
+        proc = subprocess.Popen(["zstd", "-dcq"], stdin=f, stdout=subprocess.PIPE)
+        try:
+            yield proc.stdout
+        finally:
+            proc.stdout.close()
+            if proc.poll() is None:
+                proc.kill()
+            proc.wait()
+    finally:
+        f.close()
+
+
 def read_ndjson(path: str) -> Iterable[dict]:
     """Yield JSON objects from an NDJSON file.
 
     Inputs:
-    - path: filesystem path to NDJSON.
+    - path: filesystem path to NDJSON (optionally zstd-compressed).
     Output:
     - Iterator of dicts, one per non-empty line.
     """
-    with open(path, "r", encoding="utf-8") as f:
+    with open_output(path) as f:
         for line in f:
             line = line.strip()
             if not line:
@@ -36,42 +102,226 @@ def read_ndjson(path: str) -> Iterable[dict]:
             yield json.loads(line)
 
 
-def load_trace(path: str) -> List[TraceInst]:
-    """Load TraceInst records from a trace NDJSON file."""
-    insts: List[TraceInst] = []
-    for rec in read_ndjson(path):
-        txs: List[TxInfo] = []
-        if "txs" in rec and rec["txs"] is not None:
-            for tx_rec in rec["txs"]:
-                txs.append(TxInfo(kind=tx_rec["kind"], which=int(tx_rec["which"])))
-        elif "tx" in rec and rec["tx"] is not None:
-            txs.append(TxInfo(kind=rec["tx"]["kind"], which=int(rec["tx"]["which"])))
-        insts.append(
-            TraceInst(
-                fn=rec["fn"],
-                bb=rec["bb"],
-                pp=rec["pp"],
-                op=rec["op"],
-                def_id=rec.get("def"),
-                uses=list(rec.get("uses", [])),
-                txs=txs,
-                def_ty=rec.get("def_ty"),
-                use_tys=rec.get("use_tys"),
-                icmp_pred=rec.get("icmp_pred"),
-                fcmp_pred=rec.get("fcmp_pred"),
-                atomic_op=rec.get("atomic_op"),
-                callee=rec.get("callee"),
-                extract_indices=rec.get("extract_indices"),
-                insert_indices=rec.get("insert_indices"),
-            )
+# Newest schema record version understood per stream (the pass stamps one
+# at the start of each NDJSON file; TRACE_SCHEMA.md, CFG_SCHEMA.md).
+SCHEMA_VERSIONS: Dict[str, int] = {
+    "trace": 1,
+    "trace_index": 1,
+    "cfg": 1,
+    "cache_manifest": 1,
+    "shard_manifest": 1,
+}
+
+# Integer-valued fields per record kind when the pass runs with
+# -public-data-intern-ids, keyed to the symtab table that resolves them.
+_INTERNED_FIELDS: Dict[str | None, Dict[str, str]] = {
+    None: {
+        "bb": "bbs",
+        "pp": "pps",
+        "def": "values",
+        "uses": "values",
+        "mem_def": "pps",
+        "mem_phi": "bbs",
+    },
+    "trace_index": {"bb": "bbs", "pp": "pps", "def": "values"},
+    "func_summary": {"arg_ids": "values"},
+    "block": {
+        "bb": "bbs",
+        "succs": "bbs",
+        "term_pp": "pps",
+        "cond": "values",
+        "target": "values",
+    },
+    "edge": {
+        "from": "bbs",
+        "to": "bbs",
+        "term_pp": "pps",
+        "cond": "values",
+        "case": "values",
+        "target": "values",
+    },
+    "path": {"bbs": "bbs", "pp_seq": "pps", "slice_pps": "pps"},
+    "path_node": {"bb": "bbs", "pp_seq": "pps"},
+    "pp_coverage": {"pp": "pps"},
+    "block_coverage": {"bb": "bbs"},
+    "region": {"entry": "bbs", "exit": "bbs", "bbs": "bbs"},
+    "loop": {
+        "header": "bbs",
+        "latches": "bbs",
+        "exiting": "bbs",
+        "exits": "bbs",
+        "blocks": "bbs",
+        "indvar": "values",
+    },
+}
+
+_LOOP_SCEV_FIELDS = ("indvar_start", "indvar_step", "backedge_taken")
+_ACCESS_SCEV_FIELDS = ("scev", "start", "step")
+
+_DECISION_FIELDS: Dict[str, str] = {
+    "pp": "pps",
+    "succ": "bbs",
+    "cond": "values",
+    "case": "values",
+    "target": "values",
+}
+
+
+def _resolve_ids(rec: dict, fields: Dict[str, str], symtab: dict) -> None:
+    for key, table_name in fields.items():
+        val = rec.get(key)
+        table = symtab[table_name]
+        if isinstance(val, int) and not isinstance(val, bool):
+            rec[key] = table[val]
+        elif isinstance(val, list):
+            rec[key] = [table[v] if isinstance(v, int) else v for v in val]
+
+
+def read_records(path: str) -> Iterable[dict]:
+    """Yield pass records with interned ids resolved back to strings.
+
+    Inputs:
+    - path: trace, trace index, or CFG NDJSON file.
+    Output:
+    - Iterator of dicts shaped as if the pass ran without
+      -public-data-intern-ids or -public-data-cond-table. schema, symtab and
+      cond records are consumed, not yielded. A columnar trace
+      (-public-data-trace-format=columnar) yields the same dicts.
+    """
+    from .columnar import ColumnarTrace, is_columnar
+
+    if is_columnar(path):
+        return ColumnarTrace.open(path).records()
+    return resolve_records(read_ndjson(path))
+
+
+def _expand_conds(rec: dict, conds: Dict[Tuple[str, int], dict]) -> None:
+    """Replace a path/segment's cond ids with the cond table's fields."""
+    entries = [conds[(rec["fn"], cid)] for cid in rec.pop("conds")]
+    rec["decisions"] = [c["decision"] for c in entries]
+    if any("path_cond" in c for c in entries):
+        rec["path_cond"] = [c["path_cond"] for c in entries]
+    if any("path_cond_json" in c for c in entries):
+        rec["path_cond_json"] = [c["path_cond_json"] for c in entries]
+
+
+def check_schema(rec: dict) -> None:
+    """Reject a stream whose schema record is newer than this parser."""
+    stream = rec.get("stream")
+    version = int(rec.get("version", 0))
+    supported = SCHEMA_VERSIONS.get(stream)
+    if supported is not None and version > supported:
+        raise ValueError(
+            f"{stream} schema version {version} is newer than supported "
+            f"version {supported}; update symex"
         )
-    return insts
+
+
+def resolve_records(records: Iterable[dict]) -> Iterable[dict]:
+    """Resolve interned ids in already-decoded records (see read_records)."""
+    symtabs: Dict[str, dict] = {}
+    conds: Dict[Tuple[str, int], dict] = {}
+    for rec in records:
+        kind = rec.get("kind")
+        if kind == "schema":
+            check_schema(rec)
+            continue
+        if kind == "symtab":
+            symtabs[rec["fn"]] = rec
+            continue
+        symtab = symtabs.get(rec.get("fn", ""))
+        if kind == "cond":
+            if symtab is not None:
+                _resolve_ids(rec["decision"], _DECISION_FIELDS, symtab)
+            conds[(rec["fn"], rec["cond_id"])] = rec
+            continue
+        if kind in ("path", "segment") and "conds" in rec:
+            # Table decisions are already resolved.
+            _expand_conds(rec, conds)
+            symtab_decisions = False
+        else:
+            symtab_decisions = True
+        fields = _INTERNED_FIELDS.get(kind, {} if kind == "segment" else None)
+        if symtab is None or fields is None:
+            yield rec
+            continue
+        _resolve_ids(rec, fields, symtab)
+        if kind == "path" and symtab_decisions:
+            for dec in rec.get("decisions", []):
+                _resolve_ids(dec, _DECISION_FIELDS, symtab)
+        elif kind == "path_node" and rec.get("decision") is not None:
+            _resolve_ids(rec["decision"], _DECISION_FIELDS, symtab)
+        elif kind == "segment":
+            for elem in rec.get("elems", []):
+                _resolve_ids(elem, {"bb": "bbs"}, symtab)
+            if symtab_decisions:
+                for dec in rec.get("decisions", []):
+                    _resolve_ids(dec, _DECISION_FIELDS, symtab)
+        elif kind == "loop":
+            for key in _LOOP_SCEV_FIELDS:
+                _resolve_scev(rec.get(key), symtab)
+            for acc in rec.get("accesses", []):
+                _resolve_ids(acc, {"pp": "pps", "addr": "values"}, symtab)
+                for key in _ACCESS_SCEV_FIELDS:
+                    _resolve_scev(acc.get(key), symtab)
+        yield rec
+
+
+def _resolve_scev(node: object, symtab: dict) -> None:
+    if not isinstance(node, dict):
+        return
+    _resolve_ids(node, {"value": "values", "loop": "bbs"}, symtab)
+    for op in node.get("ops", []):
+        _resolve_scev(op, symtab)
+
+
+def parse_trace_inst(rec: dict) -> TraceInst:
+    """Build a TraceInst from one resolved trace record."""
+    txs: List[TxInfo] = []
+    if "txs" in rec and rec["txs"] is not None:
+        for tx_rec in rec["txs"]:
+            txs.append(
+                TxInfo(kind=tx_rec["kind"], which=int(tx_rec["which"]), static=tx_rec.get("static"))
+            )
+    elif "tx" in rec and rec["tx"] is not None:
+        tx_rec = rec["tx"]
+        txs.append(TxInfo(kind=tx_rec["kind"], which=int(tx_rec["which"]), static=tx_rec.get("static")))
+    return TraceInst(
+        fn=rec["fn"],
+        bb=rec["bb"],
+        pp=rec["pp"],
+        op=rec["op"],
+        def_id=rec.get("def"),
+        uses=list(rec.get("uses", [])),
+        txs=txs,
+        def_ty=rec.get("def_ty"),
+        use_tys=rec.get("use_tys"),
+        icmp_pred=rec.get("icmp_pred"),
+        fcmp_pred=rec.get("fcmp_pred"),
+        atomic_op=rec.get("atomic_op"),
+        callee=rec.get("callee"),
+        extract_indices=rec.get("extract_indices"),
+        insert_indices=rec.get("insert_indices"),
+        mem_class=rec.get("mem_class"),
+        mem_def=rec.get("mem_def"),
+        mem_phi=rec.get("mem_phi"),
+        def_static=rec.get("def_static"),
+    )
+
+
+def load_trace(path: str) -> List[TraceInst]:
+    """Load TraceInst records from a trace NDJSON or columnar file."""
+    from .columnar import ColumnarTrace, is_columnar
+
+    if is_columnar(path):
+        return ColumnarTrace.open(path).trace_insts()
+    return [parse_trace_inst(rec) for rec in read_records(path)]
 
 
 def load_trace_index(path: str) -> List[TraceIndex]:
     """Load TraceIndex records from a trace index NDJSON file."""
     out: List[TraceIndex] = []
-    for rec in read_ndjson(path):
+    for rec in read_records(path):
         if rec.get("kind") != "trace_index":
             continue
         out.append(
@@ -90,7 +340,7 @@ def load_trace_index(path: str) -> List[TraceIndex]:
 def load_func_summary(path: str) -> List[FuncSummary]:
     """Load FuncSummary records from a CFG NDJSON file."""
     out: List[FuncSummary] = []
-    for rec in read_ndjson(path):
+    for rec in read_records(path):
         if rec.get("kind") != "func_summary":
             continue
         out.append(
@@ -108,19 +358,420 @@ def load_func_summary(path: str) -> List[FuncSummary]:
     return out
 
 
+def load_callee_summaries(path: str) -> List[CalleeSummary]:
+    """Load callee_summary records (-public-data-callee-summaries) from a CFG NDJSON file."""
+    out: List[CalleeSummary] = []
+    for rec in read_records(path):
+        if rec.get("kind") != "callee_summary":
+            continue
+        out.append(
+            CalleeSummary(
+                fn=rec["fn"],
+                scc=int(rec.get("scc", 0)),
+                recursive=bool(rec.get("recursive", False)),
+                arg_tx=list(rec.get("arg_tx", [])),
+                arg_tx_must=list(rec.get("arg_tx_must", [])),
+                arg_ret=list(rec.get("arg_ret", [])),
+                ret_reads_mem=bool(rec.get("ret_reads_mem", True)),
+                reads_args=list(rec.get("reads_args", [])),
+                writes_args=list(rec.get("writes_args", [])),
+                reads_other=bool(rec.get("reads_other", True)),
+                writes_other=bool(rec.get("writes_other", True)),
+                mem_reads=rec.get("mem_reads"),
+                mem_writes=rec.get("mem_writes"),
+            )
+        )
+    return out
+
+
+def load_cache_manifest(path: str) -> List[CacheEntry]:
+    """Load cache_entry records from a -public-data-cache-manifest file."""
+    return [
+        CacheEntry(fn=rec["fn"], key=rec["key"], hit=bool(rec.get("hit")))
+        for rec in read_records(path)
+        if rec.get("kind") == "cache_entry"
+    ]
+
+
+def load_shard_manifest(path: str) -> List[Shard]:
+    """Load a -public-data-shard-dir manifest.ndjson.
+
+    Shard file names are resolved against the manifest's directory.
+    """
+    root = os.path.dirname(os.path.abspath(path))
+    shards: List[Shard] = []
+    for rec in read_records(path):
+        if rec.get("kind") != "shard":
+            continue
+        fns = [
+            ShardFunction(
+                fn=f["fn"],
+                inst_count=int(f.get("inst_count", 0)),
+                paths=int(f.get("paths", 0)),
+                stream_bytes={k: int(v) for k, v in f.get("bytes", {}).items()},
+            )
+            for f in rec.get("fns", [])
+        ]
+        shards.append(
+            Shard(
+                shard=int(rec["shard"]),
+                trace=os.path.join(root, rec["trace"]),
+                trace_index=os.path.join(root, rec["trace_index"]),
+                cfg=os.path.join(root, rec["cfg"]),
+                fns=fns,
+                stream_bytes={k: int(v) for k, v in rec.get("bytes", {}).items()},
+            )
+        )
+    return shards
+
+
+def load_perf(path: str) -> List[PerfRecord]:
+    """Load perf records (-public-data-perf) from a CFG NDJSON file."""
+    out: List[PerfRecord] = []
+    for rec in read_records(path):
+        if rec.get("kind") != "perf":
+            continue
+        peak = rec.get("coverage_peak", {})
+        out.append(
+            PerfRecord(
+                fn=rec["fn"],
+                total_ns=int(rec.get("total_ns", 0)),
+                phase_ns={k: int(v) for k, v in rec.get("phase_ns", {}).items()},
+                stream_bytes=dict(rec.get("bytes", {})),
+                coverage_blocks=int(peak.get("blocks", 0)),
+                coverage_ranges=int(peak.get("ranges", 0)),
+                value_ids_peak=int(rec.get("value_ids_peak", 0)),
+                symtab_values=rec.get("symtab_values"),
+            )
+        )
+    return out
+
+
+def _parse_decision(d: dict) -> PathDecision:
+    """Convert a JSON decision object into a PathDecision."""
+    return PathDecision(
+        pp=d["pp"],
+        kind=d["kind"],
+        succ=d["succ"],
+        cond=d.get("cond"),
+        sense=d.get("sense"),
+        case=d.get("case"),
+        is_default=bool(d.get("default", False)),
+        target=d.get("target"),
+    )
+
+
+def _parse_path_node(rec: dict) -> PathNode:
+    """Convert a path_node record into a PathNode."""
+    dec = rec.get("decision")
+    parent = rec.get("parent")
+    return PathNode(
+        fn=rec["fn"],
+        node_id=int(rec["node_id"]),
+        parent=int(parent) if parent is not None else None,
+        depth=int(rec.get("depth", 0)),
+        bb=rec["bb"],
+        decision=_parse_decision(dec) if dec is not None else None,
+        path_cond=rec.get("path_cond"),
+        path_cond_json=rec.get("path_cond_json"),
+        pp_seq=list(rec.get("pp_seq", [])),
+    )
+
+
+def path_node_chain(
+    nodes: Dict[Tuple[str, int], PathNode],
+    fn: str,
+    leaf: int,
+) -> List[PathNode]:
+    """Return the root-to-leaf node chain for a trie-encoded path."""
+    chain: List[PathNode] = []
+    cur: int | None = leaf
+    while cur is not None:
+        node = nodes[(fn, cur)]
+        chain.append(node)
+        cur = node.parent
+    chain.reverse()
+    return chain
+
+
+def _path_from_nodes(
+    rec: dict,
+    nodes: Dict[Tuple[str, int], PathNode],
+) -> CfgPath:
+    """Materialize a trie-encoded path record from its node chain."""
+    fn = rec["fn"]
+    leaf = int(rec["leaf"])
+    bbs: List[str] = []
+    decs: List[PathDecision] = []
+    conds: List[str] = []
+    conds_json: List[dict] = []
+    pp_seq: List[str] = []
+    for node in path_node_chain(nodes, fn, leaf):
+        bbs.append(node.bb)
+        if node.decision is not None:
+            decs.append(node.decision)
+        if node.path_cond is not None:
+            conds.append(node.path_cond)
+        if node.path_cond_json is not None:
+            conds_json.append(node.path_cond_json)
+        pp_seq.extend(node.pp_seq)
+    return CfgPath(
+        fn=fn,
+        path_id=rec.get("path_id"),
+        bbs=bbs,
+        decisions=decs,
+        path_cond=conds,
+        path_cond_json=conds_json,
+        pp_seq=pp_seq,
+        leaf_node=leaf,
+        class_size=rec.get("class_size"),
+        members=rec.get("members"),
+    )
+
+
+def load_path_nodes(path: str) -> List[PathNode]:
+    """Load PathNode records (trie path encoding) from a CFG NDJSON file."""
+    out: List[PathNode] = []
+    for rec in read_records(path):
+        if rec.get("kind") != "path_node":
+            continue
+        out.append(_parse_path_node(rec))
+    return out
+
+
+def _parse_region(rec: dict) -> CfgRegion:
+    """Convert a region record into a CfgRegion."""
+    parent = rec.get("parent")
+    return CfgRegion(
+        fn=rec["fn"],
+        region_id=int(rec["region_id"]),
+        parent=int(parent) if parent is not None else None,
+        depth=int(rec.get("depth", 0)),
+        entry=rec["entry"],
+        exit=rec.get("exit"),
+        bbs=list(rec.get("bbs", [])),
+        subregions=list(rec.get("subregions", [])),
+    )
+
+
+def _parse_segment(rec: dict) -> CfgSegment:
+    """Convert a segment record into a CfgSegment."""
+    return CfgSegment(
+        fn=rec["fn"],
+        region_id=int(rec["region_id"]),
+        segment_id=int(rec["segment_id"]),
+        elems=[SegmentElem(bb=e.get("bb"), region=e.get("region")) for e in rec.get("elems", [])],
+        decisions=[_parse_decision(d) for d in rec.get("decisions", [])],
+        path_cond=list(rec.get("path_cond", [])),
+        path_cond_json=list(rec.get("path_cond_json", [])),
+        reaches_exit=bool(rec.get("reaches_exit", True)),
+    )
+
+
+def load_regions(path: str) -> Tuple[List[CfgRegion], List[CfgSegment]]:
+    """Load region and segment records (region path mode) from a CFG NDJSON file."""
+    regions: List[CfgRegion] = []
+    segments: List[CfgSegment] = []
+    for rec in read_records(path):
+        kind = rec.get("kind")
+        if kind == "region":
+            regions.append(_parse_region(rec))
+        elif kind == "segment":
+            segments.append(_parse_segment(rec))
+    return regions, segments
+
+
+def _parse_loop(rec: dict) -> CfgLoop:
+    """Convert a loop record into a CfgLoop."""
+    parent = rec.get("parent")
+    trip_count = rec.get("trip_count")
+    return CfgLoop(
+        fn=rec["fn"],
+        loop_id=int(rec["loop_id"]),
+        parent=int(parent) if parent is not None else None,
+        depth=int(rec.get("depth", 1)),
+        header=rec["header"],
+        latches=list(rec.get("latches", [])),
+        exiting=list(rec.get("exiting", [])),
+        exits=list(rec.get("exits", [])),
+        blocks=list(rec.get("blocks", [])),
+        indvar=rec.get("indvar"),
+        indvar_start=rec.get("indvar_start"),
+        indvar_step=rec.get("indvar_step"),
+        trip_count=int(trip_count) if trip_count is not None else None,
+        backedge_taken=rec.get("backedge_taken"),
+        accesses=[
+            LoopAccess(
+                pp=a["pp"],
+                op=a["op"],
+                addr=a["addr"],
+                scev=a["scev"],
+                invariant=bool(a.get("invariant", False)),
+                affine=bool(a.get("affine", False)),
+                start=a.get("start"),
+                step=a.get("step"),
+            )
+            for a in rec.get("accesses", [])
+        ],
+    )
+
+
+def load_loops(path: str) -> List[CfgLoop]:
+    """Load loop records (-public-data-loops) from a CFG NDJSON file."""
+    return [_parse_loop(rec) for rec in read_records(path) if rec.get("kind") == "loop"]
+
+
+def _pp_block(fn: str, pp: str) -> str:
+    """Block label of a "fn:bb:iN" program point."""
+    return pp[len(fn) + 1 :].rsplit(":", 1)[0]
+
+
+# (bbs, decisions, path_cond, path_cond_json, continues past the region exit)
+_Partial = Tuple[Tuple[str, ...], Tuple[PathDecision, ...], Tuple[str, ...], Tuple[dict, ...], bool]
+
+
+def compose_segment_paths(
+    fn: str,
+    regions: List[CfgRegion],
+    segments: List[CfgSegment],
+    limit: int | None = None,
+) -> List[CfgPath]:
+    """Compose per-region segments into whole-function CfgPath objects.
+
+    Each child-region element of a segment is replaced by every segment of
+    that region; a child segment that returns ends the whole path. Paths are
+    produced in segment order, deduplicated, and capped at `limit`.
+    """
+    segs_by_region: Dict[int, List[CfgSegment]] = {}
+    for seg in segments:
+        if seg.fn == fn:
+            segs_by_region.setdefault(seg.region_id, []).append(seg)
+    roots = [r for r in regions if r.fn == fn and r.parent is None]
+    if not roots:
+        return []
+
+    memo: Dict[int, List[_Partial]] = {}
+
+    def expand(region_id: int) -> List[_Partial]:
+        if region_id in memo:
+            return memo[region_id]
+        out: List[_Partial] = []
+        for seg in segs_by_region.get(region_id, []):
+            # Attach each decision to the block element whose terminator made
+            # it, so composed decisions stay in path order.
+            steps: List[Tuple[SegmentElem, int | None]] = []
+            di = 0
+            for elem in seg.elems:
+                own = None
+                if (
+                    elem.region is None
+                    and di < len(seg.decisions)
+                    and _pp_block(fn, seg.decisions[di].pp) == elem.bb
+                ):
+                    own = di
+                    di += 1
+                steps.append((elem, own))
+            partials: List[_Partial] = [((), (), (), (), True)]
+            for elem, own in steps:
+                nxt: List[_Partial] = []
+                for p in partials:
+                    if not p[4]:
+                        nxt.append(p)
+                    elif elem.region is None:
+                        decs, conds, conds_json = p[1], p[2], p[3]
+                        if own is not None:
+                            decs += (seg.decisions[own],)
+                            if own < len(seg.path_cond):
+                                conds += (seg.path_cond[own],)
+                            if own < len(seg.path_cond_json):
+                                conds_json += (seg.path_cond_json[own],)
+                        nxt.append((p[0] + (elem.bb,), decs, conds, conds_json, True))
+                    else:
+                        for c in expand(elem.region):
+                            nxt.append((p[0] + c[0], p[1] + c[1], p[2] + c[2], p[3] + c[3], c[4]))
+                partials = nxt
+                if limit is not None and len(partials) > limit:
+                    partials = partials[:limit]
+            for p in partials:
+                out.append(p if not p[4] else p[:4] + (seg.reaches_exit,))
+        memo[region_id] = out
+        return out
+
+    paths: List[CfgPath] = []
+    seen = set()
+    for bbs, decs, conds, conds_json, _cont in expand(roots[0].region_id):
+        key = (bbs, decs)
+        if key in seen:
+            continue
+        seen.add(key)
+        if limit is not None and len(paths) >= limit:
+            break
+        paths.append(
+            CfgPath(
+                fn=fn,
+                path_id=len(paths),
+                bbs=list(bbs),
+                decisions=list(decs),
+                path_cond=list(conds),
+                path_cond_json=list(conds_json),
+                pp_seq=[],
+            )
+        )
+    return paths
+
+
+def _parse_block_coverage(rec: dict) -> BlockCoverage:
+    ranges = PathIdRanges(rec.get("path_ranges", []))
+    return BlockCoverage(
+        fn=rec["fn"],
+        bb=rec["bb"],
+        pps=int(rec.get("pps", 0)),
+        path_count=int(rec.get("path_count", len(ranges))),
+        path_ids=ranges,
+    )
+
+
+def load_block_coverage(path: str) -> List[BlockCoverage]:
+    """Load block_coverage records (-public-data-pp-coverage-format=block)."""
+    return [
+        _parse_block_coverage(rec)
+        for rec in read_records(path)
+        if rec.get("kind") == "block_coverage"
+    ]
+
+
 def load_cfg(
     path: str,
 ) -> Tuple[List[CfgBlock], List[CfgEdge], List[CfgPath], List[PathSummary], List[PpCoverage]]:
-    """Load CFG/path records from a CFG NDJSON file."""
+    """Load CFG/path records from a CFG NDJSON file.
+
+    Trie-encoded paths (path_node + leaf-only path records) are materialized
+    into full CfgPath objects, so callers see the same shape either way.
+    Region-mode segments are composed into whole-function paths, capped at
+    the function's path_summary max_paths. block_coverage records become one
+    PpCoverage per pp in the block, all sharing the block's PathIdRanges.
+    """
     blocks: List[CfgBlock] = []
     edges: List[CfgEdge] = []
     paths: List[CfgPath] = []
     summaries: List[PathSummary] = []
     pp_cov: List[PpCoverage] = []
+    nodes: Dict[Tuple[str, int], PathNode] = {}
+    regions: List[CfgRegion] = []
+    segments: List[CfgSegment] = []
 
-    for rec in read_ndjson(path):
+    for rec in read_records(path):
         kind = rec.get("kind")
-        if kind == "block":
+        if kind == "region":
+            regions.append(_parse_region(rec))
+        elif kind == "segment":
+            segments.append(_parse_segment(rec))
+        elif kind == "path_node":
+            node = _parse_path_node(rec)
+            nodes[(node.fn, node.node_id)] = node
+        elif kind == "path" and "leaf" in rec:
+            paths.append(_path_from_nodes(rec, nodes))
+        elif kind == "block":
             blocks.append(
                 CfgBlock(
                     fn=rec["fn"],
@@ -148,20 +799,7 @@ def load_cfg(
                 )
             )
         elif kind == "path":
-            decs = []
-            for d in rec.get("decisions", []):
-                decs.append(
-                    PathDecision(
-                        pp=d["pp"],
-                        kind=d["kind"],
-                        succ=d["succ"],
-                        cond=d.get("cond"),
-                        sense=d.get("sense"),
-                        case=d.get("case"),
-                        is_default=bool(d.get("default", False)),
-                        target=d.get("target"),
-                    )
-                )
+            decs = [_parse_decision(d) for d in rec.get("decisions", [])]
             paths.append(
                 CfgPath(
                     fn=rec["fn"],
@@ -171,6 +809,9 @@ def load_cfg(
                     path_cond=list(rec.get("path_cond", [])),
                     path_cond_json=list(rec.get("path_cond_json", [])),
                     pp_seq=list(rec.get("pp_seq", [])),
+                    class_size=rec.get("class_size"),
+                    members=rec.get("members"),
+                    slice_pps=rec.get("slice_pps"),
                 )
             )
         elif kind == "path_summary":
@@ -188,11 +829,23 @@ def load_cfg(
                     const_pruned_br=rec.get("const_pruned_br"),
                     const_pruned_switch=rec.get("const_pruned_switch"),
                     const_pruned_indirect=rec.get("const_pruned_indirect"),
+                    corr_pruned_br=rec.get("corr_pruned_br"),
+                    corr_pruned_switch=rec.get("corr_pruned_switch"),
                     dfs_calls=rec.get("dfs_calls"),
                     dfs_leaves=rec.get("dfs_leaves"),
                     dfs_prune_max_paths=rec.get("dfs_prune_max_paths"),
                     dfs_prune_max_depth=rec.get("dfs_prune_max_depth"),
                     dfs_prune_loop=rec.get("dfs_prune_loop"),
+                    path_count_exact=rec.get("path_count_exact"),
+                    path_count_saturated=rec.get("path_count_saturated"),
+                    path_count_bound=rec.get("path_count_bound"),
+                    path_classes=rec.get("path_classes"),
+                    cutoff_time=rec.get("cutoff_time"),
+                    cutoff_mem=rec.get("cutoff_mem"),
+                    range_pruned=rec.get("range_pruned"),
+                    range_implied=rec.get("range_implied"),
+                    range_restored=rec.get("range_restored"),
+                    range_uncovered=rec.get("range_uncovered"),
                 )
             )
         elif kind == "pp_coverage":
@@ -205,6 +858,23 @@ def load_cfg(
                     truncated=bool(rec.get("truncated", False)),
                 )
             )
+        elif kind == "block_coverage":
+            # Every pp in the block shares the block's (uncapped) ranges.
+            cov = _parse_block_coverage(rec)
+            for k in range(cov.pps):
+                pp_cov.append(
+                    PpCoverage(
+                        fn=cov.fn,
+                        pp=f"{cov.fn}:{cov.bb}:i{k}",
+                        path_count=cov.path_count,
+                        path_ids=cov.path_ids,
+                        truncated=False,
+                    )
+                )
+    if segments:
+        limits = {s.fn: s.max_paths for s in summaries}
+        for fn in sorted({seg.fn for seg in segments}):
+            paths.extend(compose_segment_paths(fn, regions, segments, limits.get(fn)))
     return blocks, edges, paths, summaries, pp_cov
 
 
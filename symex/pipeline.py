@@ -3,10 +3,10 @@ from __future__ import annotations
 """Helpers to join trace instructions with CFG paths."""
 
 from dataclasses import dataclass
-from typing import Dict, List
+from typing import Dict, List, Sequence
 
-from .models import CfgBlock, CfgEdge, CfgPath, FuncSummary, PathSummary, PpCoverage, TraceInst, TraceIndex
-from .parser import load_func_summary, load_inputs, load_trace_index
+from .models import CalleeSummary, CfgBlock, CfgEdge, CfgLoop, CfgPath, FuncSummary, PathNode, PathSummary, PpCoverage, Shard, ShmFunction, TraceInst, TraceIndex
+from .parser import load_callee_summaries, load_func_summary, load_inputs, load_loops, load_path_nodes, load_trace_index
 
 
 @dataclass(frozen=True)
@@ -29,12 +29,17 @@ class FunctionPipeline:
     func_summary: FuncSummary | None
     pp_coverage: List[PpCoverage]
     trace_index: List[TraceIndex]
+    path_nodes: List[PathNode]
+    inst_by_pp: Dict[str, TraceInst]
+    loops: List[CfgLoop]
+    callee_summary: CalleeSummary | None
 
 
 def build_pipeline(
     trace_path: str,
     cfg_path: str,
     trace_index_path: str | None = None,
+    use_slices: bool = False,
 ) -> Dict[str, FunctionPipeline]:
     """Join trace and CFG data into per-function bundles.
 
@@ -42,11 +47,17 @@ def build_pipeline(
     - trace_path: trace NDJSON.
     - cfg_path: CFG/path NDJSON.
     - trace_index_path: optional trace index NDJSON.
+    - use_slices: restrict each path's instructions to its slice_pps when
+      the CFG carries them (-public-data-path-slice).
+    Each input may also be the records themselves as bytes (ShmFunction).
     Output:
     - Dict[fn -> FunctionPipeline]
     """
     inputs = load_inputs(trace_path, cfg_path)
     func_summaries = load_func_summary(cfg_path)
+    path_nodes = load_path_nodes(cfg_path)
+    loops = load_loops(cfg_path)
+    callee_summary_by_fn = {c.fn: c for c in load_callee_summaries(cfg_path)}
     trace_index: List[TraceIndex] = []
     if trace_index_path:
         trace_index = load_trace_index(trace_index_path)
@@ -77,6 +88,14 @@ def build_pipeline(
 
     func_summary_by_fn: Dict[str, FuncSummary] = {f.fn: f for f in func_summaries}
 
+    nodes_by_fn: Dict[str, List[PathNode]] = {}
+    for n in path_nodes:
+        nodes_by_fn.setdefault(n.fn, []).append(n)
+
+    loops_by_fn: Dict[str, List[CfgLoop]] = {}
+    for lp in loops:
+        loops_by_fn.setdefault(lp.fn, []).append(lp)
+
     out: Dict[str, FunctionPipeline] = {}
     fns = set(by_fn) | set(blocks_by_fn) | set(paths_by_fn)
     for fn in fns:
@@ -97,6 +116,9 @@ def build_pipeline(
             else:
                 for bb in p.bbs:
                     p_insts.extend(bb_insts.get(bb, []))
+            if use_slices and p.slice_pps is not None:
+                keep = set(p.slice_pps)
+                p_insts = [inst for inst in p_insts if inst.pp in keep]
             path_bundles.append(PathBundle(path=p, insts=p_insts))
 
         fn_index = [ti for ti in trace_index if ti.fn == fn]
@@ -111,9 +133,46 @@ def build_pipeline(
             func_summary=func_summary_by_fn.get(fn),
             pp_coverage=pp_cov_by_fn.get(fn, []),
             trace_index=fn_index,
+            path_nodes=nodes_by_fn.get(fn, []),
+            inst_by_pp=inst_by_pp,
+            loops=loops_by_fn.get(fn, []),
+            callee_summary=callee_summary_by_fn.get(fn),
         )
 
     return out
 
 
+def build_shard_pipeline(shard: Shard, use_slices: bool = False) -> Dict[str, FunctionPipeline]:
+    """build_pipeline over one shard's files (see parser.load_shard_manifest)."""
+    return build_pipeline(shard.trace, shard.cfg, shard.trace_index, use_slices=use_slices)
+
+
+def build_shm_pipeline(fn: ShmFunction, use_slices: bool = False) -> Dict[str, FunctionPipeline]:
+    """build_pipeline over one function read from a -public-data-shm ring."""
+    return build_pipeline(fn.trace, fn.cfg, fn.trace_index or None, use_slices=use_slices)
+
+
+def schedule_shards(shards: Sequence[Shard], workers: int) -> List[List[Shard]]:
+    """Balance shards over workers by estimated cost (Shard.cost).
+
+    Greedy longest-first: each shard, costliest first, goes to the worker
+    with the least cost so far. Returns one shard list per worker.
+    """
+    workers = max(1, workers)
+    plan: List[List[Shard]] = [[] for _ in range(workers)]
+    load = [0] * workers
+    for shard in sorted(shards, key=lambda s: (-s.cost, s.shard)):
+        w = min(range(workers), key=lambda i: (load[i], i))
+        plan[w].append(shard)
+        load[w] += shard.cost
+    return plan
+
+
+def path_node_insts(pipe: FunctionPipeline, node: PathNode) -> List[TraceInst]:
+    """Instructions contributed by one trie node (its block, pp_seq-ordered if present)."""
+    if node.pp_seq:
+        return [pipe.inst_by_pp[pp] for pp in node.pp_seq if pp in pipe.inst_by_pp]
+    return list(pipe.bb_insts.get(node.bb, []))
+
+
 # TODO(person B): Preserve instruction ordering across blocks when pp_seq missing.
@@ -3,7 +3,7 @@ from __future__ import annotations
 """Aggregation logic for publicness results."""
 
 from dataclasses import dataclass
-from typing import Dict, Iterable, List, Optional, Tuple
+from typing import Dict, Iterable, List, Optional, Sequence, Tuple
 
 from .models import CfgPath, PpCoverage
 
@@ -33,15 +33,20 @@ class PublicAtPoint:
 def _build_pp_paths(
     paths: List[CfgPath],
     pp_coverage: List[PpCoverage],
-) -> Dict[Tuple[str, str], Tuple[List[int], bool]]:
-    """Return mapping (fn, pp) -> (path_ids, truncated)."""
-    pp_paths: Dict[Tuple[str, str], Tuple[List[int], bool]] = {}
+) -> Dict[Tuple[str, str], Tuple[Sequence[int], bool]]:
+    """Return mapping (fn, pp) -> (path_ids, truncated).
+
+    Block coverage records keep their PathIdRanges, so pps in one block
+    share a single compressed id set.
+    """
+    pp_paths: Dict[Tuple[str, str], Tuple[Sequence[int], bool]] = {}
     if pp_coverage:
         for rec in pp_coverage:
-            pp_paths[(rec.fn, rec.pp)] = (list(rec.path_ids), rec.truncated)
+            pp_paths[(rec.fn, rec.pp)] = (rec.path_ids, rec.truncated)
         return pp_paths
 
     # Fallback: derive from path.pp_seq if available.
+    derived: Dict[Tuple[str, str], List[int]] = {}
     for p in paths:
         if p.path_id is None:
             continue
@@ -53,9 +58,9 @@ def _build_pp_paths(
             if key in seen:
                 continue
             seen.add(key)
-            ids, truncated = pp_paths.get(key, ([], False))
-            ids.append(p.path_id)
-            pp_paths[key] = (ids, truncated)
+            derived.setdefault(key, []).append(p.path_id)
+    for key, ids in derived.items():
+        pp_paths[key] = (ids, False)
     return pp_paths
 
 
@@ -0,0 +1,121 @@
+from __future__ import annotations
+
+"""Collect scripts/scaling_benchmarks.sh results into one CSV row per point."""
+
+import argparse
+import csv
+import glob
+import os
+import re
+from typing import Dict, List
+
+from .parser import load_perf, read_records
+
+# Source stems written by scaling_benchmarks.sh: <shape>_<size>_d<density>.
+_STEM_RE = re.compile(r"^(?P<shape>[a-z]+)_(?P<size>\d+)_d(?P<density>[0-9.]+)$")
+
+_FIELDS = [
+    "source",
+    "shape",
+    "size",
+    "tx_density",
+    "fn",
+    "elapsed_ms",
+    "elapsed_runs",
+    "max_rss_kb",
+    "total_ns",
+    "path_count_ns",
+    "paths_ns",
+    "inst_count",
+    "bb_count",
+    "tx_count",
+    "paths_emitted",
+    "truncated",
+    "dfs_calls",
+    "dfs_prune_max_paths",
+    "path_count_exact",
+    "trace_bytes",
+    "cfg_bytes",
+    "coverage_ranges_peak",
+    "value_ids_peak",
+]
+
+
+def _run_summary(path: str) -> dict:
+    """Return the run_summary record next to a CFG file, if any."""
+    if not os.path.exists(path):
+        return {}
+    for rec in read_records(path):
+        if rec.get("kind") == "run_summary":
+            return rec
+    return {}
+
+
+def _collect_rows(cfg_path: str) -> List[dict]:
+    """Build one row per function of a scaling point's CFG file."""
+    stem = os.path.basename(cfg_path)[: -len(".cfg.ndjson")]
+    m = _STEM_RE.match(stem)
+    run = _run_summary(os.path.join(os.path.dirname(cfg_path), f"{stem}.run_summary.ndjson"))
+    by_fn: Dict[str, dict] = {}
+
+    def row(fn: str) -> dict:
+        return by_fn.setdefault(
+            fn,
+            {
+                "source": stem,
+                "shape": m.group("shape") if m else None,
+                "size": int(m.group("size")) if m else None,
+                "tx_density": float(m.group("density")) if m else None,
+                "fn": fn,
+                "elapsed_ms": run.get("elapsed_ms"),
+                "elapsed_runs": run.get("elapsed_runs"),
+                "max_rss_kb": run.get("max_rss_kb"),
+            },
+        )
+
+    for rec in read_records(cfg_path):
+        kind = rec.get("kind")
+        if kind == "func_summary":
+            r = row(rec["fn"])
+            for key in ("inst_count", "bb_count", "tx_count"):
+                r[key] = rec.get(key)
+        elif kind == "path_summary":
+            r = row(rec["fn"])
+            for key in ("paths_emitted", "truncated", "dfs_calls", "dfs_prune_max_paths", "path_count_exact"):
+                r[key] = rec.get(key)
+    for p in load_perf(cfg_path):
+        r = row(p.fn)
+        r["total_ns"] = p.total_ns
+        r["path_count_ns"] = p.phase_ns.get("path_count")
+        r["paths_ns"] = p.phase_ns.get("paths")
+        r["trace_bytes"] = p.stream_bytes.get("trace")
+        r["cfg_bytes"] = p.stream_bytes.get("cfg")
+        r["coverage_ranges_peak"] = p.coverage_ranges
+        r["value_ids_peak"] = p.value_ids_peak
+    return list(by_fn.values())
+
+
+def main() -> int:
+    """CLI entry point for the scaling CSV."""
+    parser = argparse.ArgumentParser(
+        description="Collect scaling sweep results (perf + run_summary) into CSV."
+    )
+    parser.add_argument("--dir", required=True, help="scaling_benchmarks.sh output directory")
+    parser.add_argument("--out", required=True, help="Output CSV file")
+    args = parser.parse_args()
+
+    rows: List[dict] = []
+    for cfg_path in sorted(glob.glob(os.path.join(args.dir, "*.cfg.ndjson"))):
+        rows.extend(_collect_rows(cfg_path))
+    rows.sort(key=lambda r: (r["shape"] or "", r["tx_density"] or 0.0, r["size"] or 0, r["fn"]))
+
+    with open(args.out, "w", newline="", encoding="utf-8") as f:
+        writer = csv.DictWriter(f, fieldnames=_FIELDS)
+        writer.writeheader()
+        for r in rows:
+            writer.writerow(r)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
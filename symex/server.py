@@ -0,0 +1,110 @@
+from __future__ import annotations
+
+"""Client for `ct-trace -serve` (persistent path/trace server)."""
+
+import json
+import subprocess
+from typing import List, Optional, Sequence, Tuple
+
+from .models import TraceInst
+from .parser import parse_trace_inst, resolve_records
+
+
+class ServerError(RuntimeError):
+    """A server_error record answered a request."""
+
+
+class TraceServer:
+    """One `ct-trace -serve` process over a set of .ll/.bc inputs.
+
+    Requests are answered in order; each call blocks until its
+    server_done record. Returned records have interned ids and cond ids
+    resolved, as read_records() does for files.
+    """
+
+    def __init__(self, inputs: Sequence[str], ct_trace: str = "ct-trace", flags: Sequence[str] = ()):
+        self.proc = subprocess.Popen(
+            [ct_trace, "-serve", *flags, *inputs],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            text=True,
+        )
+        self._next_id = 0
+
+    def request(self, op: str, **fields: object) -> Tuple[List[dict], dict]:
+        """Send one request; return its records and its server_done record."""
+        self._next_id += 1
+        req = {"id": self._next_id, "op": op, **{k: v for k, v in fields.items() if v is not None}}
+        self.proc.stdin.write(json.dumps(req, separators=(",", ":")) + "\n")
+        self.proc.stdin.flush()
+        records: List[dict] = []
+        for line in self.proc.stdout:
+            rec = json.loads(line)
+            kind = rec.get("kind")
+            if kind == "server_error":
+                raise ServerError(rec.get("error", ""))
+            if kind == "server_done":
+                return list(resolve_records(records)), rec
+            records.append(rec)
+        raise ServerError("ct-trace -serve exited")
+
+    def functions(self) -> List[dict]:
+        """server_fn records: module, fn and inst_count per defined function."""
+        return self.request("functions")[0]
+
+    def paths(
+        self,
+        fn: str,
+        start: int,
+        count: int,
+        module: Optional[str] = None,
+        max_path_depth: Optional[int] = None,
+        max_loop_iters: Optional[int] = None,
+    ) -> Tuple[List[dict], bool]:
+        """Path records start..start+count-1 of fn (with the cond/path_node
+        records they use and path_summary), and whether more paths follow."""
+        records, done = self.request(
+            "paths",
+            fn=fn,
+            start=start,
+            count=count,
+            module=module,
+            max_path_depth=max_path_depth,
+            max_loop_iters=max_loop_iters,
+        )
+        return records, bool(done.get("more", False))
+
+    def enumerate(
+        self,
+        fn: str,
+        module: Optional[str] = None,
+        max_paths: Optional[int] = None,
+        max_path_depth: Optional[int] = None,
+        max_loop_iters: Optional[int] = None,
+    ) -> List[dict]:
+        """Every CFG record of fn, re-enumerated under the given limits."""
+        return self.request(
+            "enumerate",
+            fn=fn,
+            module=module,
+            max_paths=max_paths,
+            max_path_depth=max_path_depth,
+            max_loop_iters=max_loop_iters,
+        )[0]
+
+    def slice(self, fn: str, pps: Sequence[str], module: Optional[str] = None) -> List[TraceInst]:
+        """Trace instructions of fn at the given pps, in trace order."""
+        records = self.request("slice", fn=fn, pps=list(pps), module=module)[0]
+        return [parse_trace_inst(rec) for rec in records]
+
+    def close(self) -> None:
+        if self.proc.poll() is None:
+            self.request("quit")
+            self.proc.stdin.close()
+        self.proc.wait()
+
+    def __enter__(self) -> TraceServer:
+        return self
+
+    def __exit__(self, *exc: object) -> None:
+        self.close()
@@ -0,0 +1,175 @@
+from __future__ import annotations
+
+"""Reader for the -public-data-shm ring of completed functions.
+
+Mirrors llvm-pass/ShmRing.h. The pass (or ct-trace) publishes each
+function once it is rendered; iterating a ShmReader yields them as
+ShmFunctions in commit order, so analysis of one function overlaps the
+rendering of the next. There is one reader per ring: to spread functions
+over workers, hand them to a pool from the reading process, e.g.
+
+    with ShmReader("ct-trace") as ring:
+        for result in pool.imap(analyze, ring):
+            ...
+
+with analyze building its pipeline via pipeline.build_shm_pipeline().
+"""
+
+import mmap
+import os
+import struct
+import time
+from typing import Iterator, Optional
+
+from .models import ShmFunction
+
+MAGIC = b"CTPSHM01"
+VERSION = 1
+FLAG_COLUMNAR = 1
+
+FUNCTION = 1
+COLUMNAR_HEADER = 2
+PAD = 3
+
+_HEADER = 64
+_MESSAGE_HEADER = 48
+_HEAD, _TAIL, _CLOSED, _FLAGS, _FUNCTIONS, _DROPPED = 24, 32, 40, 44, 48, 56
+
+
+def _shm_path(name: str) -> str:
+    return "/dev/shm/" + name.lstrip("/")
+
+
+class ShmReader:
+    """Attach to a ring by its -public-data-shm name.
+
+    The reader may start before the producer: attaching waits up to
+    attach_timeout seconds for the region to appear. Iteration ends once
+    the producer has closed the ring and every function has been read.
+    Integers are in host byte order, like the producer's.
+    """
+
+    def __init__(self, name: str, attach_timeout: float = 30.0, poll: float = 0.001):
+        self.name = name
+        self.poll = poll
+        self._map = self._attach(attach_timeout)
+        self.capacity = self._u64(16)
+        self.flags = self._u32(_FLAGS)
+        self.columnar_header: Optional[bytes] = None
+
+    def _attach(self, timeout: float) -> mmap.mmap:
+        deadline = time.monotonic() + timeout
+        while True:
+            try:
+                fd = os.open(_shm_path(self.name), os.O_RDWR)
+            except FileNotFoundError:
+                fd = -1
+            if fd >= 0:
+                try:
+                    size = os.fstat(fd).st_size
+                    if size >= _HEADER:
+                        m = mmap.mmap(fd, size)
+                        if m[:8] == MAGIC:
+                            version = struct.unpack_from("=I", m, 8)[0]
+                            if version > VERSION:
+                                m.close()
+                                raise ValueError(
+                                    f"shm ring version {version} is newer than supported version {VERSION}; update symex"
+                                )
+                            return m
+                        m.close()
+                finally:
+                    os.close(fd)
+            if time.monotonic() >= deadline:
+                raise TimeoutError(f"no -public-data-shm ring named {self.name}")
+            time.sleep(self.poll)
+
+    def _u32(self, offset: int) -> int:
+        return struct.unpack_from("=I", self._map, offset)[0]
+
+    def _u64(self, offset: int) -> int:
+        return struct.unpack_from("=Q", self._map, offset)[0]
+
+    @property
+    def columnar(self) -> bool:
+        return bool(self.flags & FLAG_COLUMNAR)
+
+    @property
+    def published(self) -> int:
+        """Functions the producer has published so far."""
+        return self._u64(_FUNCTIONS)
+
+    @property
+    def dropped(self) -> int:
+        """Functions the producer dropped (too large, or wait expired)."""
+        return self._u64(_DROPPED)
+
+    def _next_message(self) -> Optional[tuple]:
+        """Block for the next message; None once the ring is closed and drained."""
+        m = self._map
+        while True:
+            tail = self._u64(_TAIL)
+            # closed is read before head: a head published before close is seen.
+            closed = self._u32(_CLOSED)
+            head = self._u64(_HEAD)
+            if head == tail:
+                if closed:
+                    return None
+                time.sleep(self.poll)
+                continue
+            pos = tail % self.capacity
+            if self.capacity - pos < _MESSAGE_HEADER:
+                struct.pack_into("=Q", m, _TAIL, tail + self.capacity - pos)
+                continue
+            at = _HEADER + pos
+            kind, _, size = struct.unpack_from("=IIQ", m, at)
+            if kind == PAD:
+                struct.pack_into("=Q", m, _TAIL, tail + size)
+                continue
+            module_len, fn_len, trace_len, index_len, cfg_len = struct.unpack_from("=IIQQQ", m, at + 16)
+            at += _MESSAGE_HEADER
+            parts = []
+            for n in (module_len, fn_len, trace_len, index_len, cfg_len):
+                parts.append(m[at : at + n])
+                at += n
+            struct.pack_into("=Q", m, _TAIL, tail + size)
+            return (kind, *parts)
+
+    def __iter__(self) -> Iterator[ShmFunction]:
+        while True:
+            msg = self._next_message()
+            if msg is None:
+                return
+            kind, module, fn, trace, trace_index, cfg = msg
+            if kind == COLUMNAR_HEADER:
+                self.columnar_header = trace
+                continue
+            if kind != FUNCTION:
+                continue
+            if self.columnar:
+                trace = (self.columnar_header or b"") + trace
+            yield ShmFunction(
+                module=module.decode("utf-8"),
+                fn=fn.decode("utf-8"),
+                trace=trace,
+                trace_index=trace_index,
+                cfg=cfg,
+            )
+
+    def close(self, unlink: bool = True) -> None:
+        """Unmap the ring; by default also remove it once the producer is done."""
+        if self._map.closed:
+            return
+        closed = self._u32(_CLOSED)
+        self._map.close()
+        if unlink and closed:
+            try:
+                os.unlink(_shm_path(self.name))
+            except FileNotFoundError:
+                pass
+
+    def __enter__(self) -> ShmReader:
+        return self
+
+    def __exit__(self, *exc: object) -> None:
+        self.close()
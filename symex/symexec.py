@@ -10,9 +10,9 @@ point for Person B to extend.
 import hashlib
 import time
 from dataclasses import dataclass
-from typing import TYPE_CHECKING, Dict, List, Optional, Sequence, Tuple
+from typing import TYPE_CHECKING, Callable, Dict, List, Optional, Sequence, Tuple
 
-from .models import TraceInst
+from .models import CalleeSummary, PathNode, TraceInst
 from .publicness import PathPublicness
 from .solver import Z3Solver
 
@@ -42,6 +42,8 @@ class PathAnalysisSummary:
     solver_time_ms: float
     cache_hits: int
     cache_misses: int
+    # Defs the pass proved equal across executions, answered without a query.
+    static_count: int = 0
 
 
 def _parse_ty_width(ty: Optional[str], ptr_width: int) -> int:
@@ -167,6 +169,26 @@ class SymExecEngine:
             return fallback
         return fallback
 
+    def _reaching_store(self, state: SymState, inst: TraceInst) -> Optional[object]:
+        """Value written by the access's reaching MemoryDef, if it must alias.
+
+        With -public-data-mem-ssa every memory access names its clobbering
+        def and must-alias class. When that def ran earlier on this path and
+        shares the class, its last write is what the access reads, whatever
+        the address expressions look like. Otherwise callers fall back to
+        the address-keyed memory.
+        """
+        if inst.mem_def is None or inst.mem_class is None:
+            return None
+        rec = state.mem.get(f"memdef:{inst.mem_def}")
+        if rec is None or rec[0] != inst.mem_class:
+            return None
+        return rec[1]
+
+    def _record_store(self, state: SymState, inst: TraceInst, val: object) -> None:
+        if inst.mem_class is not None:
+            state.mem[f"memdef:{inst.pp}"] = (inst.mem_class, val)
+
     def _neq_expr(self, z3, lhs: object, rhs: object) -> Optional[object]:
         if isinstance(lhs, tuple) and isinstance(rhs, tuple) and len(lhs) == len(rhs):
             terms = []
@@ -249,6 +271,40 @@ class SymExecEngine:
                 return False
         return True
 
+    def _callee_summary(self, callee: Optional[str]) -> Optional[CalleeSummary]:
+        pipe = self.function_pipelines.get(callee) if callee else None
+        return pipe.callee_summary if pipe is not None else None
+
+    def _eval_summarized_call(
+        self,
+        z3,
+        inst: TraceInst,
+        summary: CalleeSummary,
+        state: SymState,
+        get_op: Callable[[int], object],
+        def_width: int,
+    ) -> Optional[object]:
+        """Apply a callee summary instead of inlining the callee.
+
+        A callee that may write memory invalidates everything this state
+        knows about memory. A memory-independent return value becomes an
+        uninterpreted function of the arguments it depends on, shared by
+        both executions, so it is equal whenever those arguments are.
+        """
+        if summary.writes_other or summary.writes_args:
+            state.mem.clear()
+        if not inst.def_id or summary.ret_reads_mem:
+            return None
+        args = [get_op(k) for k in summary.arg_ret if k < len(inst.uses)]
+        if not all(z3.is_bv(a) for a in args):
+            return None
+        widths = "_".join(str(a.size()) for a in args)
+        name = f"summary_{inst.callee}_{def_width}_{widths}"
+        if not args:
+            return z3.BitVec(name, def_width)
+        fn = z3.Function(name, *[a.sort() for a in args], z3.BitVecSort(def_width))
+        return fn(*args)
+
     def _eval_direct_callee(
         self,
         z3,
@@ -473,7 +529,10 @@ class SymExecEngine:
             ptr_expr = get_op(0)
             ptr_id = inst.uses[0] if inst.uses else "unknown_ptr"
             mem_key = self._mem_key(z3, ptr_expr, ptr_id)
-            if mem_key in state.mem:
+            val = self._reaching_store(state, inst)
+            if val is not None:
+                state.mem[mem_key] = val
+            elif mem_key in state.mem:
                 val = state.mem[mem_key]
             else:
                 val = self._fresh(z3, state, f"load_{exec_tag}_{ptr_id}", def_width)
@@ -487,12 +546,15 @@ class SymExecEngine:
                 ptr_expr = get_op(1)
                 ptr_id = inst.uses[1]
                 state.mem[self._mem_key(z3, ptr_expr, ptr_id)] = val
+                self._record_store(state, inst, val)
             return None
         if op == "atomicrmw":
             ptr_expr = get_op(0)
             ptr_id = inst.uses[0] if inst.uses else "unknown_ptr"
             mem_key = self._mem_key(z3, ptr_expr, ptr_id)
-            old = state.mem.get(mem_key)
+            old = self._reaching_store(state, inst)
+            if old is None:
+                old = state.mem.get(mem_key)
             if old is None:
                 old = self._fresh(z3, state, f"atomic_old_{exec_tag}_{ptr_id}", def_width)
             if len(inst.uses) >= 2:
@@ -516,6 +578,7 @@ class SymExecEngine:
                 else:
                     new = self._fresh(z3, state, f"atomic_new_{exec_tag}_{ptr_id}", def_width)
                 state.mem[mem_key] = _as_bv(z3, new, def_width)
+                self._record_store(state, inst, state.mem[mem_key])
             if def_id:
                 state.env[def_id] = old
             return old
@@ -523,7 +586,9 @@ class SymExecEngine:
             ptr_expr = get_op(0)
             ptr_id = inst.uses[0] if inst.uses else "unknown_ptr"
             mem_key = self._mem_key(z3, ptr_expr, ptr_id)
-            old = state.mem.get(mem_key)
+            old = self._reaching_store(state, inst)
+            if old is None:
+                old = state.mem.get(mem_key)
             if old is None:
                 old = self._fresh(z3, state, f"cmpxchg_old_{exec_tag}_{ptr_id}", def_width)
             if len(inst.uses) >= 3:
@@ -532,6 +597,7 @@ class SymExecEngine:
                 cur = _as_bv(z3, old, def_width)
                 success = cur == cmp_val
                 state.mem[mem_key] = z3.If(success, new_val, cur)
+                self._record_store(state, inst, state.mem[mem_key])
             else:
                 success = z3.BoolVal(False)
             if def_id:
@@ -717,6 +783,13 @@ class SymExecEngine:
                     if def_id:
                         state.env[def_id] = expr
                     return expr
+            summary = self._callee_summary(inst.callee)
+            if summary is not None:
+                expr = self._eval_summarized_call(z3, inst, summary, state, get_op, def_width)
+                if expr is not None:
+                    if def_id:
+                        state.env[def_id] = expr
+                    return expr
             if def_id:
                 state.env[def_id] = self._fresh(z3, state, f"call_{exec_tag}", def_width)
             return None
@@ -728,6 +801,41 @@ class SymExecEngine:
             return expr
         return None
 
+    def _step_inst(
+        self,
+        z3,
+        inst: TraceInst,
+        state_a: SymState,
+        state_b: SymState,
+        prev_bb: Optional[str],
+        tx_equalities: List[object],
+    ) -> None:
+        """Execute one instruction on both states and collect transmitter equalities."""
+        self._eval_inst(z3, inst, state_a, "A", prev_bb, callstack=(inst.fn,))
+        self._eval_inst(z3, inst, state_b, "B", prev_bb, callstack=(inst.fn,))
+        for tx in inst.txs:
+            if tx.which >= len(inst.uses):
+                continue
+            op_id = inst.uses[tx.which]
+            op_width = self.ptr_width
+            if inst.use_tys and tx.which < len(inst.use_tys):
+                op_width = _parse_ty_width(inst.use_tys[tx.which], self.ptr_width)
+            a_expr = self._eval_operand(z3, state_a, op_id, op_width)
+            b_expr = self._eval_operand(z3, state_b, op_id, op_width)
+            tx_equalities.append(a_expr == b_expr)
+        # Arguments a summarized callee always transmits are public too.
+        summary = self._callee_summary(inst.callee) if inst.op in ("call", "invoke") else None
+        if summary is not None:
+            for k in summary.arg_tx_must:
+                if k >= len(inst.uses):
+                    continue
+                op_width = self.ptr_width
+                if inst.use_tys and k < len(inst.use_tys):
+                    op_width = _parse_ty_width(inst.use_tys[k], self.ptr_width)
+                a_expr = self._eval_operand(z3, state_a, inst.uses[k], op_width)
+                b_expr = self._eval_operand(z3, state_b, inst.uses[k], op_width)
+                tx_equalities.append(a_expr == b_expr)
+
     def analyze_path(
         self,
         path_id: int,
@@ -736,6 +844,55 @@ class SymExecEngine:
         path_conditions_json: Sequence[dict] = (),
     ) -> Tuple[List[PathPublicness], PathAnalysisSummary]:
         """Run dual execution for a single path and emit publicness results."""
+        solver, z3, state_a, state_b = self._run_path(
+            insts, path_conditions, path_conditions_json
+        )
+        return self._query_defs(solver, z3, state_a, state_b, path_id, insts)
+
+    def analyze_values(
+        self,
+        insts: List[TraceInst],
+        path_conditions: Sequence[str],
+        path_conditions_json: Sequence[dict],
+        values: Sequence[str],
+    ) -> Dict[str, Optional[bool]]:
+        """Run a path like analyze_path, then query the given value ids.
+
+        Unlike analyze_path this also covers arguments and other values the
+        path reads but does not define; ids it never touches map to None.
+        """
+        solver, z3, state_a, state_b = self._run_path(
+            insts, path_conditions, path_conditions_json
+        )
+        out: Dict[str, Optional[bool]] = {}
+        for value in values:
+            a_expr = state_a.env.get(value)
+            b_expr = state_b.env.get(value)
+            diff_expr = None
+            if a_expr is not None and b_expr is not None:
+                diff_expr = self._neq_expr(z3, a_expr, b_expr)
+            if diff_expr is None:
+                out[value] = None
+                continue
+            solver.solver().push()
+            solver.add_expr(diff_expr)
+            check_res = solver.solver().check()
+            solver.solver().pop()
+            if check_res == z3.sat:
+                out[value] = True
+            elif check_res == z3.unsat:
+                out[value] = False
+            else:
+                out[value] = None
+        return out
+
+    def _run_path(
+        self,
+        insts: List[TraceInst],
+        path_conditions: Sequence[str],
+        path_conditions_json: Sequence[dict],
+    ) -> Tuple[Z3Solver, object, SymState, SymState]:
+        """Execute insts on both states and assert path and transmitter constraints."""
         solver = Z3Solver()
         z3 = solver.z3()
 
@@ -750,18 +907,7 @@ class SymExecEngine:
             if inst.bb != current_bb:
                 prev_bb = current_bb
                 current_bb = inst.bb
-            self._eval_inst(z3, inst, state_a, "A", prev_bb, callstack=(inst.fn,))
-            self._eval_inst(z3, inst, state_b, "B", prev_bb, callstack=(inst.fn,))
-            for tx in inst.txs:
-                if tx.which >= len(inst.uses):
-                    continue
-                op_id = inst.uses[tx.which]
-                op_width = self.ptr_width
-                if inst.use_tys and tx.which < len(inst.use_tys):
-                    op_width = _parse_ty_width(inst.use_tys[tx.which], self.ptr_width)
-                a_expr = self._eval_operand(z3, state_a, op_id, op_width)
-                b_expr = self._eval_operand(z3, state_b, op_id, op_width)
-                tx_equalities.append(a_expr == b_expr)
+            self._step_inst(z3, inst, state_a, state_b, prev_bb, tx_equalities)
 
         # Path constraints must hold for each execution separately.
         self._add_path_conditions(
@@ -780,7 +926,94 @@ class SymExecEngine:
         )
         for eq in tx_equalities:
             solver.add_expr(eq)
+        return solver, z3, state_a, state_b
 
+    def analyze_path_trie(
+        self,
+        nodes: Sequence[PathNode],
+        leaves: Dict[int, int],
+        node_insts: Callable[[PathNode], List[TraceInst]],
+    ) -> List[Tuple[List[PathPublicness], PathAnalysisSummary]]:
+        """Run dual execution over a trie of path prefixes.
+
+        Each node's block is executed once on copies of its parent's states,
+        and its edge condition and transmitter equalities are pushed in a
+        solver scope shared by every path below it. Leaves (node_id ->
+        path_id) run the per-path publicness queries. Unlike analyze_path,
+        edge conditions are evaluated in the state at the branch, so values
+        redefined by later loop iterations do not leak into earlier edges.
+        """
+        solver = Z3Solver()
+        z3 = solver.z3()
+        children: Dict[Optional[int], List[PathNode]] = {}
+        for node in nodes:
+            children.setdefault(node.parent, []).append(node)
+
+        out: List[Tuple[List[PathPublicness], PathAnalysisSummary]] = []
+        root_a = SymState(tag="A", env={}, mem={}, fresh_id=0)
+        root_b = SymState(tag="B", env={}, mem={}, fresh_id=0)
+        # Work items: (node, parent states, parent bb, prefix insts) or None
+        # to close the solver scope opened by the matching node.
+        stack: List[object] = [
+            (n, root_a, root_b, None, []) for n in reversed(children.get(None, []))
+        ]
+        while stack:
+            item = stack.pop()
+            if item is None:
+                solver.solver().pop()
+                continue
+            node, parent_a, parent_b, parent_bb, prefix = item
+            state_a = SymState(
+                tag="A", env=dict(parent_a.env), mem=dict(parent_a.mem),
+                fresh_id=parent_a.fresh_id,
+            )
+            state_b = SymState(
+                tag="B", env=dict(parent_b.env), mem=dict(parent_b.mem),
+                fresh_id=parent_b.fresh_id,
+            )
+            solver.solver().push()
+            stack.append(None)
+
+            conds = [node.path_cond] if node.path_cond is not None else []
+            conds_json = [node.path_cond_json] if node.path_cond_json is not None else []
+            if conds or conds_json:
+                for state in (state_a, state_b):
+                    self._add_path_conditions(
+                        solver=solver,
+                        z3=z3,
+                        state=state,
+                        path_conditions=conds,
+                        path_conditions_json=conds_json,
+                    )
+
+            insts = node_insts(node)
+            tx_equalities: List[object] = []
+            for inst in insts:
+                self._step_inst(z3, inst, state_a, state_b, parent_bb, tx_equalities)
+            for eq in tx_equalities:
+                solver.add_expr(eq)
+
+            path_insts = prefix + insts
+            if node.node_id in leaves:
+                out.append(
+                    self._query_defs(
+                        solver, z3, state_a, state_b, leaves[node.node_id], path_insts
+                    )
+                )
+            for child in reversed(children.get(node.node_id, [])):
+                stack.append((child, state_a, state_b, node.bb, path_insts))
+        return out
+
+    def _query_defs(
+        self,
+        solver: Z3Solver,
+        z3,
+        state_a: SymState,
+        state_b: SymState,
+        path_id: int,
+        insts: List[TraceInst],
+    ) -> Tuple[List[PathPublicness], PathAnalysisSummary]:
+        """Check A != B for every def on the path under the current assertions."""
         results: List[PathPublicness] = []
         query_count = 0
         sat_count = 0
@@ -788,12 +1021,26 @@ class SymExecEngine:
         unknown_count = 0
         cache_hits = 0
         cache_misses = 0
+        static_count = 0
         solver_time_ms = 0.0
         base_key = hashlib.sha256(solver.solver().sexpr().encode("utf-8")).hexdigest()
 
         for inst in insts:
             if not inst.def_id:
                 continue
+            if inst.def_static == "equal":
+                # A != B is unsat for a def the pass proved equal.
+                static_count += 1
+                results.append(
+                    PathPublicness(
+                        fn=inst.fn,
+                        path_id=path_id,
+                        pp=inst.pp,
+                        value=inst.def_id,
+                        public=False,
+                    )
+                )
+                continue
             query_count += 1
             a_expr = state_a.env.get(inst.def_id)
             b_expr = state_b.env.get(inst.def_id)
@@ -875,6 +1122,7 @@ class SymExecEngine:
             solver_time_ms=solver_time_ms,
             cache_hits=cache_hits,
             cache_misses=cache_misses,
+            static_count=static_count,
         )
         return results, summary
 
@@ -2,11 +2,14 @@ from __future__ import annotations
 
 """Trace index lookup helpers."""
 
+import json
+import mmap
+import struct
 from dataclasses import dataclass
-from typing import Dict, Optional
+from typing import Dict, List, Optional, Tuple
 
-from .models import TraceIndex
-from .parser import load_trace_index
+from .models import TraceIndex, TraceInst
+from .parser import load_trace_index, open_output, parse_trace_inst, resolve_records
 
 
 @dataclass(frozen=True)
@@ -30,3 +33,148 @@ def build_trace_index_lookup(path: str) -> TraceIndexLookup:
     by_pp = {e.pp: e for e in entries}
     by_line = {e.line: e for e in entries}
     return TraceIndexLookup(by_pp=by_pp, by_line=by_line)
+
+
+_BIN_MAGIC = b"CTPIDX01"
+_BIN_VERSION = 2
+_BIN_FLAG_ZSTD = 1
+_BIN_HEADER = struct.Struct("<8sIIIIQQ")
+_BIN_ENTRY = struct.Struct("<IIQI")
+_BIN_FN = struct.Struct("<QQQIQII")
+
+
+@dataclass(frozen=True)
+class BinaryIndexFunction:
+    """Function table entry of a binary trace index."""
+    fn_id: int
+    name: str
+    frame_offset: int
+    frame_base: int
+    symtab_offset: int
+    symtab_length: int
+    first_entry: int
+    entry_count: int
+
+
+class BinaryTraceIndex:
+    """mmap-backed reader for -public-data-trace-index-bin files.
+
+    Entries are fixed-size and sorted by (fn_id, pp_id), so lookups are a
+    binary search over the mapped file; nothing is parsed up front except
+    the function table.
+    """
+
+    def __init__(self, path: str) -> None:
+        self._file = open(path, "rb")
+        try:
+            self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        except ValueError:
+            # Empty files cannot be mapped.
+            self._file.close()
+            raise ValueError(f"{path}: not a binary trace index")
+        magic, version, flags, fn_count, _, self.entry_count, fn_table = _BIN_HEADER.unpack_from(self._map, 0)
+        if magic != _BIN_MAGIC or version != _BIN_VERSION:
+            self.close()
+            raise ValueError(f"{path}: not a binary trace index (version {_BIN_VERSION})")
+        self.compressed = bool(flags & _BIN_FLAG_ZSTD)
+        self.functions: Dict[str, BinaryIndexFunction] = {}
+        off = fn_table
+        for fn_id in range(fn_count):
+            frame_off, frame_base, sym_off, sym_len, first, count, name_len = _BIN_FN.unpack_from(self._map, off)
+            off += _BIN_FN.size
+            name = self._map[off:off + name_len].decode("utf-8")
+            off += name_len
+            self.functions[name] = BinaryIndexFunction(
+                fn_id=fn_id,
+                name=name,
+                frame_offset=frame_off,
+                frame_base=frame_base,
+                symtab_offset=sym_off,
+                symtab_length=sym_len,
+                first_entry=first,
+                entry_count=count,
+            )
+
+    def close(self) -> None:
+        """Unmap and close the index file."""
+        self._map.close()
+        self._file.close()
+
+    def __enter__(self) -> "BinaryTraceIndex":
+        return self
+
+    def __exit__(self, *exc: object) -> None:
+        self.close()
+
+    def _entry(self, i: int) -> Tuple[int, int, int, int]:
+        return _BIN_ENTRY.unpack_from(self._map, _BIN_HEADER.size + i * _BIN_ENTRY.size)
+
+    def entries(self, fn: str) -> List[Tuple[int, int, int]]:
+        """Return (pp_id, offset, length) for every trace record of fn.
+
+        Offsets are positions in the decoded trace; for a compressed trace,
+        decode from the function's frame_offset and skip
+        offset - frame_base bytes.
+        """
+        info = self.functions.get(fn)
+        if info is None:
+            return []
+        out = []
+        for i in range(info.first_entry, info.first_entry + info.entry_count):
+            _, pp, off, length = self._entry(i)
+            out.append((pp, off, length))
+        return out
+
+    def lookup(self, fn: str, pp_id: int) -> Optional[Tuple[int, int]]:
+        """Return the (offset, length) of fn's trace record for pp_id."""
+        info = self.functions.get(fn)
+        if info is None:
+            return None
+        lo, hi = info.first_entry, info.first_entry + info.entry_count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            _, pp, off, length = self._entry(mid)
+            if pp == pp_id:
+                return off, length
+            if pp < pp_id:
+                lo = mid + 1
+            else:
+                hi = mid
+        return None
+
+    def function_span(self, fn: str) -> Optional[Tuple[int, int]]:
+        """Return the (offset, length) covering all of fn's trace records.
+
+        The span excludes the symtab record, which precedes it when ids are
+        interned.
+        """
+        info = self.functions.get(fn)
+        if info is None or info.entry_count == 0:
+            return None
+        _, _, first_off, _ = self._entry(info.first_entry)
+        end = first_off
+        for i in range(info.first_entry, info.first_entry + info.entry_count):
+            _, _, off, length = self._entry(i)
+            end = max(end, off + length)
+        return first_off, end - first_off
+
+
+def read_function_trace(trace_path: str, index: BinaryTraceIndex, fn: str) -> List[TraceInst]:
+    """Load one function's TraceInst records by seeking into the trace file.
+
+    Compressed traces are decoded from the start of the function's zstd
+    frame only, never from the start of the file.
+    """
+    info = index.functions.get(fn)
+    span = index.function_span(fn)
+    if info is None or span is None:
+        return []
+    start = info.symtab_offset if info.symtab_length else span[0]
+    end = span[0] + span[1]
+    with open_output(trace_path, info.frame_offset) as f:
+        skip = start - info.frame_base
+        if skip and len(f.read(skip)) != skip:
+            return []
+        data = f.read(end - start)
+    records = (json.loads(line) for line in data.splitlines() if line.strip())
+    return [parse_trace_inst(rec) for rec in resolve_records(records)]